@@ -132,5 +132,10 @@
 #define MOD_CFG_EVENT_LIST_SECTION  "EVENT_LIST"
 #define MOD_CFG_EVENT_LIST_REFRESH "REFRESH"
 
+/* OSC output */
+#define MOD_CFG_OSC_SECTION  "OSC"
+#define MOD_CFG_OSC_SINKS    "SINKS"    /* host:port[:proto[:min_el[:catnr,...]]];... */
+#define MOD_CFG_OSC_SERVER_PORT "SERVER_PORT"
+
 
 #endif
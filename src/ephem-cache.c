@@ -0,0 +1,379 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2010  Alexandru Csete, OZ9AEC.
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \brief Interpolating ephemeris cache.
+ *
+ * The ground tracks and the rotator controller evaluate the orbit of the
+ * same satellite at many closely spaced times. Instead of running SGP4 or
+ * SDP4 for every one of them, the cache propagates each satellite on a
+ * coarse grid of nodes and interpolates between them.
+ *
+ * The nodes lie at jul_epoch + n * step, where step is given by
+ * SAT_CFG_INT_EPHEM_STEP, so the result for a given time does not depend on
+ * the order of the queries. Position and velocity are interpolated with a
+ * cubic Hermite polynomial through the two neighbouring nodes; the phase is
+ * interpolated linearly. Everything else, including the sub-satellite
+ * point, is calculated from the interpolated state by predict_calc_state().
+ * The position error of a low earth orbit is well below a metre at the
+ * default step of 60 seconds and grows with the fourth power of the step.
+ *
+ * Each satellite has one contiguous run of nodes, which is extended in
+ * chunks forwards or backwards as needed. A run is started over when it
+ * would grow beyond EPHEM_CACHE_MAX_NODES, and when the TLE epoch or the
+ * step changes.
+ *
+ * The cache is shared by all threads. Nodes are propagated with the lock
+ * held; a chunk only takes a few SGP4 calls.
+ */
+#include <math.h>
+#include <glib.h>
+#include "sgpsdp/sgp4sdp4.h"
+#include "sat-cfg.h"
+#include "predict-tools.h"
+#include "ephem-cache.h"
+
+
+/** \brief Number of nodes added when a run is extended. */
+#define EPHEM_CACHE_CHUNK      16
+
+/** \brief Maximum number of nodes of a run. */
+#define EPHEM_CACHE_MAX_NODES  4096
+
+
+/** \brief State of a satellite at a node. */
+typedef struct {
+    vector_t  pos;     /*!< Position [km] */
+    vector_t  vel;     /*!< Velocity [km/s] */
+    gdouble   phase;   /*!< Phase [rad] */
+} ephem_node_t;
+
+
+/** \brief Nodes of a satellite. */
+typedef struct {
+    gint      catnr;   /*!< Catalogue number. */
+    gdouble   epoch;   /*!< TLE epoch the nodes were propagated with. */
+    gint      step;    /*!< SAT_CFG_INT_EPHEM_STEP */
+    gint64    first;   /*!< Grid index of the first node. */
+    GArray   *nodes;   /*!< The nodes (ephem_node_t). */
+} ephem_entry_t;
+
+
+static ephem_entry_t *get_entry   (sat_t *sat, gint step);
+static void           fill_nodes  (ephem_entry_t *entry, sat_t *sat,
+                                   gdouble step, gint64 n);
+static void           calc_node   (sat_t *sat, gdouble t, ephem_node_t *node);
+static void           interpolate (sat_t *sat, ephem_node_t *a,
+                                   ephem_node_t *b, gdouble s, gdouble h);
+static void           free_entry  (gpointer data);
+
+
+G_LOCK_DEFINE_STATIC (cache);
+
+/** \brief The cache entries (ephem_entry_t) by catalogue number. */
+static GHashTable *cache = NULL;
+
+static guint hits = 0;
+static guint misses = 0;
+
+
+/** \brief Calculate the position of a satellite from the cache.
+ *  \param sat Pointer to the satellite data.
+ *  \param qth Pointer to the QTH data.
+ *  \param t The time for calculation (Julian Date)
+ *
+ * This is a drop-in replacement for predict_calc() for callers that
+ * evaluate many closely spaced times. If SAT_CFG_INT_EPHEM_STEP is 0 it
+ * simply calls predict_calc().
+ */
+void
+ephem_cache_calc (sat_t *sat, qth_t *qth, gdouble t)
+{
+    ephem_entry_t *entry;
+    ephem_node_t   a, b;
+    gdouble        step;
+    gint64         n;
+    gint           secs;
+
+
+    secs = sat_cfg_get_int (SAT_CFG_INT_EPHEM_STEP);
+    if (secs <= 0) {
+        predict_calc (sat, qth, t);
+        return;
+    }
+
+    step = secs / secday;
+    n = (gint64) floor ((t - sat->jul_epoch) / step);
+
+    G_LOCK (cache);
+
+    entry = get_entry (sat, secs);
+
+    if ((entry->nodes->len > 0) && (n >= entry->first) &&
+        (n + 1 < entry->first + entry->nodes->len)) {
+        hits++;
+    }
+    else {
+        misses++;
+        fill_nodes (entry, sat, step, n);
+    }
+
+    a = g_array_index (entry->nodes, ephem_node_t, n - entry->first);
+    b = g_array_index (entry->nodes, ephem_node_t, n - entry->first + 1);
+
+    G_UNLOCK (cache);
+
+    interpolate (sat, &a, &b, (t - sat->jul_epoch) / step - n, secs);
+    predict_calc_state (sat, qth, t);
+}
+
+
+/** \brief Remove all nodes from the cache.
+ *
+ * This is called when the satellites have been reloaded after a TLE update
+ * and when gpredict exits.
+ */
+void
+ephem_cache_clear (void)
+{
+    G_LOCK (cache);
+
+    if (cache != NULL) {
+        g_hash_table_destroy (cache);
+        cache = NULL;
+    }
+
+    G_UNLOCK (cache);
+}
+
+
+/** \brief Remove the nodes of a satellite from the cache.
+ *  \param catnr The catalogue number of the satellite.
+ *
+ * This is called when the TLE of a single satellite has changed.
+ */
+void
+ephem_cache_forget (gint catnr)
+{
+    G_LOCK (cache);
+
+    if (cache != NULL)
+        g_hash_table_remove (cache, &catnr);
+
+    G_UNLOCK (cache);
+}
+
+
+/** \brief Get the cache statistics.
+ *  \param h Location to store the number of queries answered from the
+ *           cache at, or NULL.
+ *  \param m Location to store the number of queries that needed new
+ *           nodes at, or NULL.
+ */
+void
+ephem_cache_stats (guint *h, guint *m)
+{
+    G_LOCK (cache);
+
+    if (h != NULL)
+        *h = hits;
+    if (m != NULL)
+        *m = misses;
+
+    G_UNLOCK (cache);
+}
+
+
+/** \brief Get the cache entry of a satellite.
+ *
+ * The entry is created if it does not exist yet and emptied if it has been
+ * filled with other elements or another step. Must be called with the lock
+ * held.
+ */
+static ephem_entry_t *
+get_entry (sat_t *sat, gint step)
+{
+    ephem_entry_t *entry;
+
+
+    if (cache == NULL)
+        cache = g_hash_table_new_full (g_int_hash, g_int_equal, NULL, free_entry);
+
+    entry = g_hash_table_lookup (cache, &sat->tle.catnr);
+
+    if (entry == NULL) {
+        entry = g_new0 (ephem_entry_t, 1);
+        entry->catnr = sat->tle.catnr;
+        entry->nodes = g_array_new (FALSE, FALSE, sizeof (ephem_node_t));
+        g_hash_table_insert (cache, &entry->catnr, entry);
+    }
+    else if ((entry->epoch == sat->tle.epoch) && (entry->step == step)) {
+        return entry;
+    }
+
+    entry->epoch = sat->tle.epoch;
+    entry->step = step;
+    g_array_set_size (entry->nodes, 0);
+
+    return entry;
+}
+
+
+/** \brief Make sure an entry has the nodes n and n+1.
+ *
+ * The run is extended towards n by at least one chunk, or started over at
+ * n if it would become too long. Must be called with the lock held.
+ */
+static void
+fill_nodes (ephem_entry_t *entry, sat_t *sat, gdouble step, gint64 n)
+{
+    ephem_node_t  node;
+    GArray       *head;
+    gint64        first, last, lo, hi, i;
+
+
+    first = entry->first;
+    last = first + (gint64) entry->nodes->len - 1;
+
+    if (entry->nodes->len == 0) {
+        lo = n;
+        hi = n + EPHEM_CACHE_CHUNK;
+    }
+    else if (n < first) {
+        lo = MIN (n, first - EPHEM_CACHE_CHUNK);
+        hi = last;
+    }
+    else {
+        lo = first;
+        hi = MAX (n + 1, last + EPHEM_CACHE_CHUNK);
+    }
+
+    if (hi - lo >= EPHEM_CACHE_MAX_NODES) {
+        /* start over, keeping the direction we are moving in */
+        if (n < first) {
+            lo = n + 1 - EPHEM_CACHE_CHUNK;
+            hi = n + 1;
+        }
+        else {
+            lo = n;
+            hi = n + EPHEM_CACHE_CHUNK;
+        }
+        g_array_set_size (entry->nodes, 0);
+    }
+
+    if (entry->nodes->len == 0) {
+        first = lo;
+        last = lo - 1;
+    }
+
+    /* nodes before the run */
+    if (lo < first) {
+        head = g_array_sized_new (FALSE, FALSE, sizeof (ephem_node_t),
+                                  (guint) (first - lo));
+        for (i = lo; i < first; i++) {
+            calc_node (sat, sat->jul_epoch + i * step, &node);
+            g_array_append_val (head, node);
+        }
+        g_array_prepend_vals (entry->nodes, head->data, head->len);
+        g_array_free (head, TRUE);
+    }
+
+    /* nodes after the run */
+    for (i = last + 1; i <= hi; i++) {
+        calc_node (sat, sat->jul_epoch + i * step, &node);
+        g_array_append_val (entry->nodes, node);
+    }
+
+    entry->first = lo;
+}
+
+
+/** \brief Propagate a satellite to a node. */
+static void
+calc_node (sat_t *sat, gdouble t, ephem_node_t *node)
+{
+    predict_calc_eci (sat, t);
+
+    node->pos = sat->pos;
+    node->vel = sat->vel;
+    node->phase = sat->phase;
+}
+
+
+/** \brief Interpolate the state between two nodes.
+ *  \param sat The satellite, receives the state.
+ *  \param a The node before.
+ *  \param b The node after.
+ *  \param s The position between a and b, 0 <= s < 1.
+ *  \param h The time between a and b [sec].
+ */
+static void
+interpolate (sat_t *sat, ephem_node_t *a, ephem_node_t *b,
+             gdouble s, gdouble h)
+{
+    gdouble h00, h10, h01, h11;
+    gdouble d0, d1, d2;
+    gdouble dphase;
+
+
+    /* Hermite basis and its derivative */
+    h00 = (1.0 + 2.0*s) * (1.0 - s) * (1.0 - s);
+    h10 = s * (1.0 - s) * (1.0 - s);
+    h01 = s * s * (3.0 - 2.0*s);
+    h11 = s * s * (s - 1.0);
+
+    d0 = 6.0 * s * (s - 1.0) / h;
+    d1 = (3.0*s - 1.0) * (s - 1.0);
+    d2 = s * (3.0*s - 2.0);
+
+    sat->pos.x = h00*a->pos.x + h10*h*a->vel.x + h01*b->pos.x + h11*h*b->vel.x;
+    sat->pos.y = h00*a->pos.y + h10*h*a->vel.y + h01*b->pos.y + h11*h*b->vel.y;
+    sat->pos.z = h00*a->pos.z + h10*h*a->vel.z + h01*b->pos.z + h11*h*b->vel.z;
+
+    sat->vel.x = d0 * (a->pos.x - b->pos.x) + d1 * a->vel.x + d2 * b->vel.x;
+    sat->vel.y = d0 * (a->pos.y - b->pos.y) + d1 * a->vel.y + d2 * b->vel.y;
+    sat->vel.z = d0 * (a->pos.z - b->pos.z) + d1 * a->vel.z + d2 * b->vel.z;
+
+    Magnitude (&sat->pos);
+    Magnitude (&sat->vel);
+
+    /* the phase grows with time and wraps at 2pi */
+    dphase = b->phase - a->phase;
+    if (dphase < 0.0)
+        dphase += twopi;
+
+    sat->phase = FMod2p (a->phase + s * dphase);
+}
+
+
+/** \brief Free a cache entry. */
+static void
+free_entry (gpointer data)
+{
+    ephem_entry_t *entry = (ephem_entry_t *) data;
+
+
+    g_array_free (entry->nodes, TRUE);
+    g_free (entry);
+}
@@ -913,12 +913,12 @@ static void
     root = goo_canvas_get_root_item_model (GOO_CANVAS (pv->canvas));
 
     /* create points */
-    num = g_slist_length (pv->pass->details);
+    num = pv->pass->num_track;
 
     /* time resolution for time ticks; we need
            3 additional points to AOS and LOS ticks.
         */
-    tres = (num-2) / (TRACK_TICK_NUM-1);
+    tres = MAX ((num-2) / (TRACK_TICK_NUM-1), 1);
 
     points = goo_canvas_points_new (num);
 
@@ -931,7 +931,7 @@ static void
     ttidx = 1;
 
     for (i = 1; i < num-1; i++) {
-        detail = PASS_DETAIL(g_slist_nth_data (pv->pass->details, i));
+        detail = &pv->pass->track[i];
         if (detail->el >= 0.0)
             azel_to_xy (pv, detail->az, detail->el, &x, &y);
         points->coords[2*i] = (double) x;
@@ -1023,7 +1023,7 @@ static void
 
 
     /* create points */
-    num = g_slist_length (pv->pass->details);
+    num = pv->pass->num_track;
 
     points = goo_canvas_points_new (num);
 
@@ -1038,11 +1038,11 @@ static void
     /* time resolution for time ticks; we need
            3 additional points to AOS and LOS ticks.
         */
-    tres = (num-2) / (TRACK_TICK_NUM-1);
+    tres = MAX ((num-2) / (TRACK_TICK_NUM-1), 1);
     ttidx = 1;
 
     for (i = 1; i < num-1; i++) {
-        detail = PASS_DETAIL(g_slist_nth_data (pv->pass->details, i));
+        detail = &pv->pass->track[i];
         if (detail->el>=0.0)
             azel_to_xy (pv, detail->az, detail->el, &x, &y);
         points->coords[2*i] = (double) x;
@@ -139,8 +139,8 @@ void
     gtk_check_menu_item_set_active (GTK_CHECK_MENU_ITEM (menuitem), obj->showtrack);
     g_signal_connect (menuitem, "activate", G_CALLBACK (track_toggled), pview);
 
-    /* disable menu item if satellite is geostationary */
-    if (sat->otype == ORBIT_TYPE_GEO)
+    /* disable menu item if satellite is geostationary or has no pass */
+    if ((sat->otype == ORBIT_TYPE_GEO) || (obj->pass == NULL))
         gtk_widget_set_sensitive (menuitem, FALSE);
 
     /* target */
@@ -209,7 +209,7 @@ static void
         /* add sky track */
 
         /* create points */
-        num = g_slist_length (obj->pass->details);
+        num = obj->pass->num_track;
         if (num == 0) {
             sat_log_log (SAT_LOG_LEVEL_BUG,
                          _("%s:%d: Pass has no details."),
@@ -220,7 +220,7 @@ static void
         /* time resolution for time ticks; we need
                    3 additional points to AOS and LOS ticks.
                 */
-        tres = (num-2) / (TRACK_TICK_NUM-1);
+        tres = MAX ((num-2) / (TRACK_TICK_NUM-1), 1);
 
         points = goo_canvas_points_new (num);
 
@@ -233,7 +233,7 @@ static void
         ttidx = 1;
 
         for (i = 1; i < num-1; i++) {
-            detail = PASS_DETAIL(g_slist_nth_data (obj->pass->details, i));
+            detail = &obj->pass->track[i];
             if (detail->el >=0.0)
                 azel_to_xy (pv, detail->az, detail->el, &x, &y);
             points->coords[2*i] = (double) x;
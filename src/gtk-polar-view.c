@@ -1019,7 +1019,7 @@ update_track (gpointer key, gpointer value, gpointer data)
           }
           
         /* create points */
-        num = g_slist_length (obj->pass->details);
+        num = obj->pass->num_track;
         if (num == 0) {
                sat_log_log (SAT_LOG_LEVEL_BUG,
                                _("%s:%d: Pass had no points in it."),
@@ -1040,11 +1040,11 @@ update_track (gpointer key, gpointer value, gpointer data)
         /* time resolution for time ticks; we need
            3 additional points to AOS and LOS ticks.
         */
-        tres = (num-2) / (TRACK_TICK_NUM-1);
+        tres = MAX ((num-2) / (TRACK_TICK_NUM-1), 1);
         ttidx = 1;
 
         for (i = 1; i < num-1; i++) {
-            detail = PASS_DETAIL(g_slist_nth_data (obj->pass->details, i));
+            detail = &obj->pass->track[i];
             if (detail->el>=0)
                 azel_to_xy (pv, detail->az, detail->el, &x, &y);
             points->coords[2*i] = (double) x;
@@ -1167,7 +1167,7 @@ static void create_track (GtkPolarView *pv, sat_obj_t *obj, sat_t *sat)
     /* add sky track */
 
     /* create points */
-    num = g_slist_length (obj->pass->details);
+    num = obj->pass->num_track;
     if (num == 0) {
         sat_log_log (SAT_LOG_LEVEL_BUG,
                      _("%s:%d: Pass had no points in it."),
@@ -1178,7 +1178,7 @@ static void create_track (GtkPolarView *pv, sat_obj_t *obj, sat_t *sat)
     /* time resolution for time ticks; we need
                    3 additional points to AOS and LOS ticks.
                 */
-    tres = (num-2) / (TRACK_TICK_NUM-1);
+    tres = MAX ((num-2) / (TRACK_TICK_NUM-1), 1);
 
     points = goo_canvas_points_new (num);
     
@@ -1193,7 +1193,7 @@ static void create_track (GtkPolarView *pv, sat_obj_t *obj, sat_t *sat)
     ttidx = 1;
     
     for (i = 1; i < num-1; i++) {
-        detail = PASS_DETAIL(g_slist_nth_data (obj->pass->details, i));
+        detail = &obj->pass->track[i];
         if (detail->el >= 0.0 )
             azel_to_xy (pv, detail->az, detail->el, &x, &y);
         points->coords[2*i] = (double) x;
@@ -1626,6 +1626,60 @@ gtk_polar_view_reload_sats (GtkWidget *polv, GHashTable *sats)
 
 
 
+/** \brief Update the pass of a satellite whose TLE has changed.
+ *  \param polv Pointer to the GtkPolarView widget.
+ *  \param catnum The catalogue number of the satellite.
+ *
+ * If the satellite is on the canvas, its current pass is predicted again
+ * and the sky track is moved to it; the canvas items are kept. If the new
+ * elements give no current pass, the sky track is removed.
+ */
+void
+gtk_polar_view_update_tle (GtkWidget *polv, gint catnum)
+{
+    GtkPolarView       *pv = GTK_POLAR_VIEW (polv);
+    GooCanvasItemModel *root;
+    sat_obj_t          *obj;
+    sat_t              *sat;
+    gint                idx;
+    guint               i;
+
+
+    obj = SAT_OBJ (g_hash_table_lookup (pv->obj, &catnum));
+    sat = SAT (g_hash_table_lookup (pv->sats, &catnum));
+
+    if ((obj == NULL) || (sat == NULL))
+        return;
+
+    /* the sky track only exists if there was a pass when it was created */
+    if (obj->pass == NULL)
+        return;
+
+    free_pass (obj->pass);
+    obj->pass = get_current_pass (sat, pv->qth, pv->tstamp);
+
+    if (obj->pass != NULL) {
+        update_track (&catnum, obj, pv);
+    }
+    else if (obj->showtrack) {
+        /* remove sky track */
+        root = goo_canvas_get_root_item_model (GOO_CANVAS (pv->canvas));
+
+        idx = goo_canvas_item_model_find_child (root, obj->track);
+        if (idx != -1)
+            goo_canvas_item_model_remove_child (root, idx);
+
+        for (i = 0; i < TRACK_TICK_NUM; i++) {
+            idx = goo_canvas_item_model_find_child (root, obj->trtick[i]);
+            if (idx != -1)
+                goo_canvas_item_model_remove_child (root, idx);
+        }
+
+        obj->showtrack = FALSE;
+    }
+}
+
+
 /** \brief Convert LOS timestamp to human readable countdown string */
 static gchar *los_time_to_str (GtkPolarView *polv, sat_t *sat)
 {
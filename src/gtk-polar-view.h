@@ -154,6 +154,7 @@ void azel_to_xy     (GtkPolarView *p, gdouble az, gdouble el, gfloat *x, gfloat
 void xy_to_azel     (GtkPolarView *p, gfloat x, gfloat y, gfloat *az, gfloat *el);
 
 void gtk_polar_view_reload_sats (GtkWidget *polv, GHashTable *sats);
+void gtk_polar_view_update_tle  (GtkWidget *polv, gint catnum);
 
 
 #ifdef __cplusplus
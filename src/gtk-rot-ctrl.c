@@ -41,6 +41,7 @@
 #include "compat.h"
 #include "sat-log.h"
 #include "predict-tools.h"
+#include "ephem-cache.h"
 #include "gtk-polar-plot.h"
 #include "gtk-rot-knob.h"
 #include "gtk-rot-ctrl.h"
@@ -993,7 +994,7 @@ static gboolean
                       pushing ourselves away from the satellite.
                     */
                     while (step_size > (ctrl->delay/1000.0/4.0/(secday))) {
-                        predict_calc (sat,ctrl->qth,ctrl->t+time_delta);
+                        ephem_cache_calc (sat,ctrl->qth,ctrl->t+time_delta);
                         /*update sat->az and sat->el to account for flips and az range*/
                         if ((ctrl->flipped) && (ctrl->conf->maxel >= 180.0)){
                             sat->el = 180.0-sat->el;
@@ -1452,7 +1453,7 @@ static gboolean is_flipped_pass (pass_t * pass,rot_az_type_t type){
     pass_detail_t      *detail;
     gboolean retval=FALSE;
 
-    num = g_slist_length (pass->details);
+    num = pass->num_details;
     if (type==ROT_AZ_TYPE_360) {
         min_az = 0;
         max_az = 360;
@@ -1473,7 +1474,7 @@ static gboolean is_flipped_pass (pass_t * pass,rot_az_type_t type){
     
     if (num>1) {
         for (i = 1; i < num-1; i++) {
-            detail = PASS_DETAIL(g_slist_nth_data (pass->details, i));
+            detail = &pass->detail[i];
             caz=detail->az;
             while (caz>max_az) {
                 caz-=360;
@@ -37,8 +37,11 @@
 #include "orbit-tools.h"
 #include "time-tools.h"
 #include "compat.h"
+#include "sat-db.h"
 
 
+static void init_fields (sat_t *sat);
+
 
 
 /** \brief Read TLE data for a given satellite into memory.
@@ -47,6 +50,8 @@
  *  \return 0 if successfull, 1 if an I/O error occurred,
  *          2 if the TLE data appears to be bad.
  *
+ * The satellite is read from the catalogue database if it is there and
+ * from its .sat file otherwise.
  */
 gint
 gtk_sat_data_read_sat (gint catnum, sat_t *sat)
@@ -61,6 +66,11 @@ gtk_sat_data_read_sat (gint catnum, sat_t *sat)
     /* ensure that sat != NULL */
     g_return_val_if_fail (sat != NULL, 1);
 
+    if (sat_db_read_sat (catnum, sat)) {
+        init_fields (sat);
+        return 0;
+    }
+
     /* .sat file names */
     filename = g_strdup_printf ("%d.sat", catnum);
     path = sat_file_name_from_catnum (catnum);
@@ -114,39 +124,7 @@ gtk_sat_data_read_sat (gint catnum, sat_t *sat)
         g_free (tlestr2);
         g_free (rawtle);
 
-
-        /* VERY, VERY important! If not done, some sats
-           will not get initialised, the first time SGP4/SDP4
-           is called. Consequently, the resulting data will
-           be NAN, INF or similar nonsense.
-           For some reason, not even using g_new0 seems to
-           be enough.
-        */
-        sat->flags = 0;
-
-        select_ephemeris (sat);
-
-        /* initialise variable fields */
-        sat->jul_utc = 0.0;
-        sat->tsince = 0.0;
-        sat->az = 0.0;
-        sat->el = 0.0;
-        sat->range = 0.0;
-        sat->range_rate = 0.0;
-        sat->ra = 0.0;
-        sat->dec = 0.0;
-        sat->ssplat = 0.0;
-        sat->ssplon = 0.0;
-        sat->alt = 0.0;
-        sat->velo = 0.0;
-        sat->ma = 0.0;
-        sat->footprint = 0.0;
-        sat->phase = 0.0;
-        sat->aos = 0.0;
-        sat->los = 0.0;
-
-        /* calculate satellite data at epoch */
-        gtk_sat_data_init_sat (sat, NULL);
+        init_fields (sat);
     }
 
     g_free (filename);
@@ -157,6 +135,45 @@ gtk_sat_data_read_sat (gint catnum, sat_t *sat)
 }
 
 
+/** \brief Initialise a satellite whose elements have been read. */
+static void
+init_fields (sat_t *sat)
+{
+    /* VERY, VERY important! If not done, some sats
+       will not get initialised, the first time SGP4/SDP4
+       is called. Consequently, the resulting data will
+       be NAN, INF or similar nonsense.
+       For some reason, not even using g_new0 seems to
+       be enough.
+    */
+    sat->flags = 0;
+
+    select_ephemeris (sat);
+
+    /* initialise variable fields */
+    sat->jul_utc = 0.0;
+    sat->tsince = 0.0;
+    sat->az = 0.0;
+    sat->el = 0.0;
+    sat->range = 0.0;
+    sat->range_rate = 0.0;
+    sat->ra = 0.0;
+    sat->dec = 0.0;
+    sat->ssplat = 0.0;
+    sat->ssplon = 0.0;
+    sat->alt = 0.0;
+    sat->velo = 0.0;
+    sat->ma = 0.0;
+    sat->footprint = 0.0;
+    sat->phase = 0.0;
+    sat->aos = 0.0;
+    sat->los = 0.0;
+
+    /* calculate satellite data at epoch */
+    gtk_sat_data_init_sat (sat, NULL);
+}
+
+
 
 /** \brief Initialise satellite data.
  *  \param sat The satellite to initialise.
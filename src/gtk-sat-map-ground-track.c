@@ -48,6 +48,7 @@
 //#include "time-tools.h"
 #include "sat-cfg.h"
 #include "predict-tools.h"
+#include "ephem-cache.h"
 #include "gtk-sat-map-ground-track.h"
 
 
@@ -67,10 +68,13 @@ static void     free_ssp          (gpointer ssp, gpointer data);
  * times, and using one single polyline for the whole ground track would look very
  * silly. To avoid this, the points will be split into several polylines.
  *
+ * The ground track is calculated using a working copy of the satellite so
+ * that the satellite data owned by the module is not modified.
  */
 void
-ground_track_create (GtkSatMap *satmap, sat_t *sat, qth_t *qth, sat_map_obj_t *obj)
+ground_track_create (GtkSatMap *satmap, sat_t *sat_in, qth_t *qth, sat_map_obj_t *obj)
 {
+     sat_t         *sat,sat_working;
      unsigned long  this_orbit;  /* current orbit number */
      unsigned long  max_orbit;   /* target orbit number, ie. this + num - 1 */
      double         t0;          /* time when this_orbit starts */
@@ -78,6 +82,9 @@ ground_track_create (GtkSatMap *satmap, sat_t *sat, qth_t *qth, sat_map_obj_t *o
      ssp_t         *this_ssp;
 
 
+     /* use a working copy so data does not get corrupted */
+     sat = memcpy (&sat_working, sat_in, sizeof (sat_t));
+
      sat_log_log (SAT_LOG_LEVEL_DEBUG,
                      _("%s: Creating ground track for %s"),
                  __FUNCTION__, sat->nickname);
@@ -104,14 +111,14 @@ ground_track_create (GtkSatMap *satmap, sat_t *sat, qth_t *qth, sat_map_obj_t *o
      /* find the time when the current orbit started */
 
      /* Iterate backwards in time until we reach sat->orbit < this_orbit.
-        Use predict_calc from predict-tools.c as SGP/SDP driver.
+        Use the ephemeris cache as SGP/SDP driver.
         As a built-in safety, we stop iteration if the orbit crossing is
         more than 12 hours back in time.
      */
      t0 = satmap->tstamp;//get_current_daynum ();
      for (t = t0; (sat->orbit >= this_orbit) && ((t+0.5) > t0); t -= 0.0007) {
 
-          predict_calc (sat, qth, t);
+          ephem_cache_calc (sat, qth, t);
 
      }
 
@@ -129,7 +136,7 @@ ground_track_create (GtkSatMap *satmap, sat_t *sat, qth_t *qth, sat_map_obj_t *o
              line drawing routine will filter out unnecessary points
           */
           t += 0.00035;
-          predict_calc (sat, qth, t);
+          ephem_cache_calc (sat, qth, t);
 
           /* store this SSP */
 
@@ -156,7 +163,7 @@ ground_track_create (GtkSatMap *satmap, sat_t *sat, qth_t *qth, sat_map_obj_t *o
      obj->track_data.latlon = g_slist_reverse (obj->track_data.latlon);
 
      /* split points into polylines */
-     create_polylines (satmap, sat, qth, obj);
+     create_polylines (satmap, sat_in, qth, obj);
 
      /* misc book-keeping */
      obj->track_orbit = this_orbit;
@@ -2382,3 +2382,23 @@ static gchar *aoslos_time_to_str (GtkSatMap *satmap, sat_t *sat)
 
     return text;
 }
+
+
+/** \brief Forget the ground track of a satellite whose TLE has changed.
+ *  \param satmap Pointer to the GtkSatMap widget.
+ *  \param catnum The catalogue number of the satellite.
+ *
+ * The satellite keeps its canvas items; a visible ground track is
+ * recalculated in the next update.
+ */
+void
+gtk_sat_map_update_tle (GtkWidget *satmap, gint catnum)
+{
+    sat_map_obj_t *obj;
+
+
+    obj = SAT_MAP_OBJ (g_hash_table_lookup (GTK_SAT_MAP (satmap)->obj, &catnum));
+
+    if (obj != NULL)
+        obj->track_orbit = 0;
+}
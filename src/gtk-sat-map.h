@@ -182,6 +182,7 @@ void           gtk_sat_map_lonlat_to_xy (GtkSatMap *m,
                                          gdouble *x, gdouble *y);
 
 void gtk_sat_map_reload_sats (GtkWidget *satmap, GHashTable *sats);
+void gtk_sat_map_update_tle  (GtkWidget *satmap, gint catnum);
 
 #ifdef __cplusplus
 }
@@ -67,9 +67,12 @@
 #include "gtk-rot-ctrl.h"
 #include "gtk-sky-glance.h"
 #include "compat.h"
-
-#include "lo/lo.h"
-#include "string.h"
+#include "osc-sender.h"
+#include "osc-server.h"
+#include "prop-pool.h"
+#include "sat-state.h"
+#include "pass-cache.h"
+#include "ephem-cache.h"
 
 
 //#ifdef G_OS_WIN32
@@ -86,9 +89,12 @@ static void     gtk_sat_module_read_cfg_data  (GtkSatModule *module,
 static void     gtk_sat_module_load_sats      (GtkSatModule *module);
 static void     gtk_sat_module_free_sat       (gpointer sat);
 static gboolean gtk_sat_module_timeout_cb     (gpointer module);
-static void     gtk_sat_module_update_sat     (gpointer key,
-                                               gpointer val,
+static void     gtk_sat_module_update_pool    (GtkSatModule *module);
+static void     gtk_sat_module_update_sat     (guint first,
+                                               guint n,
+                                               gpointer *items,
                                                gpointer data);
+static void     gtk_sat_module_osc_cmd        (osc_cmd_t *cmd, gpointer data);
 static void     gtk_sat_module_popup_cb       (GtkWidget *button,
                                                gpointer data);
 
@@ -99,10 +105,24 @@ static void     get_grid_size                 (GtkSatModule *module, guint *rows
 static GtkWidget *create_view                 (GtkSatModule *module, guint num);
 
 static void     reload_sats_in_child (GtkWidget *widget, GtkSatModule *module);
+static gboolean update_sats          (GtkSatModule *module);
 
 static void     update_skg                    (GtkSatModule *module);
 
 
+/** \brief Data shared by the propagation workers during a cycle.
+ *
+ * Everything the workers need apart from the satellite is read here by the
+ * main thread, since the configuration is not thread safe.
+ */
+typedef struct {
+    GtkSatModule *module;    /*!< The module. */
+    gdouble       daynum;    /*!< The time of the cycle. */
+    gboolean      events;    /*!< Recalculate AOS and LOS. */
+    gdouble       maxdt;     /*!< Look-ahead limit for AOS and LOS [days]. */
+} update_data_t;
+
+
 static GtkVBoxClass *parent_class = NULL;
 
 
@@ -166,11 +186,16 @@ gtk_sat_module_init (GtkSatModule *module)
     module->qth->lat = 0.0;
     module->qth->lon = 0.0;
     module->qth->alt = 0;
+    qth_data_update_obs (module->qth);
 
     module->satellites = g_hash_table_new_full (g_int_hash,
                                                 g_int_equal,
                                                 g_free,
                                                 gtk_sat_module_free_sat);
+    module->satarray = g_ptr_array_new ();
+    module->satstate = sat_state_new ();
+    module->pool = NULL;
+    module->poolcfg = 0;
     
     module->rotctrlwin = NULL;
     module->rotctrl    = NULL;
@@ -188,6 +213,9 @@ gtk_sat_module_init (GtkSatModule *module)
     module->nviews = 0;
 
     module->timerid = 0;
+
+    module->osc = NULL;
+    module->oscsrv = NULL;
     
     module->throttle = 1;
     module->rtNow = 0.0;
@@ -235,7 +263,33 @@ gtk_sat_module_destroy (GtkObject *object)
         module->qth = NULL;
     }
 
+    /* stop OSC control server */
+    if (module->oscsrv) {
+        osc_server_free (module->oscsrv);
+        module->oscsrv = NULL;
+    }
+
+    /* clean up OSC output */
+    if (module->osc) {
+        osc_sender_free (module->osc);
+        module->osc = NULL;
+    }
+
+    /* stop propagation workers */
+    if (module->pool) {
+        prop_pool_free (module->pool);
+        module->pool = NULL;
+    }
+
     /* clean up satellites */
+    if (module->satarray) {
+        g_ptr_array_free (module->satarray, TRUE);
+        module->satarray = NULL;
+    }
+    if (module->satstate) {
+        sat_state_free (module->satstate);
+        module->satstate = NULL;
+    }
     if (module->satellites) {
         g_hash_table_destroy (module->satellites);
         module->satellites = NULL;
@@ -263,6 +317,7 @@ gtk_sat_module_new (const gchar *cfgfile)
 {
     GtkWidget *widget;
     GtkWidget *butbox;
+    gchar     *buffer;
 
 
     /* Read configuration data.
@@ -320,6 +375,30 @@ gtk_sat_module_new (const gchar *cfgfile)
 
     /* load satellites */
     gtk_sat_module_load_sats (GTK_SAT_MODULE (widget));
+    sat_state_set_sats (GTK_SAT_MODULE (widget)->satstate,
+                        GTK_SAT_MODULE (widget)->satarray);
+
+    /* create OSC output; the addresses and paths are reused in every cycle */
+    buffer = mod_cfg_get_str (GTK_SAT_MODULE (widget)->cfgdata,
+                              MOD_CFG_OSC_SECTION,
+                              MOD_CFG_OSC_SINKS,
+                              SAT_CFG_STR_OSC_SINKS);
+    GTK_SAT_MODULE (widget)->osc = osc_sender_new (buffer);
+    g_free (buffer);
+    if (GTK_SAT_MODULE (widget)->osc)
+        osc_sender_set_sats (GTK_SAT_MODULE (widget)->osc,
+                             GTK_SAT_MODULE (widget)->satstate);
+
+    /* start OSC control server if a port is configured */
+    buffer = mod_cfg_get_str (GTK_SAT_MODULE (widget)->cfgdata,
+                              MOD_CFG_OSC_SECTION,
+                              MOD_CFG_OSC_SERVER_PORT,
+                              SAT_CFG_STR_OSC_SERVER_PORT);
+    if (buffer && buffer[0] != '\0')
+        GTK_SAT_MODULE (widget)->oscsrv = osc_server_new (buffer,
+                                                          gtk_sat_module_osc_cmd,
+                                                          widget);
+    g_free (buffer);
     
     /* create buttons */
     GTK_SAT_MODULE (widget)->popup_button =
@@ -647,6 +726,9 @@ gtk_sat_module_load_sats      (GtkSatModule *module)
     guint  *key = NULL;
     guint   succ = 0;
 
+    /* the array is rebuilt together with the hash table */
+    g_ptr_array_set_size (module->satarray, 0);
+
     /* get list of satellites from config file; abort in case of error */
     sats = g_key_file_get_integer_list (module->cfgdata,
                                         MOD_CFG_GLOBAL_SECTION,
@@ -698,6 +780,7 @@ gtk_sat_module_load_sats      (GtkSatModule *module)
                 g_hash_table_insert (module->satellites,
                                      key,
                                      sat);
+                g_ptr_array_add (module->satarray, sat);
 
                 succ++;
 
@@ -751,6 +834,7 @@ gtk_sat_module_timeout_cb     (gpointer module)
     gboolean        needupdate = FALSE;
     GdkWindowState  state;
     gdouble         delta;
+    update_data_t   upd;
     guint           i;
 
 
@@ -820,10 +904,20 @@ gtk_sat_module_timeout_cb     (gpointer module)
             mod->event_count = 0;
         }
 
-        /* update satellite data */
-        g_hash_table_foreach (mod->satellites,
-                              gtk_sat_module_update_sat,
-                              module);
+        /* update satellite data; this is the only place where the
+           satellites are propagated, the views only read them and
+           use working copies for their own calculations. The
+           satellites are spread over the worker threads and
+           prop_pool_run returns when all of them are done, so the
+           views, OSC and controllers below see a consistent cycle. */
+        upd.module = mod;
+        upd.daynum = mod->tmgCdnum;
+        upd.events = (mod->event_count == 0);
+        upd.maxdt = (gdouble) sat_cfg_get_int (SAT_CFG_INT_PRED_LOOK_AHEAD);
+
+        gtk_sat_module_update_pool (mod);
+        prop_pool_run (mod->pool, mod->satarray,
+                       gtk_sat_module_update_sat, &upd);
 
         /* update children */
         for (i = 0; i < mod->nviews; i++) {
@@ -831,11 +925,12 @@ gtk_sat_module_timeout_cb     (gpointer module)
             update_child (child, mod->tmgCdnum);
         }
 
-
-        /* update satellite data (it may have got out of sync during child updates) */
-        g_hash_table_foreach (mod->satellites,
-                              gtk_sat_module_update_sat,
-                              module);
+        /* send satellite data to OSC receiver, once per cycle */
+        if (mod->osc && sat_cfg_get_bool (SAT_CFG_BOOL_SEND_OSC)) {
+            osc_sender_begin (mod->osc, mod->tmgCdnum);
+            osc_sender_add_state (mod->osc, mod->satstate);
+            osc_sender_end (mod->osc);
+        }
 
         /* send notice to radio and rotator controller */
         if (mod->rigctrl)
@@ -919,136 +1014,133 @@ update_child (GtkWidget *child, gdouble tstamp)
 }
 
 
-/** \brief Update a given satellite.
- *  \param key The hash table key (catnum)
- *  \param val The hash table value (sat_t structure)
- *  \param data User data (the GtkSatModule widget).
+/** \brief Create or resize the propagation worker pool.
+ *  \param module Pointer to the GtkSatModule widget.
  *
- * This function updates the tracking data for a given satelite. It is called by
- * the timeout handler for each element in the hash table.
+ * The pool is created in the first cycle and recreated whenever the
+ * number of threads in the configuration changes.
  */
 static void
-gtk_sat_module_update_sat    (gpointer key, gpointer val, gpointer data)
+gtk_sat_module_update_pool    (GtkSatModule *module)
 {
-    sat_t        *sat;
-    GtkSatModule *module;
-    gdouble       daynum;
-    double        age;
-    obs_set_t     obs_set = {0,0,0,0};
-    geodetic_t    sat_geodetic = {0,0,0,0};
-    geodetic_t    obs_geodetic = {0,0,0,0};
-    gdouble       maxdt;
+    gint cfg;
 
 
-   g_return_if_fail ((val != NULL) && (data != NULL));
+    cfg = sat_cfg_get_int (SAT_CFG_INT_MODULE_THREADS);
 
-    sat = SAT(val);
-    module = GTK_SAT_MODULE (data);
+    if (module->pool && (module->poolcfg == cfg))
+        return;
 
+    prop_pool_free (module->pool);
+    module->pool = prop_pool_new (prop_pool_num_threads (cfg));
+    module->poolcfg = cfg;
+}
 
-    /* get current time (real or simulated */
-    daynum = module->tmgCdnum;
 
-    /* update events if the event counter has been reset
-       and the other requirements are fulfilled
-    */
-    if ((GTK_SAT_MODULE (module)->event_count == 0) &&
-        (sat->otype != ORBIT_TYPE_GEO) &&
-        (sat->otype != ORBIT_TYPE_DECAYED) &&
-        has_aos (sat, module->qth))    {
-
-        /* Note that has_aos may return TRUE for geostationary sats
-           whose orbit deviate from a true-geostat orbit, however,
-           find_aos and find_los will not go beyond the time limit
-           we specify (in those cases they return 0.0 for AOS/LOS times.
-           We use SAT_CFG_INT_PRED_LOOK_AHEAD for upper time limit
+/** \brief Update a chunk of satellites.
+ *  \param first The index of the first satellite in module->satarray.
+ *  \param n The number of satellites in the chunk.
+ *  \param items The satellites (sat_t structures).
+ *  \param data User data (update_data_t of the cycle).
+ *
+ * This function updates the tracking data for a chunk of satelites and
+ * copies it into the state table. It is called by the propagation workers
+ * and may only modify the satellites of the chunk and their entries in the
+ * state table. The satellites are propagated together with
+ * predict_calc_batch(), which shares the topocentric transformation
+ * between them.
+ */
+static void
+gtk_sat_module_update_sat    (guint first, guint n, gpointer *items,
+                              gpointer data)
+{
+    sat_t         *sat;
+    update_data_t *upd = (update_data_t *) data;
+    qth_t         *qth = upd->module->qth;
+    guint          i;
+
+
+    for (i = 0; i < n; i++) {
+        sat = SAT (items[i]);
+
+        /* update events if the event counter has been reset
+           and the other requirements are fulfilled
         */
-        maxdt = (gdouble) sat_cfg_get_int (SAT_CFG_INT_PRED_LOOK_AHEAD);
-        sat->aos = find_aos (sat, module->qth, daynum, maxdt);
-        sat->los = find_los (sat, module->qth, daynum, maxdt);
+        if (upd->events &&
+            (sat->otype != ORBIT_TYPE_GEO) &&
+            (sat->otype != ORBIT_TYPE_DECAYED) &&
+            has_aos (sat, qth))    {
+
+            /* Note that has_aos may return TRUE for geostationary sats
+               whose orbit deviate from a true-geostat orbit, however,
+               find_aos and find_los will not go beyond the time limit
+               we specify (in those cases they return 0.0 for AOS/LOS times.
+               We use SAT_CFG_INT_PRED_LOOK_AHEAD for upper time limit
+            */
+            sat->aos = find_aos (sat, qth, upd->daynum, upd->maxdt);
+            sat->los = find_los (sat, qth, upd->daynum, upd->maxdt);
 
+        }
     }
 
+    predict_calc_batch ((sat_t **) items, n, qth, upd->daynum);
 
-    /*** FIXME: we don't need to do this every time! */
-    obs_geodetic.lon = module->qth->lon * de2ra;
-    obs_geodetic.lat = module->qth->lat * de2ra;
-    obs_geodetic.alt = module->qth->alt / 1000.0;
-    obs_geodetic.theta = 0;
+    for (i = 0; i < n; i++)
+        sat_state_store (upd->module->satstate, first + i, SAT (items[i]));
 
 
-    sat->jul_utc = daynum;
-    sat->tsince = (sat->jul_utc - sat->jul_epoch) * xmnpda;
+    /*** FIXME: Squint + AOS / LOS code */
 
+}
 
 
-    /* call the norad routines according to the deep-space flag */
-    if (sat->flags & DEEP_SPACE_EPHEM_FLAG)
-        SDP4 (sat, sat->tsince);
-    else
-        SGP4 (sat, sat->tsince);
-
-    /* scale position and velocity to km and km/sec */
-    Convert_Sat_State (&sat->pos, &sat->vel);
-
-    /* get the velocity of the satellite */
-    Magnitude (&sat->vel);
-    sat->velo = sat->vel.w;
-    Calculate_Obs (sat->jul_utc, &sat->pos, &sat->vel, &obs_geodetic, &obs_set);
-    Calculate_LatLonAlt (sat->jul_utc, &sat->pos, &sat_geodetic);
-
-    /*** FIXME: should we ensure sat_geodetic.lon stays between -pi and pi? */
-    while (sat_geodetic.lon < -pi)
-        sat_geodetic.lon += twopi;
-
-    while (sat_geodetic.lon > (pi))
-        sat_geodetic.lon -= twopi;
-
-    sat->az = Degrees (obs_set.az);
-    sat->el = Degrees (obs_set.el);
-    sat->range = obs_set.range;
-    sat->range_rate = obs_set.range_rate;
-    sat->ssplat = Degrees (sat_geodetic.lat);
-    sat->ssplon = Degrees (sat_geodetic.lon);
-    sat->alt = sat_geodetic.alt;
-    sat->ma = Degrees (sat->phase);
-    sat->ma *= 256.0/360.0;
-    sat->phase = Degrees (sat->phase);
-
-    /* same formulas, but the one from predict is nicer */
-    //sat->footprint = 2.0 * xkmper * acos (xkmper/sat->pos.w);
-    sat->footprint = 12756.33 * acos (xkmper / (xkmper+sat->alt));
-    age = sat->jul_utc - sat->jul_epoch;
-    sat->orbit = (long) floor((sat->tle.xno * xmnpda/twopi +
-                               age * sat->tle.bstar * ae) * age +
-                              sat->tle.xmo/twopi) + sat->tle.revnum - 1;
+/** \brief Apply commands received by the OSC control server.
+ *  \param cmd The commands.
+ *  \param data Pointer to the GtkSatModule widget.
+ *
+ * This function is called from the main loop. The commands only change
+ * the time keeping variables and the selection; the views are updated in
+ * the next cycle as usual.
+ */
+static void
+gtk_sat_module_osc_cmd        (osc_cmd_t *cmd, gpointer data)
+{
+    GtkSatModule *mod = GTK_SAT_MODULE (data);
+    GtkWidget    *child;
+    guint         i;
 
 
-    /*** FIXME: Squint + AOS / LOS code */
-    /* ************************************************************************* */
-    /* ************************************************************************* */
-    /* ******************************* HACK ************************************ */
-    /* ************************************************************************* */
-    /* ************************************************************************* */
-
-    /* OSC Data */
-    if (sat_cfg_get_bool(SAT_CFG_BOOL_SEND_OSC) == TRUE) {
-    //OSC
-    GString *msg_header, *tlecatnr_string;
-    msg_header = g_string_new("/gpredict/sat/");
-    tlecatnr_string = g_strdup_printf("%i", sat->tle.catnr);
-    g_string_append(msg_header,  tlecatnr_string);        
-
-   	    lo_address t = lo_address_new(NULL, "7770");
-	    if (lo_send(t,msg_header->str , "ffff",  sat->az, sat->el, sat->alt, sat->velo) == -1)
-		    printf("OSC error %d: %s\n", lo_address_errno(t), lo_address_errstr(t));
-	    lo_address_free (t);
+    if (cmd->flags & OSC_CMD_RELOAD)
+        gtk_sat_module_reload_sats (mod);
+
+    if (cmd->flags & OSC_CMD_THROTTLE)
+        mod->throttle = cmd->throttle;
+
+    if (cmd->flags & OSC_CMD_TIME) {
+        /* restart the time keeping from the new time; in manual mode
+           tmgCdnum is used as is, otherwise it is advanced from tmgPdnum */
+        mod->rtPrev = get_current_daynum ();
+        mod->tmgPdnum = cmd->daynum;
+        mod->tmgCdnum = cmd->daynum;
+
+        if (mod->tmgActive) {
+            /* block the time controller signals like tmg_reset does */
+            mod->reset = TRUE;
+            tmg_update_widgets (mod);
+            mod->reset = FALSE;
+        }
     }
 
+    if (cmd->flags & OSC_CMD_SELECT) {
+        for (i = 0; i < mod->nviews; i++) {
+            child = GTK_WIDGET (g_slist_nth_data (mod->views, i));
+            if (IS_GTK_SINGLE_SAT (child))
+                gtk_single_sat_select_sat (child, cmd->catnr);
+        }
+    }
 }
 
 
-
 /** \brief Module options
  *
  * Invoke module-wide popup menu
@@ -1399,9 +1491,13 @@ static gboolean empty (gpointer key, gpointer val, gpointer data)
  *   1. The TLE files have been updated.
  *   2. The module configuration has changed (i.e. which satellites to track).
  *
- * The function assumes that module->cfgdata has already been updated, and so
- * all it has to do is to free module->satellites and re-execute the satellite
- * loading sequence.
+ * The function assumes that module->cfgdata has already been updated.
+ *
+ * If the module still tracks the same satellites, only the satellites whose
+ * TLE has changed are initialised again, in place, see update_sats(). The
+ * views keep their canvas items and only forget what they have predicted
+ * for those satellites. Otherwise module->satellites is freed and the
+ * satellite loading sequence is executed again.
  */
 void
 gtk_sat_module_reload_sats    (GtkSatModule *module)
@@ -1419,14 +1515,28 @@ gtk_sat_module_reload_sats    (GtkSatModule *module)
                  _("%s: Reloading satellites for module %s"),
                  __FUNCTION__, module->name);
 
+    if (update_sats (module)) {
+        g_mutex_unlock(module->busy);
+        return;
+    }
+
     /* remove each element from the hash table, but keep the hash table */
     g_hash_table_foreach_remove (module->satellites, empty, NULL);
 
     /* reset event counter so that next AOS/LOS gets re-calculated */
     module->event_count = 0;       
 
+    /* forget the passes and orbits predicted with the old elements */
+    pass_cache_clear ();
+    ephem_cache_clear ();
+
     /* load satellites */
     gtk_sat_module_load_sats (module);
+    sat_state_set_sats (module->satstate, module->satarray);
+
+    /* rebuild OSC paths */
+    if (module->osc)
+        osc_sender_set_sats (module->osc, module->satstate);
 
     /* update children */
     for (i = 0; i < module->nviews; i++) {
@@ -1441,6 +1551,125 @@ gtk_sat_module_reload_sats    (GtkSatModule *module)
 }
 
 
+/** \brief Update the satellites of a module in place.
+ *  \param module Pointer to a GtkSatModule widget.
+ *  \return FALSE if the module tracks other satellites now and has to be
+ *          reloaded, TRUE otherwise.
+ *
+ * Each satellite is read from the catalogue again. If its TLE has changed,
+ * the new data is copied into the existing sat_t, so the pointers held by
+ * the views, the state table and the OSC sender stay valid, and the
+ * satellite is initialised and its next AOS/LOS calculated. Only the
+ * cached passes and orbits of the changed satellites are dropped.
+ *
+ * Must be called with the module locked.
+ */
+static gboolean
+update_sats (GtkSatModule *module)
+{
+    gint      *sats;
+    gsize      length;
+    sat_t     *sat;
+    sat_t     *fresh;
+    GArray    *changed;
+    GtkWidget *child;
+    gdouble    maxdt;
+    gint       catnum;
+    guint      i, j;
+
+
+    sats = g_key_file_get_integer_list (module->cfgdata,
+                                        MOD_CFG_GLOBAL_SECTION,
+                                        MOD_CFG_SATS_KEY,
+                                        &length,
+                                        NULL);
+    if (sats == NULL)
+        return FALSE;
+
+    /* the satellites must be the same, duplicates are not loaded */
+    if (length != module->satarray->len) {
+        g_free (sats);
+        return FALSE;
+    }
+
+    for (i = 0; i < length; i++) {
+        if (g_hash_table_lookup (module->satellites, &sats[i]) == NULL) {
+            g_free (sats);
+            return FALSE;
+        }
+    }
+
+    g_free (sats);
+
+    changed = g_array_new (FALSE, FALSE, sizeof (gint));
+    maxdt = (gdouble) sat_cfg_get_int (SAT_CFG_INT_PRED_LOOK_AHEAD);
+
+    for (i = 0; i < module->satarray->len; i++) {
+        sat = SAT (g_ptr_array_index (module->satarray, i));
+        catnum = sat->tle.catnr;
+
+        fresh = g_new0 (sat_t, 1);
+
+        if (gtk_sat_data_read_sat (catnum, fresh)) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Error reading data for #%d"),
+                         __FUNCTION__, catnum);
+            gtk_sat_data_free_sat (fresh);
+            continue;
+        }
+
+        if ((fresh->tle.epoch == sat->tle.epoch) &&
+            (fresh->tle.elset == sat->tle.elset)) {
+            gtk_sat_data_free_sat (fresh);
+            continue;
+        }
+
+        /* swap the elements */
+        g_free (sat->name);
+        g_free (sat->nickname);
+        g_free (sat->website);
+        *sat = *fresh;
+        g_free (fresh);
+
+        gtk_sat_data_init_sat (sat, module->qth);
+
+        pass_cache_forget (catnum);
+        ephem_cache_forget (catnum);
+
+        if ((sat->otype != ORBIT_TYPE_GEO) &&
+            (sat->otype != ORBIT_TYPE_DECAYED) &&
+            has_aos (sat, module->qth)) {
+            sat->aos = find_aos (sat, module->qth, module->tmgCdnum, maxdt);
+            sat->los = find_los (sat, module->qth, module->tmgCdnum, maxdt);
+        }
+
+        g_array_append_val (changed, catnum);
+    }
+
+    sat_log_log (SAT_LOG_LEVEL_MSG,
+                 _("%s: Updated %d out of %d satellites"),
+                 __FUNCTION__, changed->len, module->satarray->len);
+
+    /* let the views forget the predictions for the changed satellites */
+    for (i = 0; i < module->nviews; i++) {
+        child = GTK_WIDGET (g_slist_nth_data (module->views, i));
+
+        for (j = 0; j < changed->len; j++) {
+            catnum = g_array_index (changed, gint, j);
+
+            if (IS_GTK_POLAR_VIEW (child))
+                gtk_polar_view_update_tle (child, catnum);
+            else if (IS_GTK_SAT_MAP (child))
+                gtk_sat_map_update_tle (child, catnum);
+        }
+    }
+
+    g_array_free (changed, TRUE);
+
+    return TRUE;
+}
+
+
 /** \brief Reload satellites in view */
 static void
 reload_sats_in_child (GtkWidget *widget, GtkSatModule *module)
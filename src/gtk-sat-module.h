@@ -33,6 +33,10 @@
 #include <gtk/gtkvbox.h>
 #include "gtk-sat-data.h"
 #include "qth-data.h"
+#include "osc-sender.h"
+#include "osc-server.h"
+#include "prop-pool.h"
+#include "sat-state.h"
 
 
 #ifdef __cplusplus
@@ -119,9 +123,16 @@ struct _gtk_sat_module
     qth_t         *qth;          /*!< QTH information. */
 
     GHashTable    *satellites;   /*!< Satellites. */
+    GPtrArray     *satarray;     /*!< The satellites in an array for the workers. */
+    sat_state_t   *satstate;     /*!< Tracking data by index in satarray. */
+    prop_pool_t   *pool;         /*!< Propagation workers, created in the first cycle. */
+    gint           poolcfg;      /*!< Thread setting the pool was created with. */
 
     guint32        timeout;      /*!< Timeout value [msec] */
 
+    osc_sender_t  *osc;          /*!< OSC output of satellite data. */
+    osc_server_t  *oscsrv;       /*!< OSC control server or NULL. */
+
     gtk_sat_mod_state_t  state;   /*!< The state of the module. */
 
     guint          timerid;      /*!< The timeout ID (FIXME: REMOVE) */
@@ -43,6 +43,7 @@
 #include "gtk-sat-data.h"
 #include "compat.h"
 #include "sat-cfg.h"
+#include "sat-db.h"
 #include "gtk-sat-selector.h"
 
 
@@ -52,7 +53,11 @@ static void gtk_sat_selector_init       (GtkSatSelector *selector);
 static void gtk_sat_selector_destroy    (GtkObject *object);
 
 static void create_and_fill_models      (GtkSatSelector *selector);
-static void load_cat_file               (GtkSatSelector *selector, const gchar *fname);
+static GtkListStore *new_store          (void);
+static GtkListStore *load_group         (GtkSatSelector *selector, gint index);
+static void add_db_sat                  (const sat_db_entry_t *entry, gpointer data);
+static void add_db_group                (const gchar *file, const gchar *name,
+                                         gpointer data);
 static void group_selected_cb           (GtkComboBox *combobox, gpointer data);
 static void row_activated_cb            (GtkTreeView *view,
                                          GtkTreePath *path,
@@ -75,12 +80,18 @@ static void epoch_cell_data_function (GtkTreeViewColumn *col,
                                       GtkTreeIter       *iter,
                                       gpointer           column);
 
-static gint cat_file_compare (const gchar *a, const gchar *b);
 static void gtk_sat_selector_mark_engine(GtkSatSelector *selector, gint catnr,gboolean val);
 
 static GtkVBoxClass *parent_class = NULL;
 
 
+/** \brief Store and selection passed to add_db_sat(). */
+typedef struct {
+    GtkListStore *store;
+    GHashTable   *selected;
+} fill_data_t;
+
+
 /** \brief GtkSatSelector signal IDs */
 enum {
     SAT_ACTIVATED_SIGNAL, /*!< "sat-activated" signal */
@@ -185,6 +196,8 @@ static void gtk_sat_selector_class_init (GtkSatSelectorClass *class)
 static void gtk_sat_selector_init (GtkSatSelector *selector)
 {
     selector->models = NULL;
+    selector->catfiles = NULL;
+    selector->selected = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 
@@ -207,6 +220,15 @@ static void gtk_sat_selector_destroy (GtkObject *object)
         selector->models = g_slist_remove (selector->models, data);
     }
 
+    g_slist_foreach (selector->catfiles, (GFunc) g_free, NULL);
+    g_slist_free (selector->catfiles);
+    selector->catfiles = NULL;
+
+    if (selector->selected != NULL) {
+        g_hash_table_destroy (selector->selected);
+        selector->selected = NULL;
+    }
+
 
     (* GTK_OBJECT_CLASS (parent_class)->destroy) (object);
 }
@@ -372,13 +394,15 @@ GtkWidget *gtk_sat_selector_new (guint flags)
 /** \brief Create and fill data store models.
   * \param selector Pointer to the GtkSatSelector widget
   *
-  * this fuinction scan for satellite data and stores them in tree models
-  * that can be displayed in a tree view. The scan is performed in two iterations:
+  * This function reads the satellites and groups from the catalogue
+  * database and stores them in tree models that can be displayed in a tree
+  * view:
   *
-  * (1) First, all .sat files are scanned, read and added to a pseudo-group called
-  *     "all" satellites.
-  * (2) After the first scane, the function scans and reads .cat files and creates
-  *     the groups accordingly.
+  * (1) First, all satellites in the catalogue are added to a pseudo-group
+  *     called "all" satellites.
+  * (2) Then an entry is added for each group (.cat file). The model of a
+  *     group is only filled when the group is selected for the first time,
+  *     see load_group().
   *
   * For each group (including the "all" group) and entry is added to the
   * selector->groups GtkComboBox, where the index of the entry corresponds to
@@ -386,207 +410,115 @@ GtkWidget *gtk_sat_selector_new (guint flags)
   */
 static void create_and_fill_models (GtkSatSelector *selector)
 {
-    GtkListStore *store;    /* the list store data structure */
-    GtkTreeIter   node;     /* new top level node added to the tree store */
-    GDir         *dir;
-    gchar        *dirname;
-    sat_t         sat;
-    gint          catnum;
-
-    gchar       **buffv;
-    const gchar  *fname;
-    gchar        *nfname;
-
-    guint         num = 0;
-    gint          i,n;
-    GSList       *cats = NULL;
-
+    fill_data_t   fill;
+    guint         num;
 
 
     /* load all satellites into selector->models[0] */
-    store = gtk_list_store_new (GTK_SAT_SELECTOR_COL_NUM,
-                                G_TYPE_STRING,    // name
-                                G_TYPE_INT,       // catnum
-                                G_TYPE_DOUBLE,    // epoch
-                                G_TYPE_BOOLEAN    // selected
-                                );
-    selector->models = g_slist_append (selector->models, store);
+    fill.store = new_store ();
+    fill.selected = selector->selected;
+    selector->models = g_slist_append (selector->models, fill.store);
+    selector->catfiles = g_slist_append (selector->catfiles, NULL);
     gtk_combo_box_append_text (GTK_COMBO_BOX (selector->groups), _("All satellites"));
     gtk_combo_box_set_active (GTK_COMBO_BOX (selector->groups), 0);
 
-    dirname = get_satdata_dir ();
-    dir = g_dir_open (dirname, 0, NULL);
-    if (!dir) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s:%s: Failed to open satdata directory %s."),
-                     __FILE__, __FUNCTION__, dirname);
-
-        g_free (dirname);
-
-        return;
-    }
-
-    /* Scan data directory for .sat files.
-       For each file scan through the file and
-       add entry to the tree.
-        */
-    while ((fname = g_dir_read_name (dir))) {
-
-        if (g_str_has_suffix (fname, ".sat")) {
-
-            buffv = g_strsplit (fname, ".", 0);
-            catnum = (gint) g_ascii_strtoll (buffv[0], NULL, 0);
-
-            if (gtk_sat_data_read_sat (catnum, &sat)) {
-                /* error */
-            }
-            else {
-                /* read satellite */
-
-                gtk_list_store_append (store, &node);
-                gtk_list_store_set (store, &node,
-                                    GTK_SAT_SELECTOR_COL_NAME, sat.nickname,
-                                    GTK_SAT_SELECTOR_COL_CATNUM, catnum,
-                                    GTK_SAT_SELECTOR_COL_EPOCH, sat.jul_epoch,
-                                    GTK_SAT_SELECTOR_COL_SELECTED, FALSE,
-                                    -1);
-
-                g_free (sat.name);
-                g_free (sat.nickname);
-                num++;
-            }
+    /* the catalogue passes the satellites sorted by nickname,
+       which makes sorting the store by name cheap later on */
+    num = sat_db_foreach (add_db_sat, &fill);
 
-            g_strfreev (buffv);
-        }
-    }
     sat_log_log (SAT_LOG_LEVEL_MSG,
                  _("%s:%s: Read %d satellites into MAIN group."),
                  __FILE__, __FUNCTION__, num);
 
-    /* load satellites from each .cat file into selector->models[i] */
-    g_dir_rewind (dir);
-    while ((fname = g_dir_read_name (dir))) {
-        if (g_str_has_suffix (fname, ".cat")) {
-            cats = g_slist_insert_sorted(cats,g_strdup(fname),(GCompareFunc)cat_file_compare);
-        }
-    }
+    /* add the groups sorted by name, models are created on demand */
+    num = sat_db_foreach_group (add_db_group, selector);
 
-    /*now load them into the combo box*/
-    n = g_slist_length (cats);
-    for (i = 0; i < n; i++) {
-        nfname = g_slist_nth_data (cats, i);
-        if (nfname) {
-            load_cat_file (selector, nfname);
-        }
-        g_free(nfname);
-    }
-    g_slist_free (cats);
+    sat_log_log (SAT_LOG_LEVEL_MSG,
+                 _("%s:%s: Found %d satellite groups."),
+                 __FILE__, __FUNCTION__, num);
+}
 
-    g_dir_close (dir);
-    g_free (dirname);
 
+/** \brief Create an empty list store for a group. */
+static GtkListStore *new_store (void)
+{
+    return gtk_list_store_new (GTK_SAT_SELECTOR_COL_NUM,
+                               G_TYPE_STRING,    // name
+                               G_TYPE_INT,       // catnum
+                               G_TYPE_DOUBLE,    // epoch
+                               G_TYPE_BOOLEAN    // selected
+                               );
 }
 
 
-
-/** \brief Load satellites from a .cat file
+/** \brief Load the satellites of a group.
   * \param selector Pointer to the GtkSatSelector
-  * \param fname The name of the .cat file (name only, no path)
-  *
-  * This function is used to encapsulate reading the clear text name and the contents
-  * of a .cat file. It is used for building the satellite tree store models
+  * \param index The index of the group in selector->models
+  * \return The new model of the group.
   */
-static void load_cat_file (GtkSatSelector *selector, const gchar *fname)
+static GtkListStore *load_group (GtkSatSelector *selector, gint index)
 {
-    GIOChannel   *catfile;
-    GError       *error = NULL;
-    GtkListStore *store;    /* the list store data structure */
-    GtkTreeIter   node;     /* new top level node added to the tree store */
-
-    gchar        *path;
-    gchar        *buff;
-    sat_t         sat;
-    gint          catnum;
-    guint         num = 0;
-
-
-    /* .cat files contains clear text category name in the first line
-               then one satellite catalog number per line */
-    path = sat_file_name (fname);
-    catfile = g_io_channel_new_file (path, "r", &error);
-    if (error != NULL) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s:%s: Failed to open %s: %s"),
-                     __FILE__, __FUNCTION__, fname, error->message);
-        g_clear_error (&error);
-    }
-    else {
-        /* read first line => category name */
+    fill_data_t  fill;
+    const gchar *fname;
+    guint        num;
 
-        if (g_io_channel_read_line (catfile, &buff, NULL, NULL, NULL) == G_IO_STATUS_NORMAL) {
-            g_strstrip (buff); /* removes trailing newline */
-            gtk_combo_box_append_text (GTK_COMBO_BOX (selector->groups), buff);
-            g_free (buff);
 
-            /* we can safely create the liststore for this category */
-            store = gtk_list_store_new (GTK_SAT_SELECTOR_COL_NUM,
-                                        G_TYPE_STRING,    // name
-                                        G_TYPE_INT,       // catnum
-                                        G_TYPE_DOUBLE,    // epoch
-                                        G_TYPE_BOOLEAN    // selected
-                                        );
-            selector->models = g_slist_append (selector->models, store);
+    fname = g_slist_nth_data (selector->catfiles, index);
 
+    fill.store = new_store ();
+    fill.selected = selector->selected;
+    g_slist_nth (selector->models, index)->data = fill.store;
 
+    num = sat_db_foreach_member (fname, add_db_sat, &fill);
 
-            /* Remaining lines are catalog numbers for satellites.
-               Read line by line until the first error, which hopefully is G_IO_STATUS_EOF
-            */
-            while (g_io_channel_read_line (catfile, &buff, NULL, NULL, NULL) == G_IO_STATUS_NORMAL) {
+    sat_log_log (SAT_LOG_LEVEL_MSG,
+                 _("%s:%s: Read %d satellites from %s"),
+                 __FILE__, __FUNCTION__, num, fname);
 
-                /* stip trailing EOL */
-                g_strstrip (buff);
+    return fill.store;
+}
 
-                /* catalog number to integer */
-                catnum = (gint) g_ascii_strtoll (buff, NULL, 0);
 
-                /* try to read satellite data */
-                if (gtk_sat_data_read_sat (catnum, &sat)) {
-                    /* error */
-                    sat_log_log (SAT_LOG_LEVEL_ERROR,
-                                 _("%s:%s: Error reading satellite %d."),
-                                 __FILE__, __FUNCTION__, catnum);
-                }
-                else {
-                    /* insert satellite into liststore */
-                    gtk_list_store_append (store, &node);
-                    gtk_list_store_set (store, &node,
-                                        GTK_SAT_SELECTOR_COL_NAME, sat.nickname,
-                                        GTK_SAT_SELECTOR_COL_CATNUM, catnum,
-                                        GTK_SAT_SELECTOR_COL_EPOCH, sat.jul_epoch,
-                                        GTK_SAT_SELECTOR_COL_SELECTED, FALSE,
-                                        -1);
-                    g_free (sat.name);
-                    g_free (sat.nickname);
-                    num++;
-                }
+/** \brief Add a satellite from the catalogue to a list store.
+  * \param entry The satellite.
+  * \param data The fill_data_t with the store and the selection.
+  *
+  * The epoch is converted directly from the elements; there is no need to
+  * initialise the satellite just to list it.
+  */
+static void add_db_sat (const sat_db_entry_t *entry, gpointer data)
+{
+    fill_data_t *fill = data;
+    GtkTreeIter  node;
+    gboolean     selected;
 
-                g_free (buff);
-            }
-            sat_log_log (SAT_LOG_LEVEL_MSG,
-                         _("%s:%s: Read %d satellites from %s"),
-                         __FILE__, __FUNCTION__, num, fname);
-        }
-        else {
-            sat_log_log (SAT_LOG_LEVEL_ERROR,
-                         _("%s:%s: Failed to read %s"),
-                         __FILE__, __FUNCTION__, fname);
-        }
 
-    }
+    selected = (g_hash_table_lookup (fill->selected,
+                                     GINT_TO_POINTER (entry->tle.catnr)) != NULL);
+
+    gtk_list_store_append (fill->store, &node);
+    gtk_list_store_set (fill->store, &node,
+                        GTK_SAT_SELECTOR_COL_NAME, entry->nickname,
+                        GTK_SAT_SELECTOR_COL_CATNUM, entry->tle.catnr,
+                        GTK_SAT_SELECTOR_COL_EPOCH, Julian_Date_of_Epoch (entry->tle.epoch),
+                        GTK_SAT_SELECTOR_COL_SELECTED, selected,
+                        -1);
+}
+
+
+/** \brief Add a group from the catalogue to the group selector.
+  * \param file The name of the .cat file.
+  * \param name The name of the group.
+  * \param data Pointer to the GtkSatSelector.
+  */
+static void add_db_group (const gchar *file, const gchar *name, gpointer data)
+{
+    GtkSatSelector *selector = GTK_SAT_SELECTOR (data);
 
-    g_free (path);
-    g_io_channel_shutdown (catfile, TRUE, NULL);
+
+    gtk_combo_box_append_text (GTK_COMBO_BOX (selector->groups), name);
+    selector->models = g_slist_append (selector->models, NULL);
+    selector->catfiles = g_slist_append (selector->catfiles, g_strdup (file));
 }
 
 
@@ -652,6 +584,8 @@ static void group_selected_cb (GtkComboBox *combobox, gpointer data)
 
     /* now replace oldmodel with newmodel */
     newmodel = GTK_TREE_MODEL (g_slist_nth_data (selector->models, sel));
+    if (newmodel == NULL)
+        newmodel = GTK_TREE_MODEL (load_group (selector, sel));
 
     /* We changed the GtkTreeModel so we need to reset the sort column ID */
     gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (newmodel),
@@ -852,61 +786,6 @@ gdouble gtk_sat_selector_get_latest_epoch (GtkSatSelector *selector)
 }
 
 
-/** \brief Load category name from a .cat file
- *  \param fname The name of the .cat file (name only, no path)
- *  This function is a stripped down version of load_cat_file.  It 
- *  is needed to load the category name to created a sorted list 
- *  of category names. With the existing user base already having 
- *  .cat files in their directories, use of the file name directly 
- *  for sorting will have problems.
- */
-static gchar *load_cat_file_cat (const gchar *fname)
-{
-    GIOChannel   *catfile;
-    GError       *error = NULL;
-
-    gchar        *path;
-    gchar        *buff;
-
-    /* .cat files contains clear text category name in the first line
-               then one satellite catalog number per line */
-    path = sat_file_name (fname);
-    catfile = g_io_channel_new_file (path, "r", &error);
-    if (error != NULL) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s:%s: Failed to open %s: %s"),
-                     __FILE__, __FUNCTION__, fname, error->message);
-        g_clear_error (&error);
-    }
-    else {
-        /* read first line => category name */
-        
-        if (g_io_channel_read_line (catfile, &buff, NULL, NULL, NULL) == G_IO_STATUS_NORMAL) {
-            g_strstrip (buff); /* removes trailing newline */
-        }
-    }
-    
-    g_free (path);
-    g_io_channel_shutdown (catfile, TRUE, NULL);
-    return buff;
-}
-
-/* this is a quick function that loads the category name from two cat 
-   files and compares them. 
-*/
-gint cat_file_compare (const gchar *a,const gchar *b){
-    gchar *cat_a, *cat_b;
-    gint temp;
-    
-    cat_a = load_cat_file_cat (a);
-    cat_b = load_cat_file_cat (b);
-    temp = g_ascii_strcasecmp (cat_a,cat_b);
-    g_free (cat_a);
-    g_free (cat_b);
-    return (temp);
-        
-}
-
 /** \brief Make the tree refilter after something entered in the search box
  **/
 
@@ -955,10 +834,18 @@ static void gtk_sat_selector_mark_engine(GtkSatSelector *selector, gint catnr,gb
     GtkTreeModel *model;
     GtkTreeIter iter;
 
+    /* remembered for the groups that have not been loaded yet */
+    if (val)
+        g_hash_table_insert (selector->selected, GINT_TO_POINTER (catnr), GINT_TO_POINTER (1));
+    else
+        g_hash_table_remove (selector->selected, GINT_TO_POINTER (catnr));
+
     nummodels = g_slist_length(selector->models);
 
     for (n = 0; n<nummodels; n++) {
         model = GTK_TREE_MODEL(g_slist_nth_data (selector->models,n));
+        if (model == NULL)
+            continue;
         numiters = gtk_tree_model_iter_n_children(model,NULL);
         for (k = 0; k<numiters; k++){
             if (G_LIKELY(gtk_tree_model_iter_nth_child(model, &iter,NULL,k))){                    
@@ -88,7 +88,10 @@ struct _gtk_sat_selector
 
     GtkWidget   *groups;      /*!< Combo box for selecting satellite group. */
     GtkWidget   *search;      /*!< Text entry for searching. */
-    GSList      *models;      /*!< List of models with index corresponding to groups. */
+    GSList      *models;      /*!< List of models with index corresponding to groups,
+                                   NULL until the group is first selected. */
+    GSList      *catfiles;    /*!< .cat file names with index corresponding to groups. */
+    GHashTable  *selected;    /*!< Catalogue numbers of the selected satellites. */
 };
 
 struct _GtkSatSelectorClass
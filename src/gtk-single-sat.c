@@ -117,6 +117,7 @@ static void update_field            (GtkSingleSat *ssat, guint i);
 static void Calculate_RADec         (sat_t *sat, qth_t *qth, obs_astro_t *obs_set);
 static void gtk_single_sat_popup_cb (GtkWidget *button, gpointer data);
 static void select_satellite        (GtkWidget *menuitem, gpointer data);
+static void set_selected            (GtkSingleSat *ssat, guint i);
 static void show_next_pass_cb       (GtkWidget *menuitem, gpointer data);
 static void show_next_passes_cb     (GtkWidget *menuitem, gpointer data);
 static gint sat_name_compare (sat_t *a,sat_t *b);
@@ -922,22 +923,54 @@ select_satellite        (GtkWidget *menuitem, gpointer data)
 {
     GtkSingleSat *ssat = GTK_SINGLE_SAT (data);
     guint i = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (menuitem), "index"));
-    gchar *title;
-    sat_t *sat;
 
 
     /* there are many "ghost"-trigging of this signal, but we only need to make
        a new selection when the received menuitem is selected
     */
     if (gtk_check_menu_item_get_active (GTK_CHECK_MENU_ITEM (menuitem))) {
-        ssat->selected = i;
+        set_selected (ssat, i);
+    }
+}
+
+
+/** \brief Select a satellite by its index and update the header. */
+static void
+set_selected            (GtkSingleSat *ssat, guint i)
+{
+    gchar *title;
+    sat_t *sat;
+
 
-        sat = SAT (g_slist_nth_data (ssat->sats, i));
+    ssat->selected = i;
 
-        title = g_strdup_printf ("<b>%s</b>", sat->nickname);
-        gtk_label_set_markup (GTK_LABEL (ssat->header), title);
-        g_free (title);
+    sat = SAT (g_slist_nth_data (ssat->sats, i));
 
+    title = g_strdup_printf ("<b>%s</b>", sat->nickname);
+    gtk_label_set_markup (GTK_LABEL (ssat->header), title);
+    g_free (title);
+}
+
+
+/** \brief Select a satellite.
+ *  \param single_sat The GtkSingleSat widget.
+ *  \param catnum The catalogue number of the satellite.
+ *
+ * Nothing happens if the satellite is not in the view.
+ */
+void
+gtk_single_sat_select_sat (GtkWidget *single_sat, gint catnum)
+{
+    GtkSingleSat *ssat = GTK_SINGLE_SAT (single_sat);
+    GSList       *node;
+    guint         i;
+
+
+    for (node = ssat->sats, i = 0; node != NULL; node = node->next, i++) {
+        if (SAT (node->data)->tle.catnr == catnum) {
+            set_selected (ssat, i);
+            break;
+        }
     }
 }
 
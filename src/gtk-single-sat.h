@@ -166,6 +166,7 @@ void           gtk_single_sat_reconf          (GtkWidget  *widget,
 
 
 void gtk_single_sat_reload_sats (GtkWidget *single_sat, GHashTable *sats);
+void gtk_single_sat_select_sat  (GtkWidget *single_sat, gint catnum);
 
 
 #ifdef __cplusplus
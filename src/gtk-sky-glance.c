@@ -105,7 +105,8 @@ static gboolean on_mouse_leave         (GooCanvasItem    *item,
 static GooCanvasItemModel* create_canvas_model (GtkSkyGlance *skg);
 
 
-static void create_sat (gpointer key, gpointer value, gpointer data);
+static void create_sat (guint index, sat_t *sat, GSList *passes, gpointer data);
+static void update_layout (gpointer job, gpointer data);
 
 static gdouble t2x (GtkSkyGlance *skg, gdouble t);
 static gdouble x2t (GtkSkyGlance *skg, gdouble x);
@@ -182,6 +183,7 @@ gtk_sky_glance_init (GtkSkyGlance *skg)
     skg->satcnt    = 0;
     skg->ts        = 0.0;
     skg->te        = 0.0;
+    skg->job       = NULL;
 }
 
 
@@ -200,6 +202,10 @@ gtk_sky_glance_destroy (GtkObject *object)
     guint   i, n;
 
 
+    /* stop pass predictions that are still running */
+    pass_job_cancel (GTK_SKY_GLANCE (object)->job);
+    GTK_SKY_GLANCE (object)->job = NULL;
+
     /* free passes */
     /* FIXME: TBC whether this is enough */
     if (GTK_SKY_GLANCE (object)->passes != NULL) {
@@ -319,8 +325,11 @@ gtk_sky_glance_new (GHashTable *sats, qth_t *qth, gdouble ts)
 
     g_object_unref (root);
 
-    /* add satellite passes */
-    g_hash_table_foreach (GTK_SKY_GLANCE (skg)->sats, create_sat, skg);
+    /* add satellite passes as they are predicted */
+    GTK_SKY_GLANCE (skg)->job = pass_job_new (sats, qth,
+                                              GTK_SKY_GLANCE (skg)->ts,
+                                              GTK_SKY_GLANCE (skg)->te - GTK_SKY_GLANCE (skg)->ts,
+                                              10, create_sat, update_layout, skg);
 
     gtk_container_add (GTK_CONTAINER (skg), GTK_SKY_GLANCE (skg)->canvas);
 
@@ -973,23 +982,40 @@ static void get_colours (guint i, guint *bcol, guint *fcol)
 }
 
 
+/** \brief Position the canvas items after new satellites have been added.
+ *  \param job The pass prediction job.
+ *  \param data Pointer to the GtkSkyGlance object.
+ *
+ * This function is called by the pass prediction job after each batch of
+ * satellites. The new items are created with dummy coordinates, so the
+ * layout is recalculated like after a resize.
+ */
+static void
+update_layout (gpointer job, gpointer data)
+{
+    GtkSkyGlance *skg = GTK_SKY_GLANCE (data);
+
+
+    on_canvas_realized (skg->canvas, skg);
+}
+
+
 /** \brief Create canvas items for a satellite
- *  \param key Pointer to the hash key (catnum of sat)
- *  \param value Pointer to the current satellite.
+ *  \param index The index of the satellite in the pass prediction job.
+ *  \param sat Pointer to the current satellite.
+ *  \param passes The passes of the satellite within the time window.
  *  \param data Pointer to the GtkSkyGlance object.
  *
- * This function is called by g_hash_table_foreach with each satellite in the
- * satellite hash table. It gets the passes for the current satellite and creates
- * the corresponding canvas items.
+ * This function is called by the pass prediction job with each satellite in
+ * the satellite hash table, in hash table order, once its passes have been
+ * predicted. It creates the corresponding canvas items and frees the passes.
  */
 static void
-create_sat (gpointer key, gpointer value, gpointer data)
+create_sat (guint index, sat_t *sat, GSList *passes, gpointer data)
 {
-    sat_t              *sat = SAT(value);
     GtkSkyGlance       *skg = GTK_SKY_GLANCE(data);
-    GSList             *passes = NULL;
     gdouble             maxdt;
-    guint               i,n,num;
+    guint               i,j,n,num;
     pass_t             *tmppass = NULL;
     sky_pass_t         *skypass;
     pass_detail_t     *detail;
@@ -1020,8 +1046,6 @@ create_sat (gpointer key, gpointer value, gpointer data)
 
     maxdt = skg->te - skg->ts;
 
-    /* get passes for satellite */
-    passes = get_passes (sat, skg->qth, skg->ts, maxdt, 10); 
     n = g_slist_length (passes);
     sat_log_log (SAT_LOG_LEVEL_DEBUG,
                     _("%s:%d: %s has %d passes within %.4f days\n"),
@@ -1091,17 +1115,17 @@ create_sat (gpointer key, gpointer value, gpointer data)
     	            if (lo_send(t, "/gpredict/pass", "siiiiiii", skypass->pass->satname, jul_to_time_t(skypass->pass->aos), (int)skypass->pass->aos_az, 
                     jul_to_time_t(skypass->pass->tca), (int)skypass->pass->maxel_az, (int)skypass->pass->max_el, jul_to_time_t(skypass->pass->los), (int)skypass->pass->los_az) == -1)
 		                printf("OSC error %d: %s\n", lo_address_errno(t), lo_address_errstr(t));
-                    num = g_slist_length (skypass->pass->details);
+                    num = skypass->pass->num_details;
                     /* sending the details of each pass */
-                    for (i = 0; i < num; i++) {
+                    for (j = 0; j < num; j++) {
 
                     	//float doppler = -100.0e06 * (detail->range_rate / 299792.4580); // Hz
 
 
-                        detail = PASS_DETAIL(g_slist_nth_data (skypass->pass->details, i));
+                        detail = &skypass->pass->detail[j];
                         if (lo_send(t, "/gpredict/pass/detail", "iiii",jul_to_time_t(detail->time), (int)detail->az, (int)detail->el, (int)(detail->range_rate * 100.)) == -1)
                             printf("OSC error %d: %s\n", lo_address_errno(t), lo_address_errstr(t));
-                        //printf("detail: %d, time: %f\n", i, detail->time);
+                        //printf("detail: %d, time: %f\n", j, detail->time);
                     }
                     lo_address_free (t);
                 }
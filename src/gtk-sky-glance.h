@@ -35,6 +35,7 @@
 #include <gtk/gtkvbox.h>
 #include "gtk-sat-data.h"
 #include "predict-tools.h"
+#include "pass-job.h"
 #include <goocanvas.h>
 
 
@@ -96,6 +97,8 @@ struct _GtkSkyGlance
                             */
     gdouble     ts,te;    /*!< Start and end times (Julian date) */
 
+    pass_job_t *job;      /*!< Pass prediction delivering the satellites. */
+
     GSList     *majors;   /*!< Major ticks for every hour */
     GSList     *minors;   /*!< Minor ticks for every 30 min */
     GSList     *labels;   /*!< Tick labels for every hour */
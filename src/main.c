@@ -47,6 +47,9 @@
 #include "sat-cfg.h"
 #include "gtk-sat-selector.h"
 #include "sat-debugger.h"
+#include "pass-cache.h"
+#include "ephem-cache.h"
+#include "sat-db.h"
 
 #ifdef WIN32
 #include <winsock2.h>
@@ -352,6 +355,7 @@ static void
 gpredict_app_destroy    (GtkWidget *widget,
                          gpointer   data)
 {
+    guint hits, misses;
 
     /* stop TLE monitoring task */
     tle_mon_stop ();
@@ -369,6 +373,13 @@ gpredict_app_destroy    (GtkWidget *widget,
                 sat_cfg_set_int (SAT_CFG_INT_WINDOW_HEIGHT, h);
         */
     sat_cfg_save ();
+    pass_cache_clear ();
+    ephem_cache_stats (&hits, &misses);
+    sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                 _("%s: Ephemeris cache: %u hits, %u misses"),
+                 __FUNCTION__, hits, misses);
+    ephem_cache_clear ();
+    sat_db_close ();
     sat_log_close ();
     sat_cfg_close ();
 
@@ -39,6 +39,7 @@
 #include "sat-pref-modules.h"
 #include "qth-editor.h"
 #include "mod-cfg.h"
+#include "sat-db.h"
 
 #include "gtk-sat-selector.h"
 
@@ -66,6 +67,7 @@ static void       edit_advanced_settings (GtkDialog *parent, GKeyFile *cfgdata);
 
 static GtkWidget *create_selected_sats_list (GKeyFile *cfgdata, gboolean new, GtkSatSelector *selector);
 static void add_selected_sat (GtkListStore *store, gint catnum);
+static void add_db_sat (const sat_db_entry_t *entry, gpointer data);
 
 static void sat_activated_cb (GtkSatSelector *selector, gint catnr, gpointer data);
 
@@ -708,10 +710,8 @@ static void add_selected_sat (GtkListStore *store, gint catnum)
 {
     gint        i, sats = 0;
     GtkTreeIter iter;
-    GtkTreeIter node;     /* new top level node added to the tree store */
     gint        catnr;
     gboolean    found = FALSE;
-    sat_t       sat;
 
 
     /* check if the satellite is already in the list */
@@ -742,24 +742,31 @@ static void add_selected_sat (GtkListStore *store, gint catnum)
 
     /* if we have made it so far, satellite is not in list */
 
-    /* Get satellite data */
-    if (gtk_sat_data_read_sat (catnum, &sat)) {
+    /* Get satellite data and insert it into the liststore */
+    if (!sat_db_lookup (catnum, add_db_sat, store)) {
         /* error */
         sat_log_log (SAT_LOG_LEVEL_ERROR,
                      _("%s:%s: Error reading satellite %d."),
                      __FILE__, __FUNCTION__, catnum);
     }
-    else {
-        /* insert satellite into liststore */
-        gtk_list_store_append (store, &node);
-        gtk_list_store_set (store, &node,
-                            GTK_SAT_SELECTOR_COL_NAME, sat.nickname,
-                            GTK_SAT_SELECTOR_COL_CATNUM, catnum,
-                            GTK_SAT_SELECTOR_COL_EPOCH, sat.jul_epoch,
-                            -1);
-        g_free (sat.name);
-        g_free (sat.nickname);
-    }
+}
+
+
+/** \brief Insert a satellite from the catalogue into the list of selected satellites.
+  * \param entry The satellite.
+  * \param data Pointer to the GtkListStore.
+  */
+static void add_db_sat (const sat_db_entry_t *entry, gpointer data)
+{
+    GtkTreeIter node;
+
+
+    gtk_list_store_append (GTK_LIST_STORE (data), &node);
+    gtk_list_store_set (GTK_LIST_STORE (data), &node,
+                        GTK_SAT_SELECTOR_COL_NAME, entry->nickname,
+                        GTK_SAT_SELECTOR_COL_CATNUM, entry->tle.catnr,
+                        GTK_SAT_SELECTOR_COL_EPOCH, Julian_Date_of_Epoch (entry->tle.epoch),
+                        -1);
 }
 
 
@@ -0,0 +1,1088 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2010  Alexandru Csete, OZ9AEC.
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \brief OSC output of satellite data.
+ *
+ * Each GtkSatModule owns one osc_sender_t which holds the liblo addresses
+ * of the receivers (sinks) and the pre-built OSC paths of the satellites in
+ * the module. The address and the paths live as long as the module (or until
+ * the satellites are reloaded) and are reused on every timeout cycle.
+ *
+ * The satellites are sent once per cycle by the module timeout callback:
+ *
+ *   osc_sender_begin (sender, daynum);
+ *   osc_sender_add_state (sender, state);
+ *   osc_sender_end (sender);
+ *
+ * osc_sender_add_state() only copies the data into a frame; the frame is
+ * queued by osc_sender_end() and transmitted by a separate sender thread.
+ * The queue is a lock-free single-producer / single-consumer ring: the
+ * module thread only writes head, the sender thread only writes tail.
+ * The wake mutex is only used to put the idle sender thread to sleep and
+ * the data mutex only to keep the thread out while the satellites are
+ * reloaded.
+ *
+ * If SAT_CFG_BOOL_OSC_BUNDLE is set, the messages are collected into one
+ * bundle (or several, if they do not fit into OSC_SENDER_MAX_BUNDLE_SIZE)
+ * time tagged with the simulated time of the cycle. This way the receiver
+ * gets a coherent snapshot of all satellites with a few datagrams instead
+ * of one datagram per satellite.
+ *
+ * The sender thread builds the OSC message of each satellite once and
+ * then fans it out to all sinks whose filter accepts the satellite: the
+ * message is added to the bundle of each of these sinks, or sent to each
+ * of them directly when bundles are not used.
+ *
+ * The fields sent for each satellite are selected by SAT_CFG_INT_OSC_FIELDS
+ * and sent in single or, if SAT_CFG_BOOL_OSC_DOUBLE is set, double
+ * precision. The resulting layout (osc_format_t) is only rebuilt when the
+ * configuration changes. If SAT_CFG_BOOL_OSC_BLOB is set, the satellites
+ * are not sent as individual messages but packed as binary records into
+ * the blob of OSC_SENDER_BLOB_PATH messages with the arguments
+ *
+ *   s: the type tags of a record, e.g. "iffff"
+ *   b: the records in network byte order
+ *
+ * where each record starts with the catalogue number. Blob messages are
+ * split at OSC_SENDER_MAX_BUNDLE_SIZE just like bundles.
+ *
+ * The sender thread keeps the last state sent of each satellite and skips
+ * satellites that have not changed by more than the configured deadbands
+ * (SAT_CFG_INT_OSC_DB_*), unless the heartbeat interval has passed since
+ * they were last sent. This way the traffic depends on how many satellites
+ * actually move (i.e. are visible and close) rather than on the number of
+ * satellites in the module.
+ */
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <math.h>
+#include <string.h>
+#ifdef HAVE_CONFIG_H
+#  include <build-config.h>
+#endif
+#include "sat-log.h"
+#include "sat-cfg.h"
+#include "osc-sender.h"
+
+
+/** \brief Julian date of the NTP epoch (1900-01-01 00:00 UTC). */
+#define NTP_EPOCH_JD 2415020.5
+
+/** \brief Size of the bundle header ("#bundle" and the time tag). */
+#define BUNDLE_HEADER_SIZE 16
+
+/** \brief Upper limit of the size of a blob message without the records.
+ *
+ * Path, type tags, record type tag string, blob size and, when bundled,
+ * the bundle header and element size.
+ */
+#define BLOB_MSG_OVERHEAD 64
+
+
+static osc_sink_t  *sink_new      (const gchar *spec);
+static void         sink_free     (osc_sink_t *sink);
+static void         sink_set_sats (osc_sink_t *sink, osc_sender_t *sender);
+static gpointer     sender_thread (gpointer data);
+static void         alloc_frames  (osc_sender_t *sender);
+static void         free_frames   (osc_sender_t *sender);
+static void         clear_frame   (osc_sender_t *sender, osc_frame_t *frame);
+static void         send_frame    (osc_sender_t *sender, osc_frame_t *frame);
+static void         send_state    (osc_sender_t *sender, osc_frame_t *frame,
+                                   guint idx, lo_timetag tt);
+static gboolean     state_changed (osc_sender_t *sender, osc_frame_t *frame,
+                                   guint idx, gdouble now);
+static void         flush_bundle  (osc_sender_t *sender, osc_sink_t *sink);
+static void         flush_blob    (osc_sender_t *sender, osc_sink_t *sink,
+                                   osc_frame_t *frame, lo_timetag tt);
+static lo_message   new_message   (osc_format_t *format,
+                                   osc_sat_state_t *state);
+static void         pack_record   (osc_format_t *format,
+                                   osc_sat_state_t *state, guint8 *buf);
+static void         format_init   (osc_format_t *format, guint32 mask,
+                                   gboolean dbl, gboolean blob);
+static void         check_error   (osc_sender_t *sender, osc_sink_t *sink,
+                                   gint retcode, guint n);
+static lo_timetag   daynum_to_tt  (gdouble daynum);
+
+
+/** \brief Create a new OSC sender.
+ *  \param sinks The sink configuration; see osc_sink_t for the format.
+ *  \return A newly allocated osc_sender_t or NULL if none of the sinks
+ *          could be created. Free it with osc_sender_free().
+ *
+ * If the sender thread can not be started, the frames are sent directly
+ * from osc_sender_end().
+ */
+osc_sender_t *
+osc_sender_new (const gchar *sinks)
+{
+    osc_sender_t *sender;
+    osc_sink_t   *sink;
+    gchar       **specs;
+    GError       *err = NULL;
+    guint         i;
+
+
+    sender = g_new0 (osc_sender_t, 1);
+    sender->sinks = g_ptr_array_new ();
+
+    specs = g_strsplit (sinks, OSC_SENDER_SINK_SEP, 0);
+    for (i = 0; specs[i] != NULL; i++) {
+
+        g_strstrip (specs[i]);
+        if (specs[i][0] == '\0')
+            continue;
+
+        sink = sink_new (specs[i]);
+        if (sink)
+            g_ptr_array_add (sender->sinks, sink);
+    }
+    g_strfreev (specs);
+
+    if (sender->sinks->len == 0) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: No valid OSC sinks in %s"),
+                     __FUNCTION__, sinks);
+        g_ptr_array_free (sender->sinks, TRUE);
+        g_free (sender);
+
+        return NULL;
+    }
+
+    sender->catnr = NULL;
+    sender->paths = g_ptr_array_new ();
+    sender->nsats = 0;
+
+    sender->policy = OSC_QUEUE_COALESCE;
+    sender->pending = FALSE;
+    sender->head = 0;
+    sender->tail = 0;
+    alloc_frames (sender);
+
+    format_init (&sender->format, OSC_FIELDS_DEFAULT, FALSE, FALSE);
+    sender->msgs = g_ptr_array_new ();
+    sender->record = g_malloc (sizeof (gint32) +
+                               OSC_FIELD_NUMBER * sizeof (gdouble));
+
+    sender->wake_lock = g_mutex_new ();
+    sender->wake = g_cond_new ();
+    sender->data_lock = g_mutex_new ();
+    sender->quit = FALSE;
+
+    sender->thread = g_thread_create (sender_thread, sender, TRUE, &err);
+    if (sender->thread == NULL) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: Failed to create OSC sender thread (%s). "\
+                       "Sending from the module instead."),
+                     __FUNCTION__, err->message);
+        g_clear_error (&err);
+    }
+
+    return sender;
+}
+
+
+/** \brief Stop the sender thread and free the sender. */
+void
+osc_sender_free (osc_sender_t *sender)
+{
+    guint sent,dropped,coalesced,suppressed;
+
+
+    if (sender == NULL)
+        return;
+
+    /* stop sender thread; frames still in the queue are discarded */
+    if (sender->thread) {
+        g_mutex_lock (sender->wake_lock);
+        g_atomic_int_set (&sender->quit, TRUE);
+        g_cond_signal (sender->wake);
+        g_mutex_unlock (sender->wake_lock);
+
+        g_thread_join (sender->thread);
+        sender->thread = NULL;
+    }
+
+    osc_sender_get_stats (sender, &sent, &dropped, &coalesced, &suppressed);
+    sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                 _("%s: OSC states sent: %u, dropped: %u, coalesced: %u, "\
+                   "suppressed: %u"),
+                 __FUNCTION__, sent, dropped, coalesced, suppressed);
+
+    g_mutex_free (sender->wake_lock);
+    g_cond_free (sender->wake);
+    g_mutex_free (sender->data_lock);
+
+    g_ptr_array_free (sender->msgs, TRUE);
+    g_free (sender->record);
+
+    free_frames (sender);
+    g_ptr_array_foreach (sender->paths, (GFunc) g_free, NULL);
+    g_ptr_array_free (sender->paths, TRUE);
+    g_free (sender->catnr);
+
+    g_ptr_array_foreach (sender->sinks, (GFunc) sink_free, NULL);
+    g_ptr_array_free (sender->sinks, TRUE);
+
+    g_free (sender);
+}
+
+
+/** \brief Take over the satellite indices and build the OSC paths.
+ *  \param sender The OSC sender.
+ *  \param state The state table of the module.
+ *
+ * This function must be called whenever the satellites of the module have
+ * been (re)loaded. The sender uses the dense satellite index of the state
+ * table. It waits for the sender thread to finish the frame it is sending
+ * and discards the queue, since the satellite indices change.
+ */
+void
+osc_sender_set_sats (osc_sender_t *sender, sat_state_t *state)
+{
+    guint i;
+
+
+    g_return_if_fail ((sender != NULL) && (state != NULL));
+
+    g_mutex_lock (sender->data_lock);
+
+    free_frames (sender);
+    g_ptr_array_foreach (sender->paths, (GFunc) g_free, NULL);
+    g_ptr_array_set_size (sender->paths, 0);
+
+    sender->nsats = state->nsats;
+    g_free (sender->catnr);
+    sender->catnr = g_memdup (state->catnr, MAX (state->nsats, 1) * sizeof (gint));
+
+    for (i = 0; i < sender->nsats; i++)
+        g_ptr_array_add (sender->paths,
+                         g_strdup_printf ("%s%d", OSC_SENDER_SAT_PATH,
+                                          sender->catnr[i]));
+
+    alloc_frames (sender);
+    g_ptr_array_foreach (sender->sinks, (GFunc) sink_set_sats, sender);
+    sender->pending = FALSE;
+    g_atomic_int_set (&sender->head, 0);
+    g_atomic_int_set (&sender->tail, 0);
+
+    g_mutex_unlock (sender->data_lock);
+}
+
+
+/** \brief Start a new cycle.
+ *  \param sender The OSC sender.
+ *  \param daynum The (simulated) time of the cycle.
+ *
+ * This function reads the bundle mode, the message layout, the deadbands
+ * and the queue policy from the configuration so that they can be changed while the
+ * module is running. The layout is only rebuilt if it has changed.
+ */
+void
+osc_sender_begin (osc_sender_t *sender, gdouble daynum)
+{
+    guint32  mask;
+    gboolean dbl,blob;
+
+
+    g_return_if_fail (sender != NULL);
+
+    mask = (guint32) sat_cfg_get_int (SAT_CFG_INT_OSC_FIELDS);
+    dbl = sat_cfg_get_bool (SAT_CFG_BOOL_OSC_DOUBLE);
+    blob = sat_cfg_get_bool (SAT_CFG_BOOL_OSC_BLOB);
+
+    if ((mask != sender->format.mask) || (dbl != sender->format.dbl) ||
+        (blob != sender->format.blob)) {
+        format_init (&sender->format, mask, dbl, blob);
+        sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                     _("%s: OSC format changed to %s (%s)"),
+                     __FUNCTION__, sender->format.typetag,
+                     blob ? "blob" : "messages");
+    }
+
+    sender->policy = sat_cfg_get_int (SAT_CFG_INT_OSC_QUEUE_POLICY);
+    sender->staging.daynum = daynum;
+    sender->staging.bundle = sat_cfg_get_bool (SAT_CFG_BOOL_OSC_BUNDLE);
+    sender->staging.format = sender->format;
+
+    /* the deadbands are stored in mdeg, m, m/s and msec */
+    sender->staging.deadband.angle =
+        sat_cfg_get_int (SAT_CFG_INT_OSC_DB_ANGLE) / 1000.0;
+    sender->staging.deadband.alt =
+        sat_cfg_get_int (SAT_CFG_INT_OSC_DB_ALT) / 1000.0;
+    sender->staging.deadband.rate =
+        sat_cfg_get_int (SAT_CFG_INT_OSC_DB_RATE) / 1000.0;
+    sender->staging.deadband.heartbeat =
+        sat_cfg_get_int (SAT_CFG_INT_OSC_HEARTBEAT) / 1000.0;
+}
+
+
+/** \brief Add the current state of all satellites to the cycle.
+ *  \param sender The OSC sender.
+ *  \param state The state table of the module.
+ *
+ * This function only copies the data into the staging frame, scanning the
+ * columns of the state table. If the staging frame still holds states
+ * from a previous cycle that could not be queued, they are replaced
+ * (coalesced).
+ */
+void
+osc_sender_add_state (osc_sender_t *sender, sat_state_t *state)
+{
+    osc_sat_state_t *sats;
+    gdouble          daynum;
+    guint            i;
+
+
+    g_return_if_fail ((sender != NULL) && (state != NULL));
+
+    if G_UNLIKELY(state->nsats != sender->nsats) {
+        /* satellites were reloaded without calling osc_sender_set_sats */
+        g_atomic_int_add (&sender->dropped, state->nsats);
+        return;
+    }
+
+    sats = sender->staging.sats;
+    daynum = sender->staging.daynum;
+
+    for (i = 0; i < sender->nsats; i++) {
+        if (sender->staging.valid[i])
+            g_atomic_int_inc (&sender->coalesced);
+
+        /* copying all fields is cheaper than checking the mask */
+        sats[i].catnr = state->catnr[i];
+        sats[i].val[OSC_FIELD_AZ] = state->az[i];
+        sats[i].val[OSC_FIELD_EL] = state->el[i];
+        sats[i].val[OSC_FIELD_ALT] = state->alt[i];
+        sats[i].val[OSC_FIELD_VEL] = state->velo[i];
+        sats[i].val[OSC_FIELD_RANGE] = state->range[i];
+        sats[i].val[OSC_FIELD_RANGE_RATE] = state->range_rate[i];
+        sats[i].val[OSC_FIELD_LAT] = state->ssplat[i];
+        sats[i].val[OSC_FIELD_LON] = state->ssplon[i];
+        sats[i].val[OSC_FIELD_FOOTPRINT] = state->footprint[i];
+        sats[i].val[OSC_FIELD_DOPPLER] =
+            -100.0e06 * (state->range_rate[i] / 299792.4580);
+        sats[i].val[OSC_FIELD_AOS] = (state->aos[i] > 0.0) ?
+            (state->aos[i] - daynum) * 86400.0 : 0.0;
+        sats[i].val[OSC_FIELD_LOS] = (state->los[i] > 0.0) ?
+            (state->los[i] - daynum) * 86400.0 : 0.0;
+        sats[i].val[OSC_FIELD_ORBIT] = (gdouble) state->orbit[i];
+
+        sender->staging.valid[i] = TRUE;
+    }
+
+    if (sender->nsats)
+        sender->pending = TRUE;
+}
+
+
+/** \brief Finish the current cycle and queue the frame.
+ *  \param sender The OSC sender.
+ *
+ * The staging frame is swapped with the free slot at the head of the ring
+ * and the sender thread is woken up. If the ring is full, the staging frame
+ * is either kept for the next cycle or dropped, depending on the policy.
+ */
+void
+osc_sender_end (osc_sender_t *sender)
+{
+    osc_frame_t *slot;
+    osc_frame_t  tmp;
+    gint         head;
+    guint        i;
+
+
+    g_return_if_fail (sender != NULL);
+
+    if (!sender->pending)
+        return;
+
+    if (sender->thread == NULL) {
+        send_frame (sender, &sender->staging);
+        clear_frame (sender, &sender->staging);
+        sender->pending = FALSE;
+        return;
+    }
+
+    head = g_atomic_int_get (&sender->head);
+
+    if (head - g_atomic_int_get (&sender->tail) >= OSC_SENDER_QUEUE_LEN) {
+        /* the sender thread is behind */
+        if (sender->policy == OSC_QUEUE_DROP) {
+            for (i = 0; i < sender->nsats; i++)
+                if (sender->staging.valid[i])
+                    g_atomic_int_inc (&sender->dropped);
+
+            clear_frame (sender, &sender->staging);
+            sender->pending = FALSE;
+        }
+
+        /* else keep the staging frame and update it in the next cycle */
+        return;
+    }
+
+    /* the slot is not used by the sender thread; swap buffers */
+    slot = &sender->ring[head % OSC_SENDER_QUEUE_LEN];
+    tmp = *slot;
+    *slot = sender->staging;
+    sender->staging = tmp;
+    clear_frame (sender, &sender->staging);
+    sender->pending = FALSE;
+
+    /* publish the frame, then wake up the sender thread */
+    g_atomic_int_set (&sender->head, head + 1);
+
+    g_mutex_lock (sender->wake_lock);
+    g_cond_signal (sender->wake);
+    g_mutex_unlock (sender->wake_lock);
+}
+
+
+/** \brief Get the transmit statistics.
+ *  \param sender The OSC sender.
+ *  \param sent Return value for the number of satellite states sent.
+ *  \param dropped Return value for the number of states dropped because
+ *                 of the queue policy or because sending failed.
+ *  \param coalesced Return value for the number of states that have been
+ *                   replaced by a newer state before being sent.
+ *  \param suppressed Return value for the number of states that have not
+ *                    been sent because they were within the deadbands.
+ */
+void
+osc_sender_get_stats (osc_sender_t *sender, guint *sent,
+                      guint *dropped, guint *coalesced, guint *suppressed)
+{
+    g_return_if_fail (sender != NULL);
+
+    *sent = (guint) g_atomic_int_get (&sender->sent);
+    *dropped = (guint) g_atomic_int_get (&sender->dropped);
+    *coalesced = (guint) g_atomic_int_get (&sender->coalesced);
+    *suppressed = (guint) g_atomic_int_get (&sender->suppressed);
+}
+
+
+/** \brief The sender thread.
+ *
+ * Waits for queued frames and sends them. The data mutex is held while a
+ * frame is being sent so that osc_sender_set_sats() can safely replace
+ * the frames and paths.
+ */
+static gpointer
+sender_thread (gpointer data)
+{
+    osc_sender_t *sender = (osc_sender_t *) data;
+    gint          tail;
+
+
+    while (TRUE) {
+
+        g_mutex_lock (sender->wake_lock);
+        while (!g_atomic_int_get (&sender->quit) &&
+               (g_atomic_int_get (&sender->head) == g_atomic_int_get (&sender->tail))) {
+            g_cond_wait (sender->wake, sender->wake_lock);
+        }
+        g_mutex_unlock (sender->wake_lock);
+
+        if (g_atomic_int_get (&sender->quit))
+            break;
+
+        g_mutex_lock (sender->data_lock);
+
+        /* the queue may have been reset while we were waiting for the lock */
+        tail = g_atomic_int_get (&sender->tail);
+        if (g_atomic_int_get (&sender->head) != tail) {
+            send_frame (sender, &sender->ring[tail % OSC_SENDER_QUEUE_LEN]);
+            clear_frame (sender, &sender->ring[tail % OSC_SENDER_QUEUE_LEN]);
+
+            /* release the slot */
+            g_atomic_int_set (&sender->tail, tail + 1);
+        }
+
+        g_mutex_unlock (sender->data_lock);
+    }
+
+    return NULL;
+}
+
+
+/** \brief Send all changed states of a frame to all sinks. */
+static void
+send_frame (osc_sender_t *sender, osc_frame_t *frame)
+{
+    osc_sink_t *sink;
+    lo_timetag  tt;
+    GTimeVal    tv;
+    gdouble     now;
+    guint       i;
+
+
+    tt = daynum_to_tt (frame->daynum);
+
+    g_get_current_time (&tv);
+    now = tv.tv_sec + tv.tv_usec / 1.0e6;
+
+    for (i = 0; i < sender->nsats; i++) {
+
+        if (!frame->valid[i])
+            continue;
+
+        if (!state_changed (sender, frame, i, now)) {
+            g_atomic_int_inc (&sender->suppressed);
+            continue;
+        }
+
+        send_state (sender, frame, i, tt);
+
+        sender->history[i].valid = TRUE;
+        sender->history[i].time = now;
+        sender->history[i].state = frame->sats[i];
+    }
+
+    for (i = 0; i < sender->sinks->len; i++) {
+        sink = g_ptr_array_index (sender->sinks, i);
+        if (sink->blob->len > 0)
+            flush_blob (sender, sink, frame, tt);
+        if (sink->current)
+            flush_bundle (sender, sink);
+    }
+
+    /* all bundles referencing the messages have been sent */
+    g_ptr_array_foreach (sender->msgs, (GFunc) lo_message_free, NULL);
+    g_ptr_array_set_size (sender->msgs, 0);
+}
+
+
+/** \brief Send the state of one satellite to the sinks that want it.
+ *
+ * The message goes to OSC_SENDER_SAT_PATH<catnr> with the fields selected
+ * by the frame format. It is built once and then, for each sink, either
+ * sent right away or added to the bundle of the sink, which is sent first
+ * if the new message would not fit. In blob mode the state is packed into
+ * a record once, which is then appended to the blob of each sink.
+ */
+static void
+send_state (osc_sender_t *sender, osc_frame_t *frame, guint idx, lo_timetag tt)
+{
+    osc_sat_state_t *state = &frame->sats[idx];
+    osc_sink_t      *sink;
+    const gchar     *path;
+    lo_message       msg = NULL;
+    gsize            len = 0;
+    guint            i;
+
+
+    path = g_ptr_array_index (sender->paths, idx);
+
+    for (i = 0; i < sender->sinks->len; i++) {
+
+        sink = g_ptr_array_index (sender->sinks, i);
+
+        if (!sink->accept[idx] || (state->val[OSC_FIELD_EL] < sink->min_el))
+            continue;
+
+        if (frame->format.blob) {
+            /* pack the record for the first sink that needs it */
+            if (len == 0) {
+                pack_record (&frame->format, state, sender->record);
+                len = frame->format.reclen;
+            }
+
+            if (BLOB_MSG_OVERHEAD + sink->blob->len + len >
+                OSC_SENDER_MAX_BUNDLE_SIZE) {
+                flush_blob (sender, sink, frame, tt);
+            }
+
+            g_byte_array_append (sink->blob, sender->record, len);
+            sink->count++;
+            continue;
+        }
+
+        /* format the message for the first sink that needs it */
+        if (msg == NULL) {
+            msg = new_message (&frame->format, state);
+            g_ptr_array_add (sender->msgs, msg);
+
+            /* each bundle element is preceded by its size */
+            len = 4 + lo_message_length (msg, path);
+        }
+
+        if (!frame->bundle) {
+            check_error (sender, sink,
+                         lo_send_message (sink->addr, path, msg), 1);
+            continue;
+        }
+
+        if ((sink->current != NULL) &&
+            (sink->size + len > OSC_SENDER_MAX_BUNDLE_SIZE)) {
+            flush_bundle (sender, sink);
+        }
+
+        if (sink->current == NULL) {
+            sink->current = lo_bundle_new (tt);
+            sink->size = BUNDLE_HEADER_SIZE;
+        }
+
+        lo_bundle_add_message (sink->current, path, msg);
+        sink->size += len;
+        sink->count++;
+    }
+}
+
+
+/** \brief Check whether a satellite state needs to be sent.
+ *  \param sender The OSC sender.
+ *  \param frame The frame containing the state.
+ *  \param idx The satellite index.
+ *  \param now The current wall clock time [s].
+ *  \return TRUE if the state differs from the last sent state by at least
+ *          one of the deadbands or the heartbeat interval has passed.
+ */
+static gboolean
+state_changed (osc_sender_t *sender, osc_frame_t *frame, guint idx, gdouble now)
+{
+    osc_history_t   *hist = &sender->history[idx];
+    osc_sat_state_t *state = &frame->sats[idx];
+    osc_deadband_t  *db = &frame->deadband;
+    gdouble          daz;
+
+
+    if (!hist->valid)
+        return TRUE;
+
+    if ((db->heartbeat > 0.0) && (now - hist->time >= db->heartbeat))
+        return TRUE;
+
+    /* azimuth wraps around at 0/360 */
+    daz = fabs (state->val[OSC_FIELD_AZ] - hist->state.val[OSC_FIELD_AZ]);
+    if (daz > 180.0)
+        daz = 360.0 - daz;
+
+    return (daz >= db->angle) ||
+        (fabs (state->val[OSC_FIELD_EL] - hist->state.val[OSC_FIELD_EL]) >= db->angle) ||
+        (fabs (state->val[OSC_FIELD_ALT] - hist->state.val[OSC_FIELD_ALT]) >= db->alt) ||
+        (fabs (state->val[OSC_FIELD_RANGE_RATE] - hist->state.val[OSC_FIELD_RANGE_RATE]) >= db->rate);
+}
+
+
+/** \brief Send and free the current bundle of a sink.
+ *
+ * The bundle does not own the messages; they are freed by send_frame()
+ * once the bundles of all sinks have been sent.
+ */
+static void
+flush_bundle (osc_sender_t *sender, osc_sink_t *sink)
+{
+    check_error (sender, sink,
+                 lo_send_bundle (sink->addr, sink->current),
+                 sink->count);
+
+    lo_bundle_free (sink->current);
+    sink->current = NULL;
+    sink->size = 0;
+    sink->count = 0;
+}
+
+
+/** \brief Send the current blob of a sink.
+ *
+ * The blob message is wrapped into a time tagged bundle of its own when
+ * the frame is sent as bundles.
+ */
+static void
+flush_blob (osc_sender_t *sender, osc_sink_t *sink,
+            osc_frame_t *frame, lo_timetag tt)
+{
+    lo_message msg;
+    lo_blob    blob;
+    lo_bundle  bundle;
+    gint       retcode;
+
+
+    /* lo_message_add_blob() copies the data */
+    blob = lo_blob_new (sink->blob->len, sink->blob->data);
+    msg = lo_message_new ();
+    lo_message_add_string (msg, frame->format.typetag);
+    lo_message_add_blob (msg, blob);
+
+    if (frame->bundle) {
+        bundle = lo_bundle_new (tt);
+        lo_bundle_add_message (bundle, OSC_SENDER_BLOB_PATH, msg);
+        retcode = lo_send_bundle (sink->addr, bundle);
+        lo_bundle_free (bundle);
+    }
+    else {
+        retcode = lo_send_message (sink->addr, OSC_SENDER_BLOB_PATH, msg);
+    }
+
+    check_error (sender, sink, retcode, sink->count);
+
+    lo_message_free (msg);
+    lo_blob_free (blob);
+
+    g_byte_array_set_size (sink->blob, 0);
+    sink->count = 0;
+}
+
+
+/** \brief Create the OSC message of a satellite state.
+ *
+ * The arguments are added by walking the field list of the format; the
+ * orbit number is an int32, everything else a float or a double.
+ */
+static lo_message
+new_message (osc_format_t *format, osc_sat_state_t *state)
+{
+    lo_message msg;
+    gdouble    val;
+    guint      i;
+
+
+    msg = lo_message_new ();
+
+    for (i = 0; i < format->nfields; i++) {
+        val = state->val[format->fields[i]];
+
+        if (format->fields[i] == OSC_FIELD_ORBIT)
+            lo_message_add_int32 (msg, (gint32) val);
+        else if (format->dbl)
+            lo_message_add_double (msg, val);
+        else
+            lo_message_add_float (msg, (gfloat) val);
+    }
+
+    return msg;
+}
+
+
+/** \brief Pack a satellite state into a blob record.
+ *  \param format The message layout.
+ *  \param state The satellite state.
+ *  \param buf Buffer of at least format->reclen bytes.
+ *
+ * The values are stored in network byte order as described by the
+ * type tags of the format.
+ */
+static void
+pack_record (osc_format_t *format, osc_sat_state_t *state, guint8 *buf)
+{
+    union {
+        gfloat  f;
+        guint32 i;
+    } u32;
+    union {
+        gdouble d;
+        guint64 i;
+    } u64;
+    guint32 i32;
+    guint   i;
+
+
+    i32 = GUINT32_TO_BE ((guint32) state->catnr);
+    memcpy (buf, &i32, 4);
+    buf += 4;
+
+    for (i = 0; i < format->nfields; i++) {
+
+        if (format->fields[i] == OSC_FIELD_ORBIT) {
+            i32 = GUINT32_TO_BE ((guint32) state->val[OSC_FIELD_ORBIT]);
+            memcpy (buf, &i32, 4);
+            buf += 4;
+        }
+        else if (format->dbl) {
+            u64.d = state->val[format->fields[i]];
+            u64.i = GUINT64_TO_BE (u64.i);
+            memcpy (buf, &u64.i, 8);
+            buf += 8;
+        }
+        else {
+            u32.f = (gfloat) state->val[format->fields[i]];
+            u32.i = GUINT32_TO_BE (u32.i);
+            memcpy (buf, &u32.i, 4);
+            buf += 4;
+        }
+    }
+}
+
+
+/** \brief Build the message layout for a configuration.
+ *  \param format The layout to initialise.
+ *  \param mask The fields to send (OSC_FLAG_*).
+ *  \param dbl Flag indicating whether to use double precision.
+ *  \param blob Flag indicating whether to pack the states into blobs.
+ */
+static void
+format_init (osc_format_t *format, guint32 mask, gboolean dbl, gboolean blob)
+{
+    guint i;
+
+
+    format->mask = mask;
+    format->dbl = dbl;
+    format->blob = blob;
+    format->nfields = 0;
+
+    /* catalogue number of the blob record */
+    format->typetag[0] = 'i';
+    format->reclen = 4;
+
+    for (i = 0; i < OSC_FIELD_NUMBER; i++) {
+
+        if (!(mask & (1 << i)))
+            continue;
+
+        format->fields[format->nfields] = (osc_field_t) i;
+        format->nfields++;
+
+        if (i == OSC_FIELD_ORBIT) {
+            format->typetag[format->nfields] = 'i';
+            format->reclen += 4;
+        }
+        else if (dbl) {
+            format->typetag[format->nfields] = 'd';
+            format->reclen += 8;
+        }
+        else {
+            format->typetag[format->nfields] = 'f';
+            format->reclen += 4;
+        }
+    }
+
+    format->typetag[format->nfields+1] = '\0';
+}
+
+
+/** \brief Check the return value of a liblo send function.
+ *  \param sender The OSC sender.
+ *  \param sink The sink the datagram was sent to.
+ *  \param retcode The return value of lo_send_message() or lo_send_bundle().
+ *  \param n The number of satellite states in the datagram.
+ *
+ * Updates the statistics and logs the first of a series of failures;
+ * subsequent failures are not logged to avoid flooding the log when the
+ * receiver is not running.
+ */
+static void
+check_error (osc_sender_t *sender, osc_sink_t *sink, gint retcode, guint n)
+{
+    if (retcode == -1) {
+        g_atomic_int_add (&sender->dropped, n);
+
+        if (!sink->failing) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: OSC error on %s %d: %s"),
+                         __FUNCTION__, sink->name,
+                         lo_address_errno (sink->addr),
+                         lo_address_errstr (sink->addr));
+            sink->failing = TRUE;
+        }
+    }
+    else {
+        g_atomic_int_add (&sender->sent, n);
+        sink->failing = FALSE;
+    }
+}
+
+
+/** \brief Allocate the frames and the history for sender->nsats. */
+static void
+alloc_frames (osc_sender_t *sender)
+{
+    guint i;
+
+    sender->history = g_new0 (osc_history_t, MAX (sender->nsats, 1));
+
+    sender->staging.sats = g_new0 (osc_sat_state_t, MAX (sender->nsats, 1));
+    sender->staging.valid = g_new0 (gboolean, MAX (sender->nsats, 1));
+
+    for (i = 0; i < OSC_SENDER_QUEUE_LEN; i++) {
+        sender->ring[i].sats = g_new0 (osc_sat_state_t, MAX (sender->nsats, 1));
+        sender->ring[i].valid = g_new0 (gboolean, MAX (sender->nsats, 1));
+    }
+}
+
+
+/** \brief Free the frames and the history. */
+static void
+free_frames (osc_sender_t *sender)
+{
+    guint i;
+
+    g_free (sender->history);
+
+    g_free (sender->staging.sats);
+    g_free (sender->staging.valid);
+
+    for (i = 0; i < OSC_SENDER_QUEUE_LEN; i++) {
+        g_free (sender->ring[i].sats);
+        g_free (sender->ring[i].valid);
+    }
+}
+
+
+/** \brief Mark all states in a frame as unset. */
+static void
+clear_frame (osc_sender_t *sender, osc_frame_t *frame)
+{
+    memset (frame->valid, 0, sender->nsats * sizeof (gboolean));
+}
+
+
+/** \brief Convert Julian date to OSC (NTP) time tag. */
+static lo_timetag
+daynum_to_tt (gdouble daynum)
+{
+    lo_timetag tt;
+    gdouble    secs;
+
+
+    secs = (daynum - NTP_EPOCH_JD) * 86400.0;
+    tt.sec = (guint32) floor (secs);
+    tt.frac = (guint32) ((secs - floor (secs)) * 4294967296.0);
+
+    return tt;
+}
+
+
+/** \brief Create a sink from its specification.
+ *  \param spec The sink specification, see osc_sink_t.
+ *  \return A new sink or NULL if the specification is invalid.
+ */
+static osc_sink_t *
+sink_new (const gchar *spec)
+{
+    osc_sink_t *sink;
+    gchar     **fields;
+    gchar     **catnrs;
+    gint       *catnr;
+    gint        proto = LO_UDP;
+    guint       n,i;
+
+
+    fields = g_strsplit (spec, ":", 5);
+    n = g_strv_length (fields);
+
+    if ((n < 2) || (fields[1][0] == '\0')) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: Invalid OSC sink %s (no port)"),
+                     __FUNCTION__, spec);
+        g_strfreev (fields);
+
+        return NULL;
+    }
+
+    if ((n > 2) && !g_ascii_strcasecmp (fields[2], "tcp"))
+        proto = LO_TCP;
+
+    sink = g_new0 (osc_sink_t, 1);
+    sink->name = g_strdup (spec);
+    sink->addr = lo_address_new_with_proto (proto,
+                                            fields[0][0] ? fields[0] : NULL,
+                                            fields[1]);
+    if (sink->addr == NULL) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: Could not create OSC address for %s"),
+                     __FUNCTION__, spec);
+        g_free (sink->name);
+        g_free (sink);
+        g_strfreev (fields);
+
+        return NULL;
+    }
+
+    /* elevation threshold; everything above the nadir by default */
+    if ((n > 3) && (fields[3][0] != '\0'))
+        sink->min_el = g_ascii_strtod (fields[3], NULL);
+    else
+        sink->min_el = -90.0;
+
+    /* catnr filter */
+    if ((n > 4) && (fields[4][0] != '\0')) {
+        sink->filter = g_hash_table_new_full (g_int_hash, g_int_equal,
+                                              g_free, NULL);
+        catnrs = g_strsplit (fields[4], ",", 0);
+        for (i = 0; catnrs[i] != NULL; i++) {
+            catnr = g_new (gint, 1);
+            *catnr = (gint) g_ascii_strtoll (catnrs[i], NULL, 10);
+            g_hash_table_insert (sink->filter, catnr, catnr);
+        }
+        g_strfreev (catnrs);
+    }
+
+    sink->accept = NULL;
+    sink->failing = FALSE;
+    sink->current = NULL;
+    sink->size = 0;
+    sink->count = 0;
+    sink->blob = g_byte_array_new ();
+
+    g_strfreev (fields);
+
+    sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                 _("%s: Created OSC sink %s"),
+                 __FUNCTION__, spec);
+
+    return sink;
+}
+
+
+/** \brief Free a sink. */
+static void
+sink_free (osc_sink_t *sink)
+{
+    if (sink->current)
+        lo_bundle_free (sink->current);
+
+    g_byte_array_free (sink->blob, TRUE);
+
+    if (sink->filter)
+        g_hash_table_destroy (sink->filter);
+
+    lo_address_free (sink->addr);
+    g_free (sink->accept);
+    g_free (sink->name);
+    g_free (sink);
+}
+
+
+/** \brief Evaluate the catnr filter of a sink for each satellite index.
+ *
+ * This is done once when the satellites are loaded so that the sender
+ * thread only needs an array lookup per satellite and sink.
+ */
+static void
+sink_set_sats (osc_sink_t *sink, osc_sender_t *sender)
+{
+    guint i;
+
+
+    g_free (sink->accept);
+    sink->accept = g_new0 (gboolean, MAX (sender->nsats, 1));
+
+    for (i = 0; i < sender->nsats; i++) {
+        sink->accept[i] =
+            (sink->filter == NULL) ||
+            (g_hash_table_lookup (sink->filter, &sender->catnr[i]) != NULL);
+    }
+}
@@ -0,0 +1,255 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2010  Alexandru Csete, OZ9AEC.
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+#ifndef OSC_SENDER_H
+#define OSC_SENDER_H 1
+
+#include <glib.h>
+#include "lo/lo.h"
+#include "sat-state.h"
+
+
+/** \brief Separator between sinks in the sink configuration string. */
+#define OSC_SENDER_SINK_SEP     ";"
+
+/** \brief Prefix of the per-satellite OSC path; the catnr is appended. */
+#define OSC_SENDER_SAT_PATH     "/gpredict/sat/"
+
+/** \brief OSC path of the blob messages carrying several satellites. */
+#define OSC_SENDER_BLOB_PATH    "/gpredict/sats"
+
+/** \brief Max size of a bundle in bytes.
+ *
+ * This is the Ethernet MTU minus the IP and UDP headers; bundles that would
+ * grow larger than this are split so that they are never fragmented.
+ */
+#define OSC_SENDER_MAX_BUNDLE_SIZE 1472
+
+
+/** \brief Number of cycles that can be queued for the sender thread. */
+#define OSC_SENDER_QUEUE_LEN 4
+
+
+/** \brief What to do when the sender thread can not keep up. */
+typedef enum {
+    OSC_QUEUE_COALESCE = 0,  /*!< Keep the newest state of each satellite. */
+    OSC_QUEUE_DROP           /*!< Drop the whole cycle. */
+} osc_queue_policy_t;
+
+
+/** \brief Satellite data fields that can be sent via OSC.
+ *
+ * The fields are sent in this order. AOS and LOS are sent as the number of
+ * seconds from the cycle time to the event, so that they keep their
+ * resolution in single precision; the orbit number is always an int32.
+ */
+typedef enum {
+    OSC_FIELD_AZ = 0,        /*!< Azimuth [deg] */
+    OSC_FIELD_EL,            /*!< Elevation [deg] */
+    OSC_FIELD_ALT,           /*!< Altitude [km] */
+    OSC_FIELD_VEL,           /*!< Velocity [km/s] */
+    OSC_FIELD_RANGE,         /*!< Range [km] */
+    OSC_FIELD_RANGE_RATE,    /*!< Range rate [km/s] */
+    OSC_FIELD_LAT,           /*!< Latitude of the sub-satellite point [deg] */
+    OSC_FIELD_LON,           /*!< Longitude of the sub-satellite point [deg] */
+    OSC_FIELD_FOOTPRINT,     /*!< Footprint diameter [km] */
+    OSC_FIELD_DOPPLER,       /*!< Doppler shift at 100 MHz [Hz] */
+    OSC_FIELD_AOS,           /*!< Time to next AOS [s] */
+    OSC_FIELD_LOS,           /*!< Time to next LOS [s] */
+    OSC_FIELD_ORBIT,         /*!< Orbit number */
+    OSC_FIELD_NUMBER
+} osc_field_t;
+
+
+/** \brief Field flags used in SAT_CFG_INT_OSC_FIELDS.
+ *
+ * These correspond to the SAT_LIST_FLAG_* column flags of the list view.
+ */
+typedef enum {
+    OSC_FLAG_AZ         = 1 << OSC_FIELD_AZ,
+    OSC_FLAG_EL         = 1 << OSC_FIELD_EL,
+    OSC_FLAG_ALT        = 1 << OSC_FIELD_ALT,
+    OSC_FLAG_VEL        = 1 << OSC_FIELD_VEL,
+    OSC_FLAG_RANGE      = 1 << OSC_FIELD_RANGE,
+    OSC_FLAG_RANGE_RATE = 1 << OSC_FIELD_RANGE_RATE,
+    OSC_FLAG_LAT        = 1 << OSC_FIELD_LAT,
+    OSC_FLAG_LON        = 1 << OSC_FIELD_LON,
+    OSC_FLAG_FOOTPRINT  = 1 << OSC_FIELD_FOOTPRINT,
+    OSC_FLAG_DOPPLER    = 1 << OSC_FIELD_DOPPLER,
+    OSC_FLAG_AOS        = 1 << OSC_FIELD_AOS,
+    OSC_FLAG_LOS        = 1 << OSC_FIELD_LOS,
+    OSC_FLAG_ORBIT      = 1 << OSC_FIELD_ORBIT
+} osc_flag_t;
+
+
+/** \brief Default fields (the original az, el, alt, velo message). */
+#define OSC_FIELDS_DEFAULT (OSC_FLAG_AZ | OSC_FLAG_EL | OSC_FLAG_ALT | OSC_FLAG_VEL)
+
+
+/** \brief Message layout derived from the configuration.
+ *
+ * The layout is only rebuilt when the configuration changes. typetag holds
+ * the OSC type tags of a blob record, i.e. 'i' for the catalogue number
+ * followed by the type tags of the selected fields; the per-satellite
+ * messages use the same type tags without the leading 'i'.
+ */
+typedef struct {
+    guint32  mask;                          /*!< OSC_FLAG_* of the fields. */
+    gboolean dbl;                           /*!< Use double precision. */
+    gboolean blob;                          /*!< Pack states into blobs. */
+    guint    nfields;                       /*!< Number of selected fields. */
+    osc_field_t fields[OSC_FIELD_NUMBER];   /*!< The selected fields. */
+    gchar    typetag[OSC_FIELD_NUMBER+2];   /*!< Type tags of a record. */
+    gsize    reclen;                        /*!< Size of a blob record. */
+} osc_format_t;
+
+
+/** \brief Snapshot of the satellite data sent via OSC. */
+typedef struct {
+    gint     catnr;                   /*!< Catalogue number. */
+    gdouble  val[OSC_FIELD_NUMBER];   /*!< Field values by osc_field_t. */
+} osc_sat_state_t;
+
+
+/** \brief Deadbands for suppressing unchanged satellites.
+ *
+ * A satellite is only sent when its azimuth or elevation, altitude or
+ * range rate has changed by at least the deadband since it was last sent,
+ * or when it has not been sent for heartbeat seconds. With all deadbands
+ * zero every satellite is sent in every cycle.
+ */
+typedef struct {
+    gdouble  angle;          /*!< Azimuth and elevation [deg] */
+    gdouble  alt;            /*!< Altitude [km] */
+    gdouble  rate;           /*!< Range rate [km/s] */
+    gdouble  heartbeat;      /*!< Max time between two sends [s] */
+} osc_deadband_t;
+
+
+/** \brief The last state sent of a satellite. */
+typedef struct {
+    gboolean        valid;   /*!< Flag indicating that state has been sent. */
+    gdouble         time;    /*!< Wall clock time of the send [s] */
+    osc_sat_state_t state;   /*!< The state. */
+} osc_history_t;
+
+
+/** \brief The satellite data of one module cycle.
+ *
+ * The states are indexed by the dense satellite index of the module's
+ * sat_state_t; only the entries flagged in valid[] are sent.
+ */
+typedef struct {
+    gdouble          daynum;  /*!< Time of the cycle. */
+    gboolean         bundle;  /*!< Send the cycle as bundle(s). */
+    osc_format_t     format;  /*!< Message layout. */
+    osc_deadband_t   deadband;/*!< Suppression of unchanged states. */
+    osc_sat_state_t *sats;    /*!< Satellite states. */
+    gboolean        *valid;   /*!< Flags indicating which states are set. */
+} osc_frame_t;
+
+
+/** \brief An OSC destination.
+ *
+ * A sink is configured by a string of the form
+ *
+ *   host:port[:protocol[:min_el[:catnr,catnr,...]]]
+ *
+ * where host may be empty for localhost, protocol is udp (default) or tcp,
+ * min_el is the minimum elevation in degrees a satellite must have to be
+ * sent to this sink and the optional list of catalogue numbers limits the
+ * sink to these satellites. Sinks are separated by OSC_SENDER_SINK_SEP.
+ */
+typedef struct {
+    gchar       *name;       /*!< Sink specification used in messages. */
+    lo_address   addr;       /*!< Destination address. */
+    gdouble      min_el;     /*!< Elevation threshold [deg]. */
+    GHashTable  *filter;     /*!< Set of catnrs or NULL for all satellites. */
+    gboolean    *accept;     /*!< The filter by satellite index. */
+    gboolean     failing;    /*!< Flag indicating that the last send failed. */
+    lo_bundle    current;    /*!< The bundle being filled or NULL. */
+    gsize        size;       /*!< Serialised size of the current bundle. */
+    guint        count;      /*!< Number of messages in the current bundle. */
+    GByteArray  *blob;       /*!< Records of the current blob message. */
+} osc_sink_t;
+
+
+/** \brief OSC output owned by a GtkSatModule.
+ *
+ * The destination addresses are created once when the module is created
+ * and the OSC path of each satellite is built when the satellites are
+ * loaded. Each satellite state is formatted once per cycle, no matter
+ * how many sinks it is sent to.
+ *
+ * The module (producer) fills a staging frame with snapshots of the
+ * satellites between osc_sender_begin() and osc_sender_end(), which then
+ * hands the frame to the sender thread (consumer) via a single-producer /
+ * single-consumer ring without taking any locks. The sender thread does
+ * all the formatting and network I/O, so a stalled receiver can not delay
+ * the module. When the ring is full, the staging frame is kept and
+ * updated in the next cycle (coalesced) or dropped, depending on policy.
+ */
+typedef struct {
+    GPtrArray   *sinks;      /*!< The destinations (osc_sink_t). */
+    gint        *catnr;      /*!< Catalogue numbers by satellite index. */
+    GPtrArray   *paths;      /*!< OSC path strings by satellite index. */
+    guint        nsats;      /*!< Number of satellites (frame capacity). */
+
+    osc_queue_policy_t policy;  /*!< Policy when the queue is full. */
+    osc_format_t format;     /*!< Current message layout. */
+    osc_frame_t  staging;    /*!< Frame being filled by the module. */
+    gboolean     pending;    /*!< Staging frame contains unqueued data. */
+    osc_frame_t  ring[OSC_SENDER_QUEUE_LEN];  /*!< The frame queue. */
+    volatile gint head;      /*!< Number of frames queued (producer). */
+    volatile gint tail;      /*!< Number of frames sent (consumer). */
+
+    GThread     *thread;     /*!< The sender thread or NULL. */
+    GMutex      *wake_lock;  /*!< Mutex for wake. */
+    GCond       *wake;       /*!< Signals new frame or exit to the thread. */
+    GMutex      *data_lock;  /*!< Held by the thread while sending a frame. */
+    volatile gint quit;      /*!< Tells the thread to exit. */
+
+    osc_history_t *history;  /*!< Last sent states by satellite index. */
+    GPtrArray   *msgs;       /*!< Messages of the frame being sent. */
+    guint8      *record;     /*!< Scratch buffer for one blob record. */
+
+    volatile gint sent;      /*!< Number of satellite states sent. */
+    volatile gint dropped;   /*!< States dropped or failed to send. */
+    volatile gint coalesced; /*!< States replaced before being sent. */
+    volatile gint suppressed;/*!< States not sent because of the deadband. */
+} osc_sender_t;
+
+
+osc_sender_t *osc_sender_new       (const gchar *sinks);
+void          osc_sender_free      (osc_sender_t *sender);
+void          osc_sender_set_sats  (osc_sender_t *sender, sat_state_t *state);
+void          osc_sender_begin     (osc_sender_t *sender, gdouble daynum);
+void          osc_sender_add_state (osc_sender_t *sender, sat_state_t *state);
+void          osc_sender_end       (osc_sender_t *sender);
+void          osc_sender_get_stats (osc_sender_t *sender, guint *sent,
+                                    guint *dropped, guint *coalesced,
+                                    guint *suppressed);
+
+#endif
@@ -0,0 +1,319 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2010  Alexandru Csete, OZ9AEC.
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \brief OSC control of a module.
+ *
+ * The server accepts the following messages:
+ *
+ *   /gpredict/time <t>         Set the time; t is either the number of
+ *                              seconds since the Unix epoch (any numeric
+ *                              type) or an OSC time tag.
+ *   /gpredict/throttle <n>     Set the throttle; 0 stops the time.
+ *   /gpredict/select <catnr>   Select a satellite.
+ *   /gpredict/reload           Reload the satellites.
+ *
+ * The liblo handlers run in the server thread and must not touch the
+ * module. They only store the command in the pending osc_cmd_t and, if
+ * no dispatch is scheduled yet, add an idle callback which hands the
+ * commands to the module in the main loop.
+ */
+#include <glib.h>
+#include <glib/gi18n.h>
+#ifdef HAVE_CONFIG_H
+#  include <build-config.h>
+#endif
+#include "sat-log.h"
+#include "osc-server.h"
+
+
+/** \brief Julian date of the Unix epoch. */
+#define UNIX_EPOCH_JD 2440587.5
+
+/** \brief Julian date of the NTP epoch (1900-01-01 00:00 UTC). */
+#define NTP_EPOCH_JD 2415020.5
+
+
+static void     error_handler    (int num, const char *msg, const char *where);
+static int      time_handler     (const char *path, const char *types,
+                                  lo_arg **argv, int argc,
+                                  lo_message msg, void *data);
+static int      throttle_handler (const char *path, const char *types,
+                                  lo_arg **argv, int argc,
+                                  lo_message msg, void *data);
+static int      select_handler   (const char *path, const char *types,
+                                  lo_arg **argv, int argc,
+                                  lo_message msg, void *data);
+static int      reload_handler   (const char *path, const char *types,
+                                  lo_arg **argv, int argc,
+                                  lo_message msg, void *data);
+static gboolean get_number       (const char *types, lo_arg **argv, int argc,
+                                  gdouble *val);
+static void     schedule         (osc_server_t *server);
+static gboolean dispatch         (gpointer data);
+
+
+/** \brief Create and start an OSC control server.
+ *  \param port The port to listen on.
+ *  \param func The function applying the received commands.
+ *  \param data User data passed to func.
+ *  \return A new osc_server_t or NULL if the server could not be created.
+ *          Free it with osc_server_free().
+ *
+ * func is always called from the main loop.
+ */
+osc_server_t *
+osc_server_new (const gchar *port, osc_server_func_t func, gpointer data)
+{
+    osc_server_t *server;
+
+
+    g_return_val_if_fail ((port != NULL) && (func != NULL), NULL);
+
+    server = g_new0 (osc_server_t, 1);
+
+    server->st = lo_server_thread_new (port, error_handler);
+    if (server->st == NULL) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: Could not create OSC server on port %s"),
+                     __FUNCTION__, port);
+        g_free (server);
+
+        return NULL;
+    }
+
+    server->lock = g_mutex_new ();
+    server->cmd.flags = 0;
+    server->idle_id = 0;
+    server->func = func;
+    server->data = data;
+
+    lo_server_thread_add_method (server->st, OSC_SERVER_TIME_PATH, NULL,
+                                 time_handler, server);
+    lo_server_thread_add_method (server->st, OSC_SERVER_THROTTLE_PATH, NULL,
+                                 throttle_handler, server);
+    lo_server_thread_add_method (server->st, OSC_SERVER_SELECT_PATH, NULL,
+                                 select_handler, server);
+    lo_server_thread_add_method (server->st, OSC_SERVER_RELOAD_PATH, NULL,
+                                 reload_handler, server);
+
+    lo_server_thread_start (server->st);
+
+    sat_log_log (SAT_LOG_LEVEL_MSG,
+                 _("%s: OSC server listening on port %s"),
+                 __FUNCTION__, port);
+
+    return server;
+}
+
+
+/** \brief Stop and free the OSC control server.
+ *
+ * Commands that have been received but not yet dispatched are discarded.
+ */
+void
+osc_server_free (osc_server_t *server)
+{
+    if (server == NULL)
+        return;
+
+    /* stops and joins the server thread */
+    lo_server_thread_free (server->st);
+
+    if (server->idle_id)
+        g_source_remove (server->idle_id);
+
+    g_mutex_free (server->lock);
+    g_free (server);
+}
+
+
+/** \brief Log liblo server errors. */
+static void
+error_handler (int num, const char *msg, const char *where)
+{
+    sat_log_log (SAT_LOG_LEVEL_ERROR,
+                 _("%s: OSC server error %d in %s: %s"),
+                 __FUNCTION__, num, where ? where : "-", msg);
+}
+
+
+/** \brief Handle /gpredict/time messages. */
+static int
+time_handler (const char *path, const char *types, lo_arg **argv, int argc,
+              lo_message msg, void *data)
+{
+    osc_server_t *server = (osc_server_t *) data;
+    gdouble       daynum;
+    gdouble       secs;
+
+
+    if ((argc > 0) && (types[0] == 't')) {
+        daynum = NTP_EPOCH_JD +
+            (argv[0]->t.sec + argv[0]->t.frac / 4294967296.0) / 86400.0;
+    }
+    else if (get_number (types, argv, argc, &secs)) {
+        daynum = UNIX_EPOCH_JD + secs / 86400.0;
+    }
+    else {
+        return 0;
+    }
+
+    g_mutex_lock (server->lock);
+    server->cmd.flags |= OSC_CMD_TIME;
+    server->cmd.daynum = daynum;
+    schedule (server);
+    g_mutex_unlock (server->lock);
+
+    return 0;
+}
+
+
+/** \brief Handle /gpredict/throttle messages. */
+static int
+throttle_handler (const char *path, const char *types, lo_arg **argv, int argc,
+                  lo_message msg, void *data)
+{
+    osc_server_t *server = (osc_server_t *) data;
+    gdouble       val;
+
+
+    if (!get_number (types, argv, argc, &val))
+        return 0;
+
+    g_mutex_lock (server->lock);
+    server->cmd.flags |= OSC_CMD_THROTTLE;
+    server->cmd.throttle = (gint) val;
+    schedule (server);
+    g_mutex_unlock (server->lock);
+
+    return 0;
+}
+
+
+/** \brief Handle /gpredict/select messages. */
+static int
+select_handler (const char *path, const char *types, lo_arg **argv, int argc,
+                lo_message msg, void *data)
+{
+    osc_server_t *server = (osc_server_t *) data;
+    gdouble       val;
+
+
+    if (!get_number (types, argv, argc, &val))
+        return 0;
+
+    g_mutex_lock (server->lock);
+    server->cmd.flags |= OSC_CMD_SELECT;
+    server->cmd.catnr = (gint) val;
+    schedule (server);
+    g_mutex_unlock (server->lock);
+
+    return 0;
+}
+
+
+/** \brief Handle /gpredict/reload messages. */
+static int
+reload_handler (const char *path, const char *types, lo_arg **argv, int argc,
+                lo_message msg, void *data)
+{
+    osc_server_t *server = (osc_server_t *) data;
+
+
+    g_mutex_lock (server->lock);
+    server->cmd.flags |= OSC_CMD_RELOAD;
+    schedule (server);
+    g_mutex_unlock (server->lock);
+
+    return 0;
+}
+
+
+/** \brief Get the first argument of a message as a number.
+ *  \return TRUE if the message has a numeric first argument.
+ */
+static gboolean
+get_number (const char *types, lo_arg **argv, int argc, gdouble *val)
+{
+    if (argc < 1)
+        return FALSE;
+
+    switch (types[0]) {
+
+    case 'i':
+        *val = argv[0]->i;
+        break;
+
+    case 'h':
+        *val = (gdouble) argv[0]->h;
+        break;
+
+    case 'f':
+        *val = argv[0]->f;
+        break;
+
+    case 'd':
+        *val = argv[0]->d;
+        break;
+
+    default:
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/** \brief Schedule a dispatch unless one is pending.
+ *
+ * Must be called with the server lock held.
+ */
+static void
+schedule (osc_server_t *server)
+{
+    if (server->idle_id == 0)
+        server->idle_id = g_idle_add (dispatch, server);
+}
+
+
+/** \brief Apply the pending commands in the main loop. */
+static gboolean
+dispatch (gpointer data)
+{
+    osc_server_t *server = (osc_server_t *) data;
+    osc_cmd_t     cmd;
+
+
+    g_mutex_lock (server->lock);
+    cmd = server->cmd;
+    server->cmd.flags = 0;
+    server->idle_id = 0;
+    g_mutex_unlock (server->lock);
+
+    if (cmd.flags)
+        server->func (&cmd, server->data);
+
+    return FALSE;
+}
@@ -0,0 +1,87 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2010  Alexandru Csete, OZ9AEC.
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+#ifndef OSC_SERVER_H
+#define OSC_SERVER_H 1
+
+#include <glib.h>
+#include "lo/lo.h"
+
+
+/** \brief OSC control paths. */
+#define OSC_SERVER_TIME_PATH      "/gpredict/time"
+#define OSC_SERVER_THROTTLE_PATH  "/gpredict/throttle"
+#define OSC_SERVER_SELECT_PATH    "/gpredict/select"
+#define OSC_SERVER_RELOAD_PATH    "/gpredict/reload"
+
+
+/** \brief Flags indicating which commands are set in osc_cmd_t. */
+typedef enum {
+    OSC_CMD_TIME     = 1 << 0,   /*!< Set the time. */
+    OSC_CMD_THROTTLE = 1 << 1,   /*!< Set the throttle. */
+    OSC_CMD_SELECT   = 1 << 2,   /*!< Select a satellite. */
+    OSC_CMD_RELOAD   = 1 << 3    /*!< Reload the satellites. */
+} osc_cmd_flag_t;
+
+
+/** \brief Commands received since the last dispatch.
+ *
+ * Only the latest value of each command is kept.
+ */
+typedef struct {
+    guint    flags;      /*!< The commands received (osc_cmd_flag_t). */
+    gdouble  daynum;     /*!< The time to set. */
+    gint     throttle;   /*!< The throttle to set. */
+    gint     catnr;      /*!< The satellite to select. */
+} osc_cmd_t;
+
+
+/** \brief Function applying the commands in the main loop. */
+typedef void (*osc_server_func_t) (osc_cmd_t *cmd, gpointer data);
+
+
+/** \brief OSC control server.
+ *
+ * The messages are received by a liblo server thread, which merges them
+ * into a pending osc_cmd_t and schedules a single idle callback in the
+ * main loop. All messages received before the idle callback runs are
+ * applied at once, so a fast stream of messages (e.g. time scrubbing
+ * from a sequencer) costs at most one dispatch per main loop iteration.
+ */
+typedef struct {
+    lo_server_thread  st;        /*!< The liblo server thread. */
+    GMutex           *lock;      /*!< Protects cmd and idle_id. */
+    osc_cmd_t         cmd;       /*!< Pending commands. */
+    guint             idle_id;   /*!< The scheduled idle callback or 0. */
+    osc_server_func_t func;      /*!< Function applying the commands. */
+    gpointer          data;      /*!< User data passed to func. */
+} osc_server_t;
+
+
+osc_server_t *osc_server_new  (const gchar *port,
+                               osc_server_func_t func, gpointer data);
+void          osc_server_free (osc_server_t *server);
+
+#endif
@@ -0,0 +1,382 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2010  Alexandru Csete, OZ9AEC.
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \brief Cache of predicted passes.
+ *
+ * Every pass popup, the sky at a glance and the rotator controller ask
+ * get_pass() and get_passes() for the same few satellites over and over
+ * again. The cache keeps the passes found for a satellite and a ground
+ * station, so that repeated queries are answered by a lookup.
+ *
+ * For each satellite and ground station the cache holds the passes of a
+ * time window [start;end]: every pass with LOS after start and AOS before
+ * end is in the list, sorted by time. Queries inside the window are
+ * answered from the list; queries reaching beyond it extend the window by
+ * searching from its end. Passes that ended long ago are dropped from the
+ * front of the list as time advances.
+ *
+ * An entry is reset when the TLE epoch of the satellite or the prediction
+ * settings change. The ground station is part of the key, so editing a
+ * ground station creates a new entry; the old entries are freed by
+ * pass_cache_clear(), which is called when the modules reload their
+ * satellites, or pass_cache_forget() when only a few TLE have changed.
+ *
+ * The cache is shared by all threads. The lock is only held while the
+ * lists are accessed; the pass searches run outside of it.
+ */
+#include <glib.h>
+#include "pass-cache.h"
+
+
+/** \brief Gap between LOS and the search for the next pass [days].
+ *
+ * Same as the step used by get_passes() between consecutive passes.
+ */
+#define PASS_CACHE_GAP  0.014
+
+/** \brief How long passes are kept after their LOS [days]. */
+#define PASS_CACHE_KEEP 1.0
+
+
+/** \brief Satellite and ground station of a cache entry. */
+typedef struct {
+    gint     catnr;    /*!< Catalogue number. */
+    gdouble  lat;      /*!< Latitude of the ground station. */
+    gdouble  lon;      /*!< Longitude of the ground station. */
+    gint     alt;      /*!< Altitude of the ground station. */
+} pass_cache_key_t;
+
+
+/** \brief Passes of a satellite over a ground station. */
+typedef struct {
+    pass_cache_key_t key;
+    gdouble  epoch;    /*!< TLE epoch the passes were predicted with. */
+    predict_cfg_t cfg; /*!< Settings the passes were predicted with. */
+    gdouble  start;    /*!< Start of the window. */
+    gdouble  end;      /*!< End of the window. */
+    GSList  *passes;   /*!< The passes (pass_t) in the window. */
+} pass_cache_entry_t;
+
+
+static guint    key_hash    (gconstpointer key);
+static gboolean match_catnr (gpointer key, gpointer value, gpointer data);
+static gboolean key_equal   (gconstpointer a, gconstpointer b);
+static void     free_entry  (gpointer data);
+static void     reset_entry (pass_cache_entry_t *entry, gdouble start);
+static gdouble  covered_end (pass_cache_entry_t *entry);
+static pass_cache_entry_t *get_entry (sat_t *sat, qth_t *qth,
+                                      const predict_cfg_t *cfg);
+
+
+G_LOCK_DEFINE_STATIC (cache);
+
+/** \brief The cache entries (pass_cache_entry_t) by their key. */
+static GHashTable *cache = NULL;
+
+
+/** \brief Look up a pass in the cache.
+ *  \param sat The satellite.
+ *  \param qth The ground station.
+ *  \param cfg The prediction settings.
+ *  \param start Starting time.
+ *  \param maxdt The maximum number of days to look ahead (0 for no limit).
+ *  \param pass Location to store the pass at.
+ *  \param from Location to store the start of the search at.
+ *  \return TRUE if the query has been answered, FALSE if the cache must be
+ *          extended first.
+ *
+ * When the cache can answer the query, *pass is set to a newly allocated
+ * copy of the first pass that has not ended at start, or to NULL if there
+ * is no such pass within maxdt, just like get_pass() would return it.
+ *
+ * Otherwise *from is set to the time the next pass has to be searched
+ * from. The caller searches for it and hands the result to
+ * pass_cache_store(), then looks up the pass again.
+ */
+gboolean
+pass_cache_lookup (sat_t *sat, qth_t *qth, const predict_cfg_t *cfg,
+                   gdouble start, gdouble maxdt, pass_t **pass, gdouble *from)
+{
+    pass_cache_entry_t *entry;
+    pass_t             *p = NULL;
+    GSList             *node;
+    gboolean            found = TRUE;
+
+
+    G_LOCK (cache);
+
+    entry = get_entry (sat, qth, cfg);
+
+    if ((start < entry->start) || (start > covered_end (entry)))
+        reset_entry (entry, start);
+
+    /* drop passes that ended long ago */
+    while ((entry->passes != NULL) &&
+           (PASS (entry->passes->data)->los < start - PASS_CACHE_KEEP)) {
+        entry->start = PASS (entry->passes->data)->los;
+        free_pass (PASS (entry->passes->data));
+        entry->passes = g_slist_delete_link (entry->passes, entry->passes);
+    }
+
+    /* first pass that has not ended at start */
+    for (node = entry->passes; node != NULL; node = node->next) {
+        if (PASS (node->data)->los > start) {
+            p = PASS (node->data);
+            break;
+        }
+    }
+
+    if (p != NULL) {
+        if ((maxdt > 0.0) && (p->aos > start + maxdt))
+            *pass = NULL;
+        else
+            *pass = copy_pass (p);
+    }
+    else if ((entry->end == G_MAXDOUBLE) ||
+             ((maxdt > 0.0) && (entry->end >= start + maxdt))) {
+        /* no more passes within maxdt */
+        *pass = NULL;
+    }
+    else {
+        *from = covered_end (entry);
+
+        if ((maxdt > 0.0) && (*from >= start + maxdt))
+            *pass = NULL;
+        else
+            found = FALSE;
+    }
+
+    G_UNLOCK (cache);
+
+    return found;
+}
+
+
+/** \brief Add the result of a pass search to the cache.
+ *  \param sat The satellite.
+ *  \param qth The ground station.
+ *  \param cfg The prediction settings.
+ *  \param from The time the search started at, as returned by
+ *              pass_cache_lookup().
+ *  \param maxdt The number of days searched (0 for no limit).
+ *  \param pass The pass found or NULL if there is none within maxdt. The
+ *              cache takes ownership of the pass.
+ *
+ * The result is dropped if the entry has changed since the lookup, e.g.
+ * because another thread has extended it in the meantime.
+ */
+void
+pass_cache_store (sat_t *sat, qth_t *qth, const predict_cfg_t *cfg,
+                  gdouble from, gdouble maxdt, pass_t *pass)
+{
+    pass_cache_entry_t *entry;
+
+
+    G_LOCK (cache);
+
+    entry = get_entry (sat, qth, cfg);
+
+    /* the search must have started where pass_cache_lookup() said */
+    if (from != covered_end (entry)) {
+        free_pass (pass);
+    }
+    else if (pass == NULL) {
+        entry->end = (maxdt > 0.0) ? from + maxdt : G_MAXDOUBLE;
+    }
+    else if (pass->los <= from) {
+        /* should not happen, but make sure the window moves on */
+        entry->end = from + PASS_CACHE_GAP;
+        free_pass (pass);
+    }
+    else {
+        entry->passes = g_slist_append (entry->passes, pass);
+        entry->end = MAX (from, pass->aos);
+    }
+
+    G_UNLOCK (cache);
+}
+
+
+/** \brief Remove all passes from the cache.
+ *
+ * This is called when the satellites have been reloaded after a TLE update
+ * and when gpredict exits. Entries are also reset on their own when the TLE
+ * epoch changes, so this mainly frees the memory of stale entries.
+ */
+void
+pass_cache_clear (void)
+{
+    G_LOCK (cache);
+
+    if (cache != NULL) {
+        g_hash_table_destroy (cache);
+        cache = NULL;
+    }
+
+    G_UNLOCK (cache);
+}
+
+
+/** \brief Remove the passes of a satellite from the cache.
+ *  \param catnr The catalogue number of the satellite.
+ *
+ * This is called when the TLE of a single satellite has changed, so that
+ * the entries of the other satellites are kept.
+ */
+void
+pass_cache_forget (gint catnr)
+{
+    G_LOCK (cache);
+
+    if (cache != NULL)
+        g_hash_table_foreach_remove (cache, match_catnr, &catnr);
+
+    G_UNLOCK (cache);
+}
+
+
+/** \brief Get the cache entry of a satellite and a ground station.
+ *
+ * The entry is created if it does not exist yet and reset if it has been
+ * filled with other elements or prediction settings. The settings are
+ * passed in by the caller, since the configuration can only be read in the
+ * main thread. Must be called with the lock held.
+ */
+static pass_cache_entry_t *
+get_entry (sat_t *sat, qth_t *qth, const predict_cfg_t *cfg)
+{
+    pass_cache_entry_t *entry;
+    pass_cache_key_t    key;
+
+
+    if (cache == NULL)
+        cache = g_hash_table_new_full (key_hash, key_equal, NULL, free_entry);
+
+    key.catnr = sat->tle.catnr;
+    key.lat = qth->lat;
+    key.lon = qth->lon;
+    key.alt = qth->alt;
+
+    entry = g_hash_table_lookup (cache, &key);
+
+    if (entry == NULL) {
+        entry = g_new0 (pass_cache_entry_t, 1);
+        entry->key = key;
+        g_hash_table_insert (cache, &entry->key, entry);
+    }
+    else if ((entry->epoch == sat->tle.epoch) &&
+             (entry->cfg.min_el == cfg->min_el) &&
+             (entry->cfg.tres == cfg->tres) &&
+             (entry->cfg.entries == cfg->entries) &&
+             (entry->cfg.maxerr == cfg->maxerr) &&
+             (entry->cfg.twilight == cfg->twilight)) {
+        return entry;
+    }
+
+    entry->epoch = sat->tle.epoch;
+    entry->cfg = *cfg;
+    reset_entry (entry, 0.0);
+
+    return entry;
+}
+
+
+/** \brief Empty an entry and start a new window at start. */
+static void
+reset_entry (pass_cache_entry_t *entry, gdouble start)
+{
+    free_passes (entry->passes);
+
+    entry->passes = NULL;
+    entry->start = start;
+    entry->end = start;
+}
+
+
+/** \brief Get the time up to which an entry is known to be complete.
+ *
+ * There is no pass between the LOS of the last pass and the search for the
+ * next one, so the entry covers at least PASS_CACHE_GAP beyond that LOS.
+ */
+static gdouble
+covered_end (pass_cache_entry_t *entry)
+{
+    GSList *last;
+
+
+    last = g_slist_last (entry->passes);
+    if (last == NULL)
+        return entry->end;
+
+    return MAX (entry->end, PASS (last->data)->los + PASS_CACHE_GAP);
+}
+
+
+/** \brief Free a cache entry. */
+static void
+free_entry (gpointer data)
+{
+    pass_cache_entry_t *entry = (pass_cache_entry_t *) data;
+
+
+    free_passes (entry->passes);
+    g_free (entry);
+}
+
+
+/** \brief Hash function of pass_cache_key_t. */
+static guint
+key_hash (gconstpointer key)
+{
+    const pass_cache_key_t *k = key;
+
+
+    return (guint) k->catnr ^ g_double_hash (&k->lat) ^
+        (g_double_hash (&k->lon) << 1) ^ ((guint) k->alt << 16);
+}
+
+
+/** \brief Equality function of pass_cache_key_t. */
+static gboolean
+key_equal (gconstpointer a, gconstpointer b)
+{
+    const pass_cache_key_t *ka = a;
+    const pass_cache_key_t *kb = b;
+
+
+    return (ka->catnr == kb->catnr) && (ka->lat == kb->lat) &&
+        (ka->lon == kb->lon) && (ka->alt == kb->alt);
+}
+
+
+/** \brief Check whether an entry belongs to a satellite. */
+static gboolean
+match_catnr (gpointer key, gpointer value, gpointer data)
+{
+    const pass_cache_key_t *k = key;
+
+
+    return k->catnr == *((gint *) data);
+}
@@ -0,0 +1,43 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2010  Alexandru Csete, OZ9AEC.
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+#ifndef PASS_CACHE_H
+#define PASS_CACHE_H 1
+
+#include <glib.h>
+#include "sgpsdp/sgp4sdp4.h"
+#include "qth-data.h"
+#include "predict-tools.h"
+
+
+gboolean pass_cache_lookup (sat_t *sat, qth_t *qth, const predict_cfg_t *cfg,
+                            gdouble start, gdouble maxdt,
+                            pass_t **pass, gdouble *from);
+void     pass_cache_store  (sat_t *sat, qth_t *qth, const predict_cfg_t *cfg,
+                            gdouble from, gdouble maxdt, pass_t *pass);
+void     pass_cache_clear  (void);
+void     pass_cache_forget (gint catnr);
+
+#endif
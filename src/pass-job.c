@@ -0,0 +1,292 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2010  Alexandru Csete, OZ9AEC.
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \brief Parallel pass prediction for several satellites.
+ *
+ * Views such as the sky at a glance need the passes of every satellite in
+ * a module. A job copies the satellites and hands one task per satellite
+ * to a thread pool shared by all jobs; each task calls get_passes_cfg() on
+ * its copy with the settings read when the job was created, since the
+ * configuration is not thread safe. The results are delivered in the main loop as they come in,
+ * but always in the order of the satellites, so that the caller can build
+ * its view incrementally and still get the same layout as a serial loop.
+ *
+ * A job that is no longer needed is cancelled with pass_job_cancel().
+ * Tasks that have not started yet are then skipped, and results of tasks
+ * that are still running are dropped.
+ */
+#include <string.h>
+#include <glib.h>
+#include <glib/gi18n.h>
+#include "sat-cfg.h"
+#include "sat-log.h"
+#include "prop-pool.h"
+#include "pass-job.h"
+
+
+/** \brief A task: the passes of one satellite of a job. */
+typedef struct {
+    pass_job_t *job;
+    guint       index;
+} pass_task_t;
+
+
+static void     task_func (gpointer data, gpointer user_data);
+static gboolean deliver   (gpointer data);
+static void     job_ref   (pass_job_t *job);
+static void     job_unref (gpointer data);
+static void     add_sat   (gpointer key, gpointer value, gpointer data);
+
+
+G_LOCK_DEFINE_STATIC (pool);
+
+/** \brief The thread pool shared by all jobs. */
+static GThreadPool *pool = NULL;
+
+
+/** \brief Start predicting the passes of a set of satellites.
+ *  \param sats The satellites (sat_t) by catalogue number.
+ *  \param qth The ground station.
+ *  \param start Start of the time window.
+ *  \param maxdt Length of the time window [days].
+ *  \param num Max number of passes per satellite, see get_passes().
+ *  \param func Function receiving the passes of each satellite.
+ *  \param flush Function called after each batch of results has been
+ *               delivered, or NULL.
+ *  \param data User data passed to func and flush.
+ *  \return The new job. Cancel it with pass_job_cancel(), also after all
+ *          results have been delivered.
+ *
+ * The satellites and the ground station are copied, so they may change
+ * while the job is running. The satellites are indexed in the order in
+ * which g_hash_table_foreach() visits them.
+ */
+pass_job_t *
+pass_job_new (GHashTable *sats, qth_t *qth, gdouble start, gdouble maxdt,
+              guint num, pass_job_func_t func, GFunc flush, gpointer data)
+{
+    pass_job_t  *job;
+    pass_task_t *task;
+    GError      *err = NULL;
+    guint        i;
+
+
+    job = g_new0 (pass_job_t, 1);
+    job->ref = 1;
+    job->sats = g_ptr_array_new ();
+    job->qth = *qth;
+    job->start = start;
+    job->maxdt = maxdt;
+    job->num = num;
+    predict_cfg_read (&job->cfg);
+    job->func = func;
+    job->flush = flush;
+    job->data = data;
+    job->lock = g_mutex_new ();
+
+    g_hash_table_foreach (sats, add_sat, job->sats);
+
+    job->passes = g_new0 (GSList *, job->sats->len);
+    job->done = g_new0 (gboolean, job->sats->len);
+
+    G_LOCK (pool);
+
+    if (pool == NULL) {
+        pool = g_thread_pool_new (task_func, NULL,
+                                  prop_pool_num_threads (sat_cfg_get_int (SAT_CFG_INT_MODULE_THREADS)),
+                                  FALSE, &err);
+        if (pool == NULL) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Could not create thread pool (%s)"),
+                         __FUNCTION__, err->message);
+            g_clear_error (&err);
+        }
+    }
+
+    for (i = 0; i < job->sats->len; i++) {
+        task = g_new (pass_task_t, 1);
+        task->job = job;
+        task->index = i;
+        job_ref (job);
+
+        if (pool != NULL)
+            g_thread_pool_push (pool, task, NULL);
+        else
+            task_func (task, NULL);
+    }
+
+    G_UNLOCK (pool);
+
+    return job;
+}
+
+
+/** \brief Cancel a job and release it.
+ *
+ * No results are delivered after this call. Must be called from the main
+ * loop thread.
+ */
+void
+pass_job_cancel (pass_job_t *job)
+{
+    if (job == NULL)
+        return;
+
+    g_atomic_int_set (&job->cancelled, TRUE);
+
+    g_mutex_lock (job->lock);
+    if (job->idle_id != 0) {
+        g_source_remove (job->idle_id);
+        job->idle_id = 0;
+    }
+    g_mutex_unlock (job->lock);
+
+    job_unref (job);
+}
+
+
+/** \brief Compute the passes of one satellite in a worker thread. */
+static void
+task_func (gpointer data, gpointer user_data)
+{
+    pass_task_t *task = (pass_task_t *) data;
+    pass_job_t  *job = task->job;
+    GSList      *passes;
+
+
+    if (!g_atomic_int_get (&job->cancelled)) {
+        passes = get_passes_cfg (g_ptr_array_index (job->sats, task->index),
+                                 &job->qth, job->start, job->maxdt, job->num,
+                                 &job->cfg);
+
+        g_mutex_lock (job->lock);
+
+        job->passes[task->index] = passes;
+        job->done[task->index] = TRUE;
+
+        /* only the next result in order makes a delivery worthwhile */
+        if ((task->index == job->next) && (job->idle_id == 0) &&
+            !g_atomic_int_get (&job->cancelled)) {
+            job_ref (job);
+            job->idle_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, deliver,
+                                            job, job_unref);
+        }
+
+        g_mutex_unlock (job->lock);
+    }
+
+    job_unref (job);
+    g_free (task);
+}
+
+
+/** \brief Deliver the available results in order in the main loop. */
+static gboolean
+deliver (gpointer data)
+{
+    pass_job_t *job = (pass_job_t *) data;
+    GSList     *passes;
+    guint       index;
+    guint       count = 0;
+
+
+    g_mutex_lock (job->lock);
+
+    job->idle_id = 0;
+
+    while ((job->next < job->sats->len) && job->done[job->next]) {
+        index = job->next++;
+        passes = job->passes[index];
+        job->passes[index] = NULL;
+
+        g_mutex_unlock (job->lock);
+
+        job->func (index, g_ptr_array_index (job->sats, index), passes,
+                   job->data);
+        count++;
+
+        g_mutex_lock (job->lock);
+    }
+
+    g_mutex_unlock (job->lock);
+
+    if ((count > 0) && (job->flush != NULL))
+        job->flush (job, job->data);
+
+    return FALSE;
+}
+
+
+/** \brief Add a copy of a satellite to the satellites of a job. */
+static void
+add_sat (gpointer key, gpointer value, gpointer data)
+{
+    sat_t *sat;
+
+
+    sat = g_memdup (value, sizeof (sat_t));
+    sat->name = g_strdup (SAT (value)->name);
+    sat->nickname = g_strdup (SAT (value)->nickname);
+    sat->website = g_strdup (SAT (value)->website);
+
+    g_ptr_array_add ((GPtrArray *) data, sat);
+}
+
+
+/** \brief Take a reference to a job. */
+static void
+job_ref (pass_job_t *job)
+{
+    g_atomic_int_inc (&job->ref);
+}
+
+
+/** \brief Release a reference to a job and free it with the last one. */
+static void
+job_unref (gpointer data)
+{
+    pass_job_t *job = (pass_job_t *) data;
+    sat_t      *sat;
+    guint       i;
+
+
+    if (!g_atomic_int_dec_and_test (&job->ref))
+        return;
+
+    for (i = 0; i < job->sats->len; i++) {
+        sat = SAT (g_ptr_array_index (job->sats, i));
+        free_passes (job->passes[i]);
+        g_free (sat->name);
+        g_free (sat->nickname);
+        g_free (sat->website);
+        g_free (sat);
+    }
+
+    g_ptr_array_free (job->sats, TRUE);
+    g_free (job->passes);
+    g_free (job->done);
+    g_mutex_free (job->lock);
+    g_free (job);
+}
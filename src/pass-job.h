@@ -0,0 +1,79 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2010  Alexandru Csete, OZ9AEC.
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+#ifndef PASS_JOB_H
+#define PASS_JOB_H 1
+
+#include <glib.h>
+#include "sgpsdp/sgp4sdp4.h"
+#include "qth-data.h"
+#include "predict-tools.h"
+
+
+/** \brief Function receiving the passes of a satellite.
+ *  \param index The index of the satellite in the job.
+ *  \param sat The satellite; only valid during the call.
+ *  \param passes The passes of the satellite. The function takes ownership
+ *                of the list.
+ *  \param data User data passed to pass_job_new().
+ */
+typedef void (*pass_job_func_t) (guint index, sat_t *sat, GSList *passes,
+                                 gpointer data);
+
+
+/** \brief Pass prediction for a set of satellites.
+ *
+ * The passes are computed by a shared pool of worker threads and handed
+ * to the caller in the main loop, in the order of the satellites.
+ */
+typedef struct {
+    volatile gint  ref;        /*!< Reference count. */
+    volatile gint  cancelled;  /*!< Set by pass_job_cancel(). */
+
+    GPtrArray     *sats;       /*!< Copies of the satellites (sat_t). */
+    qth_t          qth;        /*!< Copy of the ground station. */
+    gdouble        start;      /*!< Start of the time window. */
+    gdouble        maxdt;      /*!< Length of the time window [days]. */
+    guint          num;        /*!< Max number of passes per satellite. */
+    predict_cfg_t  cfg;        /*!< Prediction settings, read in the main thread. */
+
+    pass_job_func_t func;      /*!< Called for each satellite. */
+    GFunc          flush;      /*!< Called after each batch, may be NULL. */
+    gpointer       data;       /*!< User data for func and flush. */
+
+    GMutex        *lock;       /*!< Protects the fields below. */
+    GSList       **passes;     /*!< Results by satellite index. */
+    gboolean      *done;       /*!< Which results are available. */
+    guint          next;       /*!< Index of the next result to deliver. */
+    guint          idle_id;    /*!< Pending delivery in the main loop. */
+} pass_job_t;
+
+
+pass_job_t *pass_job_new    (GHashTable *sats, qth_t *qth, gdouble start,
+                             gdouble maxdt, guint num, pass_job_func_t func,
+                             GFunc flush, gpointer data);
+void        pass_job_cancel (pass_job_t *job);
+
+#endif
@@ -276,12 +276,12 @@ pass_to_txt_tblcontents (pass_t *pass, qth_t *qth, gint fields)
         tbuff[TIME_FORMAT_MAX_LENGTH-1] = '\0';
 
     /* get number of rows */
-    num = g_slist_length (pass->details);
+    num = pass->num_details;
 
     for (i = 0; i < num; i++) {
 
         /* get detail */
-        detail = PASS_DETAIL (g_slist_nth_data (pass->details, i));
+        detail = &pass->detail[i];
 
         /* time */
         t = (detail->time - 2440587.5)*86400.;
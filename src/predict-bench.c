@@ -0,0 +1,511 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2010  Alexandru Csete, OZ9AEC.
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \brief Benchmark for the AOS/LOS search of predict-tools.c
+ *
+ * Runs find_aos(), find_los() and find_prev_aos() for all satellites of a
+ * catalogue at a number of start times and compares them with the step and
+ * iterate search used by gpredict up to 1.3, which is kept here as
+ * reference. The number of predict_calc() calls and the wall time of both
+ * implementations are reported.
+ *
+ * The reference stops as soon as the elevation is within 0.005 deg of the
+ * horizon, so it is not always accurate to PREDICT_BENCH_TOL and sometimes
+ * reports a pass for a satellite that stays just below the horizon. An
+ * event that differs by more than PREDICT_BENCH_TOL is therefore accepted
+ * if the new time is within PREDICT_BENCH_TOL of the crossing or closer to
+ * it than the reference, or if the reference event is not a horizon
+ * crossing at all. Any other difference is a failure.
+ *
+ * The benchmark includes predict-tools.c so that it can count the calls to
+ * predict_calc(). It is not built by default, use "make predict-bench".
+ *
+ * Usage: predict-bench [catalogue]
+ */
+#define PREDICT_BENCH 1
+#include "predict-tools.c"
+
+
+/** \brief Default satellite catalogue, relative to src/. */
+#define PREDICT_BENCH_CATALOGUE "../data/satdata/satellites.dat"
+
+/** \brief Number of start times per satellite. */
+#define PREDICT_BENCH_STARTS 8
+
+/** \brief Look-ahead time of the searches [days]. */
+#define PREDICT_BENCH_MAXDT 3.0
+
+/** \brief Largest difference of an AOS or LOS time that counts as equal [sec]. */
+#define PREDICT_BENCH_TOL 1.0
+
+/** \brief Time around a reference event searched for a crossing [sec]. */
+#define PREDICT_BENCH_WINDOW 60
+
+
+/** \brief Outcome of the comparison of two event times. */
+typedef enum {
+    EVENT_EQUAL = 0,     /*!< Equal within PREDICT_BENCH_TOL. */
+    EVENT_REF_TOL,       /*!< The new time is closer to the crossing. */
+    EVENT_REF_FALSE,     /*!< The reference event is not a crossing. */
+    EVENT_DIFFERENT,     /*!< Unexplained difference. */
+    EVENT_NUM
+} event_cmp_t;
+
+
+/** \brief Results of one implementation. */
+typedef struct {
+    guint    calls;    /*!< Number of predict_calc() calls. */
+    gdouble  time;     /*!< Wall time [sec]. */
+} bench_t;
+
+
+static gdouble ref_find_aos      (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt);
+static gdouble ref_find_los      (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt);
+static gdouble ref_find_prev_aos (sat_t *sat, qth_t *qth, gdouble start);
+static guint   read_catalogue    (const gchar *file, sat_t **sats, guint max);
+
+
+/** \brief Get the elevation of a satellite.
+ *
+ * SDP4 keeps the lunar and solar terms for 30 minutes, so the result
+ * depends on the previous calls; a fresh copy of the satellite is used to
+ * make the elevation of the reference and the new event comparable.
+ */
+static gdouble
+elevation (sat_t *sat, qth_t *qth, gdouble t)
+{
+    sat_t work;
+
+
+    memcpy (&work, sat, sizeof (sat_t));
+    predict_calc (&work, qth, t);
+
+    return work.el;
+}
+
+
+/** \brief Compare two event times.
+ *  \param sat The satellite.
+ *  \param qth The observer.
+ *  \param ref The time found by the reference implementation.
+ *  \param new The time found by the new implementation.
+ *  \param maxdiff The largest difference of equal events so far [sec].
+ */
+static event_cmp_t
+compare_event (sat_t *sat, qth_t *qth, gdouble ref, gdouble new,
+               gdouble *maxdiff)
+{
+    gdouble elnew, slope;
+    gint    i;
+
+
+    if ((ref == 0.0) && (new == 0.0))
+        return EVENT_EQUAL;
+
+    if ((ref != 0.0) && (new != 0.0) &&
+        (fabs (ref - new) * secday <= PREDICT_BENCH_TOL)) {
+
+        *maxdiff = MAX (*maxdiff, fabs (ref - new) * secday);
+        return EVENT_EQUAL;
+    }
+
+    if (ref == 0.0)
+        return EVENT_DIFFERENT;
+
+    /* is the satellite above the horizon anywhere near the reference? */
+    for (i = -PREDICT_BENCH_WINDOW; i <= PREDICT_BENCH_WINDOW; i++)
+        if (elevation (sat, qth, ref + i / secday) > 0.0)
+            break;
+
+    if (i > PREDICT_BENCH_WINDOW)
+        return EVENT_REF_FALSE;
+
+    if ((new == 0.0) || (fabs (ref - new) * secday > PREDICT_BENCH_WINDOW))
+        return EVENT_DIFFERENT;
+
+    elnew = fabs (elevation (sat, qth, new));
+    slope = fabs (elevation (sat, qth, new + 0.5 / secday) -
+                  elevation (sat, qth, new - 0.5 / secday));
+
+    /* closer to the crossing than the reference or close enough */
+    if ((elnew <= fabs (elevation (sat, qth, ref))) ||
+        (elnew <= slope * PREDICT_BENCH_TOL))
+        return EVENT_REF_TOL;
+
+    return EVENT_DIFFERENT;
+}
+
+
+int
+main (int argc, char **argv)
+{
+    static sat_t *sats[4000];
+    qth_t     qth;
+    sat_t     work;
+    GTimer   *timer;
+    bench_t   ref = {0, 0.0};
+    bench_t   new = {0, 0.0};
+    gdouble   ref_aos, ref_los, ref_prev;
+    gdouble   new_aos, new_los, new_prev;
+    gdouble   maxdiff = 0.0;
+    gdouble   start;
+    guint     count[EVENT_NUM] = {0, 0, 0, 0};
+    guint     nsats, i, j;
+    event_cmp_t aos, los, prev;
+
+
+    nsats = read_catalogue ((argc > 1) ? argv[1] : PREDICT_BENCH_CATALOGUE,
+                            sats, G_N_ELEMENTS (sats));
+    if (nsats == 0) {
+        g_print ("No satellites found\n");
+        return 1;
+    }
+
+    /* Copenhagen */
+    memset (&qth, 0, sizeof (qth_t));
+    qth.lat = 55.6867;
+    qth.lon = 12.5701;
+    qth.alt = 10;
+    qth_data_update_obs (&qth);
+
+    timer = g_timer_new ();
+
+    for (i = 0; i < nsats; i++) {
+        for (j = 0; j < PREDICT_BENCH_STARTS; j++) {
+
+            start = sats[i]->jul_epoch + 0.1371 * j;
+
+            /* reference implementation */
+            memcpy (&work, sats[i], sizeof (sat_t));
+            predict_calc_count = 0;
+            g_timer_start (timer);
+            ref_aos = ref_find_aos (&work, &qth, start, PREDICT_BENCH_MAXDT);
+            ref_los = ref_find_los (&work, &qth, start, PREDICT_BENCH_MAXDT);
+            ref_prev = ref_find_prev_aos (&work, &qth, start);
+            ref.time += g_timer_elapsed (timer, NULL);
+            ref.calls += predict_calc_count;
+
+            /* new implementation */
+            memcpy (&work, sats[i], sizeof (sat_t));
+            predict_calc_count = 0;
+            g_timer_start (timer);
+            new_aos = find_aos (&work, &qth, start, PREDICT_BENCH_MAXDT);
+            new_los = find_los (&work, &qth, start, PREDICT_BENCH_MAXDT);
+            new_prev = find_prev_aos (&work, &qth, start);
+            new.time += g_timer_elapsed (timer, NULL);
+            new.calls += predict_calc_count;
+
+            aos = compare_event (sats[i], &qth, ref_aos, new_aos, &maxdiff);
+            los = compare_event (sats[i], &qth, ref_los, new_los, &maxdiff);
+            count[aos]++;
+            count[los]++;
+
+            if ((aos == EVENT_DIFFERENT) || (los == EVENT_DIFFERENT))
+                g_print ("%s at %f: AOS %f/%f LOS %f/%f\n",
+                         sats[i]->nickname, start,
+                         ref_aos, new_aos, ref_los, new_los);
+
+            prev = compare_event (sats[i], &qth, ref_prev, new_prev, &maxdiff);
+            count[prev]++;
+
+            if (prev == EVENT_DIFFERENT)
+                g_print ("%s at %f: previous AOS %f/%f\n",
+                         sats[i]->nickname, start, ref_prev, new_prev);
+        }
+    }
+
+    g_timer_destroy (timer);
+
+    g_print ("%d satellites, %d start times each\n",
+             nsats, PREDICT_BENCH_STARTS);
+    g_print ("Reference: %9d calls %8.3f sec\n", ref.calls, ref.time);
+    g_print ("New:       %9d calls %8.3f sec\n", new.calls, new.time);
+    g_print ("Events equal:              %d (max difference %.3f sec)\n",
+             count[EVENT_EQUAL], maxdiff);
+    g_print ("Events closer to crossing: %d\n", count[EVENT_REF_TOL]);
+    g_print ("Events false in reference: %d\n", count[EVENT_REF_FALSE]);
+    g_print ("Events different:          %d\n", count[EVENT_DIFFERENT]);
+
+    if (count[EVENT_DIFFERENT] > 0) {
+        g_print ("FAILED\n");
+        return 1;
+    }
+
+    g_print ("PASSED\n");
+
+    return 0;
+}
+
+
+/** \brief Read the satellites of a catalogue.
+ *  \param file The catalogue, see data/satdata/satellites.dat.
+ *  \param sats Array for the satellites.
+ *  \param max The size of sats.
+ *  \return The number of satellites read.
+ */
+static guint
+read_catalogue (const gchar *file, sat_t **sats, guint max)
+{
+    FILE  *fp;
+    gchar  line[128];
+    gchar  name[80] = "";
+    gchar  tle_str[3][80];
+    sat_t *sat;
+    guint  n = 0;
+
+
+    fp = fopen (file, "r");
+    if (fp == NULL) {
+        g_print ("Could not open %s\n", file);
+        return 0;
+    }
+
+    while ((n < max) && fgets (line, sizeof (line), fp)) {
+
+        g_strchomp (line);
+
+        if (g_str_has_prefix (line, "NICKNAME=")) {
+            g_strlcpy (name, line + 9, sizeof (name));
+            continue;
+        }
+
+        if (g_str_has_prefix (line, "TLE1=")) {
+            g_strlcpy (tle_str[1], line + 5, sizeof (tle_str[1]));
+            continue;
+        }
+
+        if (!g_str_has_prefix (line, "TLE2="))
+            continue;
+
+        g_strlcpy (tle_str[0], name, sizeof (tle_str[0]));
+        g_strlcpy (tle_str[2], line + 5, sizeof (tle_str[2]));
+
+        sat = g_new0 (sat_t, 1);
+        if (Get_Next_Tle_Set (tle_str, &sat->tle) != 1) {
+            g_free (sat);
+            continue;
+        }
+
+        sat->nickname = g_strdup (name);
+        select_ephemeris (sat);
+        gtk_sat_data_init_sat (sat, NULL);
+
+        sats[n++] = sat;
+    }
+
+    fclose (fp);
+
+    return n;
+}
+
+
+/* The AOS/LOS search of gpredict 1.3, see find_aos() and find_los(). */
+
+static gdouble
+ref_find_aos (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt)
+{
+    gdouble t = start;
+    gdouble aostime = 0.0;
+
+
+    /* make sure current sat values are
+        in sync with the time
+    */
+    predict_calc (sat, qth, start);
+
+    /* check whether satellite has aos */
+    if ((sat->otype == ORBIT_TYPE_GEO) || 
+        (sat->otype == ORBIT_TYPE_DECAYED) ||
+        !has_aos (sat, qth)) {
+
+        return 0.0;
+
+    }
+
+
+    if (sat->el > 0.0)
+        t = ref_find_los (sat, qth, start, maxdt) + 0.014; // +20 min
+
+    /* invalid time (potentially returned by find_los) */
+    if (t < 0.1)
+        return 0.0;
+
+    /* update satellite data */
+    predict_calc (sat, qth, t);
+
+    /* use upper time limit */
+    if (maxdt > 0.0) {
+
+        /* coarse time steps */
+        while ((sat->el < -1.0) && (t <= (start + maxdt))) {
+            t -= 0.00035 * (sat->el * ((sat->alt / 8400.0) + 0.46) - 2.0);
+            predict_calc (sat, qth, t);
+        }
+
+        /* fine steps */
+        while ((aostime == 0.0) && (t <= (start + maxdt))) {
+
+            if (fabs (sat->el) < 0.005) {
+                aostime = t;
+            }
+            else {
+                t -= sat->el * sqrt (sat->alt) / 530000.0;
+                predict_calc (sat, qth, t);
+            }
+
+        }
+
+    }
+    /* don't use upper time limit */
+    else {
+
+        /* coarse time steps */
+        while (sat->el < -1.0) {
+
+            t -= 0.00035 * (sat->el * ((sat->alt / 8400.0) + 0.46) - 2.0);
+            predict_calc (sat, qth, t);
+        }
+
+        /* fine steps */
+        while (aostime == 0.0) {
+
+            if (fabs (sat->el) < 0.005) {
+                aostime = t;
+            }
+            else {
+                t -= sat->el * sqrt (sat->alt) / 530000.0;
+                predict_calc (sat, qth, t);
+            }
+
+        }
+    }
+
+
+    return aostime;
+}
+
+
+static gdouble
+ref_find_los (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt)
+{
+    gdouble t = start;
+    gdouble lostime = 0.0;
+
+
+    predict_calc (sat, qth, start);
+
+    /* check whether satellite has aos */
+    if ((sat->otype == ORBIT_TYPE_GEO) || 
+        (sat->otype == ORBIT_TYPE_DECAYED) ||
+        !has_aos (sat, qth)) {
+
+        return 0.0;
+
+    }
+
+
+    if (sat->el < 0.0)
+        t = ref_find_aos (sat, qth, start, maxdt) + 0.001; // +1.5 min
+
+    /* invalid time (potentially returned by find_aos) */
+    if (t < 0.01)
+        return 0.0;
+
+    /* update satellite data */
+    predict_calc (sat, qth, t);
+
+
+    /* use upper time limit */
+    if (maxdt > 0.0) {
+
+        /* coarse steps */
+        while ((sat->el >= 1.0) && (t <= (start + maxdt))) {
+            t += cos((sat->el - 1.0) * de2ra) * sqrt(sat->alt) / 25000.0;
+            predict_calc (sat, qth, t);
+        }
+
+        /* fine steps */
+        while ((lostime == 0.0) && (t <= (start + maxdt)))  {
+            
+            t += sat->el * sqrt(sat->alt)/502500.0;
+            predict_calc (sat, qth, t);
+            
+            if (fabs(sat->el) < 0.005)
+                lostime = t;
+        }
+    }
+
+    /* don't use upper limit */
+    else {
+
+        /* coarse steps */
+        while (sat->el >= 1.0) {
+            t += cos((sat->el - 1.0) * de2ra) * sqrt(sat->alt) / 25000.0;
+            predict_calc (sat, qth, t);
+        }
+
+        /* fine steps */
+        while (lostime == 0.0) {
+            
+            t += sat->el * sqrt(sat->alt)/502500.0;
+            predict_calc (sat, qth, t);
+            
+            if (fabs(sat->el) < 0.005)
+                lostime = t;
+        }
+    }
+
+
+    return lostime;
+}
+
+
+static gdouble
+ref_find_prev_aos (sat_t *sat, qth_t *qth, gdouble start)
+{
+    gdouble aostime = start;
+
+
+    /* make sure current sat values are
+        in sync with the time
+    */
+    predict_calc (sat, qth, start);
+
+    /* check whether satellite has aos */
+    if ((sat->otype == ORBIT_TYPE_GEO) || 
+        (sat->otype == ORBIT_TYPE_DECAYED) ||
+        !has_aos (sat, qth)) {
+
+        return 0.0;
+
+    }
+
+    while (sat->el >= 0.0) {
+        aostime -= 0.0005; // 0.75 min
+        predict_calc (sat, qth, aostime);
+    }
+
+    return aostime;
+}
@@ -39,29 +39,125 @@
 #include "sat-cfg.h"
 #include "orbit-tools.h"
 #include "predict-tools.h"
+#include "pass-cache.h"
 #include "sat-log.h"
 
 
-/** \brief SGP4SDP4 driver for doing AOS/LOS calculations.
+/** \brief Max number of satellites transformed to topocentric coordinates
+ *         at a time. */
+#define PREDICT_BATCH_SIZE 32
+
+/** \brief Accuracy of the AOS and LOS times [days], about 0.1 sec. */
+#define PREDICT_TIME_TOL 1.0e-6
+
+/** \brief Max number of iterations for refining an AOS or LOS time. */
+#define PREDICT_MAX_ITER 100
+
+/** \brief Smallest number of steps per orbit when searching for AOS/LOS. */
+#define PREDICT_ORBIT_STEPS 100
+
+/** \brief Safety factor of the rate and velocity limits of the search. */
+#define PREDICT_SEARCH_MARGIN 1.05
+
+/** \brief Margin added to the visibility circle of the search [rad]. */
+#define PREDICT_HORIZON_MARGIN 0.02
+
+/** \brief Elevation above which a maximum between two steps is searched [deg]. */
+#define PREDICT_PEAK_EL -1.0
+
+/** \brief Accuracy of the search for a maximum [days], about 1 sec. */
+#define PREDICT_PEAK_TOL 1.0e-5
+
+/** \brief Max number of detail steps between two adaptive track samples. */
+#define PREDICT_SAMPLE_SKIP 8
+
+/** \brief Min number of adaptive segments of a pass.
+ *
+ * The polar views put up to 5 time ticks on the intermediate samples of a
+ * sky track, so a pass needs at least 7 samples.
+ */
+#define PREDICT_SAMPLE_MIN_SEGMENTS 6
+
+
+/** \brief Orbit dependent limits of the AOS/LOS search, see init_search(). */
+typedef struct {
+    gdouble  robs;      /*!< Distance of the observer from the centre [km]. */
+    gdouble  minstep;   /*!< Smallest time step [days]. */
+    gdouble  rate;      /*!< Max angular rate of the satellite [rad/day]. */
+    gdouble  horizon;   /*!< Max geocentric angle of a visible satellite [rad]. */
+    gdouble  velo;      /*!< Max velocity relative to the observer [km/day]. */
+} search_t;
+
+
+#ifdef PREDICT_BENCH
+/** \brief Number of predict_calc() calls, see predict-bench.c. */
+static guint predict_calc_count = 0;
+#endif
+
+
+static void    calc_tracking_data (sat_t **sats, guint n, qth_t *qth, gdouble t);
+static void    derive_tracking_data (sat_t **sats, guint n, qth_t *qth, gdouble t);
+static void    init_search        (sat_t *sat, qth_t *qth, search_t *search);
+static gdouble search_step        (sat_t *sat, qth_t *qth, search_t *search);
+static gdouble find_crossing      (sat_t *sat, qth_t *qth, search_t *search,
+                                   gdouble t, gdouble tmax, gint dir,
+                                   gboolean above);
+static gdouble refine_crossing    (sat_t *sat, qth_t *qth,
+                                   gdouble a, gdouble fa,
+                                   gdouble b, gdouble fb);
+static gdouble find_peak          (sat_t *sat, qth_t *qth,
+                                   gdouble a, gdouble b, gboolean horizon);
+static pass_t *compute_pass       (sat_t *sat_in, qth_t *qth,
+                                   gdouble start, gdouble maxdt,
+                                   const predict_cfg_t *cfg);
+static void    sample_pass        (sat_t *sat, qth_t *qth, pass_t *pass,
+                                   gdouble step, const predict_cfg_t *cfg);
+static void    sample_segment     (sat_t *sat, qth_t *qth,
+                                   const pass_detail_t *a,
+                                   const pass_detail_t *b,
+                                   gdouble step, gdouble maxerr,
+                                   gdouble twilight, GArray *samples);
+static gdouble sample_error       (const pass_detail_t *a,
+                                   const pass_detail_t *m,
+                                   const pass_detail_t *b);
+static void    calc_detail        (sat_t *sat, qth_t *qth, gdouble t,
+                                   gdouble twilight, pass_detail_t *detail);
+static void    summarize_pass     (sat_t *sat, qth_t *qth, pass_t *pass);
+
+
+/** \brief SGP4SDP4 driver.
  *  \param sat Pointer to the satellite data.
  *  \param qth Pointer to the QTH data.
  *  \param t The time for calculation (Julian Date)
  *
+ * This and predict_calc_batch() are the only SGP4/SDP4 drivers used for
+ * updating the satellite data, both for real time tracking and for AOS/LOS
+ * calculations. The observer
+ * terms are taken from qth->obs, which is precomputed when the QTH is
+ * loaded (see qth_data_update_obs()).
  */
 void
 predict_calc (sat_t *sat, qth_t *qth, gdouble t)
 {
-    obs_set_t     obs_set;
-    geodetic_t    sat_geodetic;
-    geodetic_t    obs_geodetic;
-    double        age;
+#ifdef PREDICT_BENCH
+    predict_calc_count++;
+#endif
 
+    predict_calc_eci (sat, t);
+    derive_tracking_data (&sat, 1, qth, t);
+}
 
-    obs_geodetic.lon = qth->lon * de2ra;
-    obs_geodetic.lat = qth->lat * de2ra;
-    obs_geodetic.alt = qth->alt / 1000.0;
-    obs_geodetic.theta = 0;
 
+/** \brief Propagate a satellite without calculating the tracking data.
+ *  \param sat Pointer to the satellite data.
+ *  \param t The time for calculation (Julian Date)
+ *
+ * Only sat->pos and sat->vel, converted to km and km/s, and sat->phase in
+ * radians are valid afterwards. predict_calc_state() calculates the rest.
+ */
+void
+predict_calc_eci (sat_t *sat, gdouble t)
+{
     sat->jul_utc = t;
     sat->tsince = (sat->jul_utc - sat->jul_epoch) * xmnpda;
 
@@ -72,165 +168,195 @@ predict_calc (sat_t *sat, qth_t *qth, gdouble t)
         SGP4 (sat, sat->tsince);
 
     Convert_Sat_State (&sat->pos, &sat->vel);
-
-    /* get the velocity of the satellite */
-    Magnitude (&sat->vel);
-    sat->velo = sat->vel.w;
-    Calculate_Obs (sat->jul_utc, &sat->pos, &sat->vel, &obs_geodetic, &obs_set);
-    Calculate_LatLonAlt (sat->jul_utc, &sat->pos, &sat_geodetic);
-
-    while (sat_geodetic.lon < -pi)
-        sat_geodetic.lon += twopi;
-
-    while (sat_geodetic.lon > (pi))
-        sat_geodetic.lon -= twopi;
-
-    sat->az = Degrees (obs_set.az);
-    sat->el = Degrees (obs_set.el);
-    sat->range = obs_set.range;
-    sat->range_rate = obs_set.range_rate;
-    sat->ssplat = Degrees (sat_geodetic.lat);
-    sat->ssplon = Degrees (sat_geodetic.lon);
-    sat->alt = sat_geodetic.alt;
-    sat->ma = Degrees (sat->phase);
-    sat->ma *= 256.0/360.0;
-    sat->phase = Degrees (sat->phase);
-
-    /* same formulas, but the one from predict is nicer */
-    //sat->footprint = 2.0 * xkmper * acos (xkmper/sat->pos.w);
-    sat->footprint = 12756.33 * acos (xkmper / (xkmper+sat->alt));
-    age = sat->jul_utc - sat->jul_epoch;
-    sat->orbit = (long) floor((sat->tle.xno * xmnpda/twopi +
-                    age * sat->tle.bstar * ae) * age +
-                    sat->tle.xmo/twopi) + sat->tle.revnum - 1;
 }
 
 
-/** \brief Find the AOS time of the next pass.
- *  \author Alexandru Csete, OZ9AEC
- *  \author John A. Magliacane, KD2BD
+/** \brief Calculate the tracking data from a given state.
  *  \param sat Pointer to the satellite data.
  *  \param qth Pointer to the QTH data.
- *  \param start The time where calculation should start.
- *  \param maxdt The upper time limit in days (0.0 = no limit)
- *  \return The time of the next AOS or 0.0 if the satellite has no AOS.
- *
- * This function finds the time of AOS for the first coming pass taking place
- * no earlier that start.
- * If the satellite is currently within range, the function first calls
- * find_los to get the next LOS time. Then the calculations are done using
- * the new start time.
+ *  \param t The time of the state (Julian Date)
  *
+ * sat->pos and sat->vel must hold the position and velocity in km and km/s
+ * and sat->phase the phase in radians at t, as left by predict_calc_eci()
+ * or interpolated from its results. The result is the same as from
+ * predict_calc() for that state.
  */
-gdouble
-find_aos (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt)
+void
+predict_calc_state (sat_t *sat, qth_t *qth, gdouble t)
 {
-    gdouble t = start;
-    gdouble aostime = 0.0;
-
+    sat->jul_utc = t;
+    sat->tsince = (sat->jul_utc - sat->jul_epoch) * xmnpda;
 
-    /* make sure current sat values are
-        in sync with the time
-    */
-    predict_calc (sat, qth, start);
+    derive_tracking_data (&sat, 1, qth, t);
+}
 
-    /* check whether satellite has aos */
-    if ((sat->otype == ORBIT_TYPE_GEO) || 
-        (sat->otype == ORBIT_TYPE_DECAYED) ||
-        !has_aos (sat, qth)) {
 
-        return 0.0;
+/** \brief Read the prediction settings.
+ *  \param cfg The settings to fill in.
+ *
+ * The configuration is not thread safe, so this must be called in the main
+ * thread; the settings can then be used for predictions in other threads.
+ */
+void
+predict_cfg_read (predict_cfg_t *cfg)
+{
+    cfg->min_el   = sat_cfg_get_int (SAT_CFG_INT_PRED_MIN_EL);
+    cfg->tres     = sat_cfg_get_int (SAT_CFG_INT_PRED_RESOLUTION);
+    cfg->entries  = sat_cfg_get_int (SAT_CFG_INT_PRED_NUM_ENTRIES);
+    cfg->maxerr   = sat_cfg_get_int (SAT_CFG_INT_PRED_MAX_ERROR);
+    cfg->twilight = sat_cfg_get_int (SAT_CFG_INT_PRED_TWILIGHT_THLD);
+}
 
-    }
 
+/** \brief SGP4SDP4 driver for several satellites.
+ *  \param sats The satellites.
+ *  \param n The number of satellites.
+ *  \param qth Pointer to the QTH data.
+ *  \param t The time for calculation (Julian Date)
+ *
+ * This function gives the same results as calling predict_calc() for each
+ * satellite. The satellites are propagated one by one, but the tracking
+ * data is calculated for PREDICT_BATCH_SIZE satellites at a time, so the
+ * sidereal time and the observer terms are shared.
+ */
+void
+predict_calc_batch (sat_t **sats, guint n, qth_t *qth, gdouble t)
+{
+    guint   first,last;
+    guint   i;
 
-    if (sat->el > 0.0)
-        t = find_los (sat, qth, start, maxdt) + 0.014; // +20 min
 
-    /* invalid time (potentially returned by find_los) */
-    if (t < 0.1)
-        return 0.0;
+    for (first = 0; first < n; first += PREDICT_BATCH_SIZE) {
 
-    /* update satellite data */
-    predict_calc (sat, qth, t);
+        last = MIN (first + PREDICT_BATCH_SIZE, n);
 
-    /* use upper time limit */
-    if (maxdt > 0.0) {
+        for (i = first; i < last; i++) {
+            sats[i]->jul_utc = t;
+            sats[i]->tsince = (t - sats[i]->jul_epoch) * xmnpda;
 
-        /* coarse time steps */
-        while ((sat->el < -1.0) && (t <= (start + maxdt))) {
-            t -= 0.00035 * (sat->el * ((sat->alt / 8400.0) + 0.46) - 2.0);
-            predict_calc (sat, qth, t);
+            if (sats[i]->flags & DEEP_SPACE_EPHEM_FLAG)
+                SDP4 (sats[i], sats[i]->tsince);
+            else
+                SGP4 (sats[i], sats[i]->tsince);
         }
 
-        /* fine steps */
-        while ((aostime == 0.0) && (t <= (start + maxdt))) {
+        calc_tracking_data (sats + first, last - first, qth, t);
+    }
+}
 
-            if (fabs (sat->el) < 0.005) {
-                aostime = t;
-            }
-            else {
-                t -= sat->el * sqrt (sat->alt) / 530000.0;
-                predict_calc (sat, qth, t);
-            }
 
-        }
+/** \brief Calculate the tracking data from the propagated state.
+ *  \param sats The satellites.
+ *  \param n The number of satellites, at most PREDICT_BATCH_SIZE.
+ *  \param qth Pointer to the QTH data.
+ *  \param t The time of the propagated state (Julian Date).
+ *
+ * sat->pos and sat->vel must hold the output of SGP4 or SDP4 for t.
+ */
+static void
+calc_tracking_data (sat_t **sats, guint n, qth_t *qth, gdouble t)
+{
+    guint i;
 
-    }
-    /* don't use upper time limit */
-    else {
 
-        /* coarse time steps */
-        while (sat->el < -1.0) {
+    for (i = 0; i < n; i++)
+        Convert_Sat_State (&sats[i]->pos, &sats[i]->vel);
 
-            t -= 0.00035 * (sat->el * ((sat->alt / 8400.0) + 0.46) - 2.0);
-            predict_calc (sat, qth, t);
-        }
+    derive_tracking_data (sats, n, qth, t);
+}
 
-        /* fine steps */
-        while (aostime == 0.0) {
 
-            if (fabs (sat->el) < 0.005) {
-                aostime = t;
-            }
-            else {
-                t -= sat->el * sqrt (sat->alt) / 530000.0;
-                predict_calc (sat, qth, t);
-            }
+/** \brief Calculate the tracking data from the state in km and km/s.
+ *  \param sats The satellites.
+ *  \param n The number of satellites, at most PREDICT_BATCH_SIZE.
+ *  \param qth Pointer to the QTH data.
+ *  \param t The time of the state (Julian Date).
+ *
+ * The sidereal time and the observer position are the same for all
+ * satellites, so the topocentric and geodetic coordinates are calculated
+ * for the whole set at once.
+ */
+static void
+derive_tracking_data (sat_t **sats, guint n, qth_t *qth, gdouble t)
+{
+    sat_t        *sat;
+    vector_t      pos[PREDICT_BATCH_SIZE];
+    vector_t      vel[PREDICT_BATCH_SIZE];
+    obs_set_t     obs_set[PREDICT_BATCH_SIZE];
+    geodetic_t    sat_geodetic[PREDICT_BATCH_SIZE];
+    double        age;
+    guint         i;
 
-        }
+
+    for (i = 0; i < n; i++) {
+        sat = sats[i];
+
+        /* get the velocity of the satellite */
+        Magnitude (&sat->vel);
+        sat->velo = sat->vel.w;
+
+        pos[i] = sat->pos;
+        vel[i] = sat->vel;
     }
 
+    Calculate_Obs_Array (t, pos, vel, n, &qth->obs, obs_set);
+    Calculate_LatLonAlt_Array (t, pos, n, sat_geodetic);
 
-    return aostime;
+    for (i = 0; i < n; i++) {
+        sat = sats[i];
+
+        while (sat_geodetic[i].lon < -pi)
+            sat_geodetic[i].lon += twopi;
+
+        while (sat_geodetic[i].lon > (pi))
+            sat_geodetic[i].lon -= twopi;
+
+        sat->az = Degrees (obs_set[i].az);
+        sat->el = Degrees (obs_set[i].el);
+        sat->range = obs_set[i].range;
+        sat->range_rate = obs_set[i].range_rate;
+        sat->ssplat = Degrees (sat_geodetic[i].lat);
+        sat->ssplon = Degrees (sat_geodetic[i].lon);
+        sat->alt = sat_geodetic[i].alt;
+        sat->ma = Degrees (sat->phase);
+        sat->ma *= 256.0/360.0;
+        sat->phase = Degrees (sat->phase);
+
+        /* same formulas, but the one from predict is nicer */
+        //sat->footprint = 2.0 * xkmper * acos (xkmper/sat->pos.w);
+        sat->footprint = 12756.33 * acos (xkmper / (xkmper+sat->alt));
+        age = sat->jul_utc - sat->jul_epoch;
+        sat->orbit = (long) floor((sat->tle.xno * xmnpda/twopi +
+                        age * sat->tle.bstar * ae) * age +
+                        sat->tle.xmo/twopi) + sat->tle.revnum - 1;
+    }
 }
 
 
-/** \brief Find the LOS time of the next pass.
+/** \brief Find the AOS time of the next pass.
  *  \author Alexandru Csete, OZ9AEC
  *  \author John A. Magliacane, KD2BD
  *  \param sat Pointer to the satellite data.
  *  \param qth Pointer to the QTH data.
  *  \param start The time where calculation should start.
  *  \param maxdt The upper time limit in days (0.0 = no limit)
- *  \return The time of the next LOS or 0.0 if the satellite has no LOS.
+ *  \return The time of the next AOS or 0.0 if the satellite has no AOS.
  *
- * This function finds the time of LOS for the first coming pass taking place
+ * This function finds the time of AOS for the first coming pass taking place
  * no earlier that start.
- * If the satellite is currently out of range, the function first calls
- * find_aos to get the next AOS time. Then the calculations are done using
- * the new start time.
- * The function has a built-in watchdog to ensure that we don't end up in
- * lengthy loops.
+ * If the satellite is currently within range, the current pass is skipped
+ * and the AOS of the following pass is returned.
  *
  */
 gdouble
-find_los (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt)
+find_aos (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt)
 {
-    gdouble t = start;
-    gdouble lostime = 0.0;
+    search_t search;
 
 
+    /* make sure current sat values are
+        in sync with the time
+    */
     predict_calc (sat, qth, start);
 
     /* check whether satellite has aos */
@@ -242,60 +368,49 @@ find_los (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt)
 
     }
 
+    init_search (sat, qth, &search);
 
-    if (sat->el < 0.0)
-        t = find_aos (sat, qth, start, maxdt) + 0.001; // +1.5 min
-
-    /* invalid time (potentially returned by find_aos) */
-    if (t < 0.01)
-        return 0.0;
-
-    /* update satellite data */
-    predict_calc (sat, qth, t);
+    return find_crossing (sat, qth, &search, start,
+                          (maxdt > 0.0) ? start + maxdt : 0.0, 1, TRUE);
+}
 
 
-    /* use upper time limit */
-    if (maxdt > 0.0) {
+/** \brief Find the LOS time of the next pass.
+ *  \author Alexandru Csete, OZ9AEC
+ *  \author John A. Magliacane, KD2BD
+ *  \param sat Pointer to the satellite data.
+ *  \param qth Pointer to the QTH data.
+ *  \param start The time where calculation should start.
+ *  \param maxdt The upper time limit in days (0.0 = no limit)
+ *  \return The time of the next LOS or 0.0 if the satellite has no LOS.
+ *
+ * This function finds the time of LOS for the first coming pass taking place
+ * no earlier that start.
+ * If the satellite is currently out of range, the LOS of the next pass is
+ * returned.
+ *
+ */
+gdouble
+find_los (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt)
+{
+    search_t search;
 
-        /* coarse steps */
-        while ((sat->el >= 1.0) && (t <= (start + maxdt))) {
-            t += cos((sat->el - 1.0) * de2ra) * sqrt(sat->alt) / 25000.0;
-            predict_calc (sat, qth, t);
-        }
 
-        /* fine steps */
-        while ((lostime == 0.0) && (t <= (start + maxdt)))  {
-            
-            t += sat->el * sqrt(sat->alt)/502500.0;
-            predict_calc (sat, qth, t);
-            
-            if (fabs(sat->el) < 0.005)
-                lostime = t;
-        }
-    }
+    predict_calc (sat, qth, start);
 
-    /* don't use upper limit */
-    else {
+    /* check whether satellite has aos */
+    if ((sat->otype == ORBIT_TYPE_GEO) || 
+        (sat->otype == ORBIT_TYPE_DECAYED) ||
+        !has_aos (sat, qth)) {
 
-        /* coarse steps */
-        while (sat->el >= 1.0) {
-            t += cos((sat->el - 1.0) * de2ra) * sqrt(sat->alt) / 25000.0;
-            predict_calc (sat, qth, t);
-        }
+        return 0.0;
 
-        /* fine steps */
-        while (lostime == 0.0) {
-            
-            t += sat->el * sqrt(sat->alt)/502500.0;
-            predict_calc (sat, qth, t);
-            
-            if (fabs(sat->el) < 0.005)
-                lostime = t;
-        }
     }
 
+    init_search (sat, qth, &search);
 
-    return lostime;
+    return find_crossing (sat, qth, &search, start,
+                          (maxdt > 0.0) ? start + maxdt : 0.0, 1, FALSE);
 }
 
 
@@ -306,12 +421,12 @@ find_los (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt)
  *  \return The time of the previous AOS or 0.0 if the satellite has no AOS.
  *
  * This function can be used to find the AOS time in the past of the
- * current pass.
+ * current pass. If the satellite is not within range, start is returned.
  */
 gdouble
 find_prev_aos (sat_t *sat, qth_t *qth, gdouble start)
 {
-    gdouble aostime = start;
+    search_t search;
 
 
     /* make sure current sat values are
@@ -328,14 +443,338 @@ find_prev_aos (sat_t *sat, qth_t *qth, gdouble start)
 
     }
 
-    while (sat->el >= 0.0) {
-        aostime -= 0.0005; // 0.75 min
-        predict_calc (sat, qth, aostime);
+    if (sat->el <= 0.0)
+        return start;
+
+    init_search (sat, qth, &search);
+
+    return find_crossing (sat, qth, &search, start, 0.0, -1, FALSE);
+}
+
+
+/** \brief Set up the step limits of the AOS/LOS search for a satellite.
+ *  \param sat Pointer to the satellite data.
+ *  \param qth Pointer to the QTH data.
+ *  \param search The search parameters to initialise.
+ *
+ * The limits are upper bounds for the angular rate and the velocity of
+ * the satellite seen from the rotating earth, derived from the mean motion
+ * and the eccentricity; they are used by search_step() to find out how far
+ * the satellite is at least from the horizon in time.
+ */
+static void
+init_search (sat_t *sat, qth_t *qth, search_t *search)
+{
+    gdouble n;      /* mean motion [rad/day] */
+    gdouble e;      /* eccentricity */
+    gdouble sma;    /* semi major axis [km] */
+    gdouble rmax;   /* apogee radius [km] */
+
+
+    n = twopi * sat->meanmo;
+    e = sat->tle.eo;
+    sma = 331.25 * exp (log (1440.0/sat->meanmo) * (2.0/3.0));
+    rmax = sma * (1.0 + e);
+
+    search->robs = sqrt (Sqr (qth->obs.rxy) + Sqr (qth->obs.z));
+    search->minstep = 1.0 / (sat->meanmo * PREDICT_ORBIT_STEPS);
+
+    /* angular rate at perigee plus the rotation of the earth */
+    search->rate = (n * Sqr (1.0 + e) / pow (1.0 - e*e, 1.5) + omega_ER) *
+        PREDICT_SEARCH_MARGIN;
+
+    /* largest geocentric angle at which the satellite can be visible */
+    search->horizon = acos (MIN (search->robs / rmax, 1.0)) + PREDICT_HORIZON_MARGIN;
+
+    /* velocity at perigee plus the velocity of the rotating frame at apogee */
+    search->velo = (n * sma * sqrt ((1.0 + e) / (1.0 - e)) + omega_ER * rmax) *
+        PREDICT_SEARCH_MARGIN;
+}
+
+
+/** \brief Get the next step of the AOS/LOS search.
+ *  \param sat Pointer to the satellite data, up to date for sat->jul_utc.
+ *  \param qth Pointer to the QTH data.
+ *  \param search The search parameters.
+ *  \return The time step in days.
+ *
+ * The step is the largest of three estimates:
+ *   - The time the direction to the satellite needs at least to turn by the
+ *     current elevation, given the range and the maximum velocity.
+ *   - Below the horizon, the time the sub-satellite point needs at least to
+ *     reach the largest possible visibility circle around the observer.
+ *   - PREDICT_ORBIT_STEPS steps per orbit; only passes shorter than this
+ *     can be missed.
+ */
+static gdouble
+search_step (sat_t *sat, qth_t *qth, search_t *search)
+{
+    gdouble theta, dot, psi, h;
+
+
+    /* time to turn by the elevation, the range may shrink on the way */
+    h = sat->range / search->velo * (1.0 - exp (-fabs (sat->el) * de2ra));
+
+    if (sat->el <= 0.0) {
+        /* geocentric angle between the observer and the satellite */
+        theta = ThetaG_JD (sat->jul_utc) + qth->obs.lon;
+        dot = qth->obs.rxy * cos (theta) * sat->pos.x +
+            qth->obs.rxy * sin (theta) * sat->pos.y +
+            qth->obs.z * sat->pos.z;
+        dot /= search->robs * sqrt (Sqr (sat->pos.x) + Sqr (sat->pos.y) +
+                                    Sqr (sat->pos.z));
+        psi = acos (CLAMP (dot, -1.0, 1.0));
+
+        h = MAX (h, (psi - search->horizon) / search->rate);
     }
 
-    return aostime;
+    return MAX (h, search->minstep);
 }
 
+
+/** \brief Find the next horizon crossing.
+ *  \param sat Pointer to the satellite data, up to date for t.
+ *  \param qth Pointer to the QTH data.
+ *  \param search The search parameters.
+ *  \param t The time where the search starts.
+ *  \param tmax The time where a forward search ends (0.0 = no limit).
+ *  \param dir The direction of the search, 1 forward and -1 backward.
+ *  \param above TRUE to find the crossing into the sky, FALSE to find the
+ *               crossing below the horizon (in the direction of the search).
+ *  \return The time of the crossing or 0.0 if there is none before tmax.
+ *
+ * The function steps through time with search_step() until the crossing
+ * is bracketed and then refines it with refine_crossing(). If the satellite
+ * is already on the requested side at t, the crossing of the next pass
+ * is returned.
+ *
+ * A short pass may fit between two steps. When the elevation has a maximum
+ * close to the horizon between the last steps, find_peak() checks whether
+ * the satellite rises above the horizon around the maximum.
+ */
+static gdouble
+find_crossing (sat_t *sat, qth_t *qth, search_t *search,
+               gdouble t, gdouble tmax, gint dir, gboolean above)
+{
+    gdouble  tp = 0.0;
+    gdouble  elp = 0.0;
+    gdouble  t0, el0, el, tpk;
+
+
+    for (;;) {
+        t0 = t;
+        el0 = sat->el;
+        t += dir * search_step (sat, qth, search);
+
+        if ((tmax > 0.0) && (t > tmax)) {
+            if (t0 >= tmax)
+                return 0.0;
+
+            t = tmax;
+        }
+
+        predict_calc (sat, qth, t);
+
+        if (((el0 > 0.0) != above) && ((sat->el > 0.0) == above))
+            return refine_crossing (sat, qth, t0, el0, t, sat->el);
+
+        /* maximum below the horizon between tp and t? */
+        el = sat->el;
+        if ((tp != 0.0) && (el <= 0.0) && (el0 <= 0.0) &&
+            (el0 > PREDICT_PEAK_EL) && (el0 >= elp) && (el0 >= el)) {
+
+            tpk = find_peak (sat, qth, tp, t, TRUE);
+
+            if (tpk != 0.0) {
+                if (above)
+                    return refine_crossing (sat, qth, tp, elp, tpk, sat->el);
+                else
+                    return refine_crossing (sat, qth, tpk, sat->el, t, el);
+            }
+
+            /* restore the state at t */
+            predict_calc (sat, qth, t);
+        }
+
+        tp = t0;
+        elp = el0;
+    }
+}
+
+
+/** \brief Refine a bracketed horizon crossing.
+ *  \param sat Pointer to the satellite data.
+ *  \param qth Pointer to the QTH data.
+ *  \param a One end of the bracket.
+ *  \param fa The elevation at a.
+ *  \param b The other end of the bracket.
+ *  \param fb The elevation at b.
+ *  \return The time of the crossing, within PREDICT_TIME_TOL.
+ *
+ * This is Brent's method: inverse quadratic interpolation or secant steps
+ * where they converge, bisection where they don't. A crossing is usually
+ * found in 5-8 evaluations.
+ */
+static gdouble
+refine_crossing (sat_t *sat, qth_t *qth,
+                 gdouble a, gdouble fa, gdouble b, gdouble fb)
+{
+    gdouble c, fc, d, e;
+    gdouble m, p, q, r, s;
+    guint   i;
+
+
+    c = b;
+    fc = fb;
+    d = e = b - a;
+
+    for (i = 0; i < PREDICT_MAX_ITER; i++) {
+
+        /* keep the root between b and c */
+        if ((fb > 0.0) == (fc > 0.0)) {
+            c = a;
+            fc = fa;
+            d = e = b - a;
+        }
+
+        /* b is the best estimate */
+        if (fabs (fc) < fabs (fb)) {
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+
+        m = 0.5 * (c - b);
+
+        if ((fabs (m) <= 0.5 * PREDICT_TIME_TOL) || (fb == 0.0))
+            break;
+
+        if ((fabs (e) >= 0.5 * PREDICT_TIME_TOL) && (fabs (fa) > fabs (fb))) {
+            s = fb / fa;
+
+            if (a == c) {
+                /* secant */
+                p = 2.0 * m * s;
+                q = 1.0 - s;
+            }
+            else {
+                /* inverse quadratic interpolation */
+                q = fa / fc;
+                r = fb / fc;
+                p = s * (2.0 * m * q * (q - r) - (b - a) * (r - 1.0));
+                q = (q - 1.0) * (r - 1.0) * (s - 1.0);
+            }
+
+            if (p > 0.0)
+                q = -q;
+            else
+                p = -p;
+
+            if (2.0 * p < MIN (3.0 * m * q - fabs (0.5 * PREDICT_TIME_TOL * q),
+                               fabs (e * q))) {
+                e = d;
+                d = p / q;
+            }
+            else {
+                /* interpolation failed, bisect */
+                d = m;
+                e = m;
+            }
+        }
+        else {
+            /* bounds decreasing too slowly, bisect */
+            d = m;
+            e = m;
+        }
+
+        a = b;
+        fa = fb;
+
+        if (fabs (d) > 0.5 * PREDICT_TIME_TOL)
+            b += d;
+        else
+            b += (m > 0.0) ? 0.5 * PREDICT_TIME_TOL : -0.5 * PREDICT_TIME_TOL;
+
+        predict_calc (sat, qth, b);
+        fb = sat->el;
+    }
+
+    return b;
+}
+
+
+/** \brief Find the maximum elevation between two times.
+ *  \param sat Pointer to the satellite data.
+ *  \param qth Pointer to the QTH data.
+ *  \param a One end of the interval.
+ *  \param b The other end of the interval.
+ *  \param horizon TRUE to look for a short pass below the horizon.
+ *  \return The time of the maximum, or with horizon a time where the
+ *          satellite is above the horizon or 0.0 if there is none. The
+ *          satellite data is up to date for the returned time.
+ *
+ * This is a golden section search for the maximum elevation. With horizon
+ * it stops as soon as the satellite is found above the horizon.
+ */
+static gdouble
+find_peak (sat_t *sat, qth_t *qth, gdouble a, gdouble b, gboolean horizon)
+{
+    const gdouble g = 0.5 * (sqrt (5.0) - 1.0);
+    gdouble       x1, x2, f1, f2;
+
+
+    x1 = b - g * (b - a);
+    predict_calc (sat, qth, x1);
+    f1 = sat->el;
+    if (horizon && (f1 > 0.0))
+        return x1;
+
+    x2 = a + g * (b - a);
+    predict_calc (sat, qth, x2);
+    f2 = sat->el;
+    if (horizon && (f2 > 0.0))
+        return x2;
+
+    while (fabs (b - a) > PREDICT_PEAK_TOL) {
+
+        if (f1 > f2) {
+            b = x2;
+            x2 = x1;
+            f2 = f1;
+            x1 = b - g * (b - a);
+            predict_calc (sat, qth, x1);
+            f1 = sat->el;
+            if (horizon && (f1 > 0.0))
+                return x1;
+        }
+        else {
+            a = x1;
+            x1 = x2;
+            f1 = f2;
+            x2 = a + g * (b - a);
+            predict_calc (sat, qth, x2);
+            f2 = sat->el;
+            if (horizon && (f2 > 0.0))
+                return x2;
+        }
+    }
+
+    if (horizon)
+        return 0.0;
+
+    if (f1 > f2) {
+        predict_calc (sat, qth, x1);
+        return x1;
+    }
+
+    predict_calc (sat, qth, x2);
+    return x2;
+}
+
+
 /** \brief Predict the next pass.
  *  \param sat Pointer to the satellite data.
  *  \param qth Pointer to the observer data.
@@ -407,30 +846,65 @@ get_next_passes (sat_t *sat, qth_t *qth, gdouble maxdt, guint num)
  * This function will find the first upcoming pass with AOS no earlier than
  * t = start and no later than t = (start+maxdt).
  *
- * \note For no time limit use maxdt = 0.0
+ * The passes are taken from the pass cache, which is extended with
+ * compute_pass() when the query reaches beyond the passes it holds.
  *
- * \note the data in sat will be corrupt (future) and must be refreshed
- *       by the caller, if the caller will need it later on (eg. if the caller
- *       is GtkSatList).
+ * \note For no time limit use maxdt = 0.0
+ */
+pass_t *
+get_pass   (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt)
+{
+    predict_cfg_t cfg;
+
+
+    predict_cfg_read (&cfg);
+
+    return get_pass_cfg (sat, qth, start, maxdt, &cfg);
+}
+
+
+/** \brief Predict first pass after a certain time with given settings.
  *
- * \note Prepending to a singly linked list is much faster than appending.
- *       Therefore, the elements are prepended whereafter the GSList is
- *       reversed
+ * This is get_pass() with the settings read by the caller, see
+ * predict_cfg_read(). It does not read the configuration, so it can be
+ * called from worker threads.
  */
 pass_t *
-get_pass   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt)
+get_pass_cfg (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt,
+              const predict_cfg_t *cfg)
+{
+    pass_t  *pass = NULL;
+    gdouble  from = start;
+    gdouble  dt;
+
+
+    while (!pass_cache_lookup (sat, qth, cfg, start, maxdt, &pass, &from)) {
+        /* search the rest of the time window */
+        dt = (maxdt > 0.0) ? start + maxdt - from : 0.0;
+        pass = compute_pass (sat, qth, from, dt, cfg);
+        pass_cache_store (sat, qth, cfg, from, dt, pass);
+    }
+
+    return pass;
+}
+
+
+/** \brief Predict first pass after a certain time without the cache.
+ *
+ * This is the search behind get_pass(); the parameters are the same. The
+ * satellite is copied, so the data in sat_in is not changed.
+ */
+static pass_t *
+compute_pass (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt,
+              const predict_cfg_t *cfg)
 {
     gdouble        aos = 0.0;    /* time of AOS */
-    gdouble        tca = 0.0;    /* time of TCA */
     gdouble        los = 0.0;    /* time of LOS */
     gdouble        dt = 0.0;     /* time diff */
     gdouble        step = 0.0;   /* time step */
     gdouble        t0 = start;
-    gdouble        t;            /* current time counter */
     gdouble        tres = 0.0; /* required time resolution */
-    gdouble        max_el = 0.0; /* maximum elevation */
     pass_t        *pass = NULL;
-    pass_detail_t *detail = NULL;
     gboolean       done = FALSE;
     guint          iter = 0;      /* number of iterations */
     sat_t         *sat,sat_working;
@@ -440,7 +914,7 @@ get_pass   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt)
     sat = memcpy(&sat_working,sat_in,sizeof(sat_t));
 
     /* get time resolution; sat-cfg stores it in seconds */
-    tres = sat_cfg_get_int (SAT_CFG_INT_PRED_RESOLUTION) / 86400.0;
+    tres = cfg->tres / 86400.0;
 
     /* loop until we find a pass with elevation > SAT_CFG_INT_PRED_MIN_EL
         or we run out of time
@@ -479,7 +953,7 @@ get_pass   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt)
             dt = los - aos;
 
             /* get time step, which will give us the max number of entries */
-            step = dt / sat_cfg_get_int (SAT_CFG_INT_PRED_NUM_ENTRIES);
+            step = dt / cfg->entries;
 
             /* but if this is smaller than the required resolution
                 we go with the resolution
@@ -501,88 +975,18 @@ get_pass   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt)
             pass->vis[2] = '-';
             pass->vis[3] = 0;
             pass->satname = g_strdup (sat->nickname);
-            pass->details = NULL;
 
-            /* iterate over each time step */
-            for (t = pass->aos; t <= pass->los; t += step) {
-            
-                /* calculate satellite data */
-                predict_calc (sat, qth, t);
-
-                /* in the first iter we want to store
-                    pass->aos_az
-                */
-                if (t == pass->aos) {
-                    pass->aos_az = sat->az;
-                    pass->orbit = sat->orbit;
-                }
-
-                /* append details to sat->details */
-                detail = g_new (pass_detail_t, 1);
-                detail->time = t;
-                detail->pos.x = sat->pos.x;
-                detail->pos.y = sat->pos.y;
-                detail->pos.z = sat->pos.z;
-                detail->pos.w = sat->pos.w;
-                detail->vel.x = sat->vel.x;
-                detail->vel.y = sat->vel.y;
-                detail->vel.z = sat->vel.z;
-                detail->vel.w = sat->vel.w;
-                detail->velo = sat->velo;
-                detail->az = sat->az;
-                detail->el = sat->el;
-                detail->range = sat->range;
-                detail->range_rate = sat->range_rate;
-                detail->lat = sat->ssplat;
-                detail->lon = sat->ssplon;
-                detail->alt = sat->alt;
-                detail->ma = sat->ma;
-                detail->phase = sat->phase;
-                detail->footprint = sat->footprint;
-                detail->orbit = sat->orbit;
-                detail->vis = get_sat_vis (sat, qth, t);
-
-                /* also store visibility "bit" */
-                switch (detail->vis) {
-                case SAT_VIS_VISIBLE:
-                    pass->vis[0] = 'V';
-                    break;
-                case SAT_VIS_DAYLIGHT:
-                    pass->vis[1] = 'D';
-                    break;
-                case SAT_VIS_ECLIPSED:
-                    pass->vis[2] = 'E';
-                    break;
-                default:
-                    break;
-                }
-
-                pass->details = g_slist_prepend (pass->details, detail);
-
-                /* store elevation if greater than the
-                    previously stored one
-                */
-                if (sat->el > max_el) {
-                    max_el = sat->el;
-                    tca = t;
-                    pass->maxel_az = sat->az;
-                }
-
-                /*     g_print ("TIME: %f\tAZ: %f\tEL: %f (MAX: %f)\n", */
-                /*           t, sat->az, sat->el, max_el); */
-            }
-
-            pass->details = g_slist_reverse (pass->details);
+            /* details, aos_az, max_el, tca and visibility */
+            sample_pass (sat, qth, pass, step, cfg);
+            summarize_pass (sat, qth, pass);
 
             /* calculate satellite data */
             predict_calc (sat, qth, pass->los);
-            /* store los_az, max_el and tca */
+            /* store los_az */
             pass->los_az = sat->az;
-            pass->max_el = max_el;
-            pass->tca    = tca;
 
             /* check whether this pass is good */
-            if (max_el >= sat_cfg_get_int (SAT_CFG_INT_PRED_MIN_EL)) {
+            if (pass->max_el >= cfg->min_el) {
                 done = TRUE;
             }
             else {
@@ -602,6 +1006,253 @@ get_pass   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt)
 
 
 
+/** \brief Sample the details and the sky track of a pass.
+ *  \param sat The satellite (working copy).
+ *  \param qth The observer.
+ *  \param pass The pass; aos and los must be set.
+ *  \param step The time step of the details.
+ *  \param cfg The prediction settings; cfg->maxerr is the max error of a
+ *             straight line between two track samples [mdeg], or 0 for
+ *             track samples at every step.
+ *
+ * The details, which are listed in the pass tables and exports, are
+ * sampled at every step from AOS and stored in pass->detail. The samples
+ * for drawing the sky track are stored in pass->track, both sorted by
+ * time.
+ *
+ * With maxerr > 0 the track is split into segments of PREDICT_SAMPLE_SKIP
+ * steps from AOS to LOS, and each segment is halved until the lines between
+ * the samples are within maxerr of the track, see sample_error(). Segments
+ * are never halved below step, so there are at most as many samples as
+ * with a fixed step, and usually much fewer on long or low passes. Short
+ * passes still get PREDICT_SAMPLE_MIN_SEGMENTS segments.
+ */
+static void
+sample_pass (sat_t *sat, qth_t *qth, pass_t *pass, gdouble step,
+             const predict_cfg_t *cfg)
+{
+    GArray        *samples;
+    pass_detail_t  a, b;
+    gdouble        t, dt;
+    gdouble        maxerr = cfg->maxerr / 1000.0;
+    gdouble        twilight = cfg->twilight;
+    guint          i, n;
+
+
+    samples = g_array_sized_new (FALSE, FALSE, sizeof (pass_detail_t),
+                                 (guint) ((pass->los - pass->aos) / step) + 1);
+
+    for (t = pass->aos; t <= pass->los; t += step) {
+        calc_detail (sat, qth, t, twilight, &a);
+        g_array_append_val (samples, a);
+    }
+
+    pass->num_details = samples->len;
+    pass->detail = (pass_detail_t *) g_array_free (samples, FALSE);
+
+    if (maxerr <= 0.0) {
+        pass->num_track = pass->num_details;
+        pass->track = g_memdup (pass->detail,
+                                pass->num_details * sizeof (pass_detail_t));
+    }
+    else {
+        n = (guint) ceil ((pass->los - pass->aos) / (PREDICT_SAMPLE_SKIP * step));
+        n = MAX (n, PREDICT_SAMPLE_MIN_SEGMENTS);
+        dt = (pass->los - pass->aos) / n;
+
+        /* grows only where the segments are refined */
+        samples = g_array_sized_new (FALSE, FALSE, sizeof (pass_detail_t), n + 1);
+
+        calc_detail (sat, qth, pass->aos, twilight, &a);
+        g_array_append_val (samples, a);
+
+        for (i = 1; i <= n; i++) {
+            calc_detail (sat, qth, (i == n) ? pass->los : pass->aos + i * dt,
+                         twilight, &b);
+            sample_segment (sat, qth, &a, &b, step, maxerr, twilight, samples);
+            g_array_append_val (samples, b);
+            a = b;
+        }
+
+        pass->num_track = samples->len;
+        pass->track = (pass_detail_t *) g_array_free (samples, FALSE);
+    }
+}
+
+
+/** \brief Refine a segment between two samples.
+ *
+ * The samples between a and b are appended to samples in order of time;
+ * neither a nor b is added. A segment is halved when the midpoint deviates
+ * more than maxerr from the line or when the visibility changes.
+ */
+static void
+sample_segment (sat_t *sat, qth_t *qth,
+                const pass_detail_t *a, const pass_detail_t *b,
+                gdouble step, gdouble maxerr, gdouble twilight,
+                GArray *samples)
+{
+    pass_detail_t m;
+
+
+    if (b->time - a->time < 2.0 * step)
+        return;
+
+    calc_detail (sat, qth, 0.5 * (a->time + b->time), twilight, &m);
+
+    if ((sample_error (a, &m, b) <= maxerr) &&
+        (a->vis == m.vis) && (m.vis == b->vis))
+        return;
+
+    sample_segment (sat, qth, a, &m, step, maxerr, twilight, samples);
+    g_array_append_val (samples, m);
+    sample_segment (sat, qth, &m, b, step, maxerr, twilight, samples);
+}
+
+
+/** \brief Error of the line between two samples at a midpoint [deg].
+ *
+ * The largest deviation of m from the straight line between a and b, both
+ * in azimuth and elevation against time, as drawn in the az/el plot, and
+ * on the polar view, where a point is drawn at radius 90 - el.
+ */
+static gdouble
+sample_error (const pass_detail_t *a, const pass_detail_t *m,
+              const pass_detail_t *b)
+{
+    gdouble f, daz, err;
+    gdouble xa, ya, xm, ym, xb, yb;
+
+
+    f = (m->time - a->time) / (b->time - a->time);
+
+    err = fabs (m->el - (a->el + f * (b->el - a->el)));
+
+    /* azimuth difference across north */
+    daz = fmod (b->az - a->az + 540.0, 360.0) - 180.0;
+    err = MAX (err, fabs (fmod (m->az - a->az - f * daz + 540.0, 360.0) - 180.0));
+
+    xa = (90.0 - a->el) * sin (a->az * de2ra);
+    ya = (90.0 - a->el) * cos (a->az * de2ra);
+    xm = (90.0 - m->el) * sin (m->az * de2ra);
+    ym = (90.0 - m->el) * cos (m->az * de2ra);
+    xb = (90.0 - b->el) * sin (b->az * de2ra);
+    yb = (90.0 - b->el) * cos (b->az * de2ra);
+
+    return MAX (err, hypot (xm - (xa + f * (xb - xa)), ym - (ya + f * (yb - ya))));
+}
+
+
+/** \brief Calculate a pass detail entry at a given time.
+ *
+ * twilight is the sun elevation threshold for visibility [deg].
+ */
+static void
+calc_detail (sat_t *sat, qth_t *qth, gdouble t, gdouble twilight,
+             pass_detail_t *detail)
+{
+    /* calculate satellite data */
+    predict_calc (sat, qth, t);
+
+    detail->time = t;
+    detail->pos.x = sat->pos.x;
+    detail->pos.y = sat->pos.y;
+    detail->pos.z = sat->pos.z;
+    detail->pos.w = sat->pos.w;
+    detail->vel.x = sat->vel.x;
+    detail->vel.y = sat->vel.y;
+    detail->vel.z = sat->vel.z;
+    detail->vel.w = sat->vel.w;
+    detail->velo = sat->velo;
+    detail->az = sat->az;
+    detail->el = sat->el;
+    detail->range = sat->range;
+    detail->range_rate = sat->range_rate;
+    detail->lat = sat->ssplat;
+    detail->lon = sat->ssplon;
+    detail->alt = sat->alt;
+    detail->ma = sat->ma;
+    detail->phase = sat->phase;
+    detail->footprint = sat->footprint;
+    detail->orbit = sat->orbit;
+    detail->vis = get_sat_vis_thld (sat, qth, t, twilight);
+}
+
+
+/** \brief Fill in the pass summary from the details.
+ *  \param sat The satellite (working copy).
+ *  \param qth The observer.
+ *  \param pass The pass with its details.
+ *
+ * Sets aos_az and orbit from the first detail, which is at AOS, and the
+ * visibility string from all details. The maximum elevation is searched
+ * with find_peak() between the neighbours of the highest detail, so tca,
+ * max_el and maxel_az do not depend on the time step.
+ */
+static void
+summarize_pass (sat_t *sat, qth_t *qth, pass_t *pass)
+{
+    pass_detail_t *detail;
+    guint          i, imax = 0;
+    gdouble        a, b;
+
+
+    pass->max_el = 0.0;
+    pass->tca = pass->aos;
+
+    if (pass->num_details == 0)
+        return;
+
+    pass->aos_az = pass->detail[0].az;
+    pass->orbit = pass->detail[0].orbit;
+
+    for (i = 0; i < pass->num_details; i++) {
+        detail = &pass->detail[i];
+
+        /* also store visibility "bit" */
+        switch (detail->vis) {
+        case SAT_VIS_VISIBLE:
+            pass->vis[0] = 'V';
+            break;
+        case SAT_VIS_DAYLIGHT:
+            pass->vis[1] = 'D';
+            break;
+        case SAT_VIS_ECLIPSED:
+            pass->vis[2] = 'E';
+            break;
+        default:
+            break;
+        }
+
+        /* store elevation if greater than the
+            previously stored one
+        */
+        if (detail->el > pass->max_el) {
+            pass->max_el = detail->el;
+            pass->tca = detail->time;
+            pass->maxel_az = detail->az;
+            imax = i;
+        }
+    }
+
+    /* refine the maximum between the neighbouring details */
+    a = (imax > 0) ? pass->detail[imax-1].time : pass->aos;
+    b = (imax + 1 < pass->num_details) ? pass->detail[imax+1].time : pass->los;
+
+    if (b > a) {
+        pass->tca = find_peak (sat, qth, a, b, FALSE);
+
+        if (sat->el > pass->max_el) {
+            pass->max_el = sat->el;
+            pass->maxel_az = sat->az;
+        }
+        else {
+            pass->tca = pass->detail[imax].time;
+        }
+    }
+}
+
+
 /** \brief Predict passes after a certain time.
  *
  *
@@ -623,6 +1274,25 @@ get_pass   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt)
  */
 GSList *
 get_passes (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, guint num)
+{
+    predict_cfg_t cfg;
+
+
+    predict_cfg_read (&cfg);
+
+    return get_passes_cfg (sat, qth, start, maxdt, num, &cfg);
+}
+
+
+/** \brief Predict passes after a certain time with given settings.
+ *
+ * This is get_passes() with the settings read by the caller, see
+ * predict_cfg_read(). It does not read the configuration, so it can be
+ * called from worker threads.
+ */
+GSList *
+get_passes_cfg (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt,
+                guint num, const predict_cfg_t *cfg)
 {
     GSList *passes = NULL;
     pass_t *pass = NULL;
@@ -637,7 +1307,7 @@ get_passes (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, guint num)
     t = start;
 
     for (i = 0; i < num; i++) {
-        pass = get_pass (sat, qth, t, maxdt);
+        pass = get_pass_cfg (sat, qth, t, maxdt, cfg);
 
         if (pass != NULL) {
             passes = g_slist_prepend (passes, pass);
@@ -677,24 +1347,12 @@ copy_pass         (pass_t *pass)
     new = g_try_new (pass_t, 1);
 
     if (new != NULL) {
-        new->aos = pass->aos;
-        new->los = pass->los;
-        new->tca = pass->tca;
-        new->max_el = pass->max_el;
-        new->aos_az = pass->aos_az;
-        new->los_az = pass->los_az;
-        new->orbit = pass->orbit;
-        new->maxel_az = pass->maxel_az;
-        new->vis[0] = pass->vis[0];
-        new->vis[1] = pass->vis[1];
-        new->vis[2] = pass->vis[2];
-        new->vis[3] = pass->vis[3];
-        new->details = copy_pass_details (pass->details);
-        
-        if (pass->satname != NULL)
-            new->satname = g_strdup (pass->satname);
-        else
-            new->satname = NULL;
+        *new = *pass;
+        new->detail = g_memdup (pass->detail,
+                                pass->num_details * sizeof (pass_detail_t));
+        new->track = g_memdup (pass->track,
+                               pass->num_track * sizeof (pass_detail_t));
+        new->satname = g_strdup (pass->satname);
     }
 
     return new;
@@ -705,13 +1363,11 @@ GSList *
 copy_pass_details (GSList *details)
 {
     GSList *new = NULL;
-    guint   i,n;
+    GSList *node;
 
 
-    n = g_slist_length (details);
-    for (i = 0; i < n; i++) {
-        new = g_slist_prepend (new, 
-                        copy_pass_detail (PASS_DETAIL (g_slist_nth_data (details, i))));
+    for (node = details; node != NULL; node = node->next) {
+        new = g_slist_prepend (new, copy_pass_detail (PASS_DETAIL (node->data)));
     }
 
     new = g_slist_reverse (new);
@@ -761,7 +1417,8 @@ void
 free_pass   (pass_t *pass)
 {
      if (pass!=NULL){
-     free_pass_details (pass->details);
+     g_free (pass->detail);
+     g_free (pass->track);
      
      if (pass->satname != NULL) {
           g_free (pass->satname);
@@ -859,35 +1516,30 @@ free_pass_details (GSList *details)
  * \note the data in sat will be corrupt (future) and must be refreshed
  *       by the caller, if the caller will need it later on (eg. if the caller
  *       is GtkSatList).
- *
- * \note Prepending to a singly linked list is much faster than appending.
- *       Therefore, the elements are prepended whereafter the GSList is
- *       reversed
  */
 pass_t *
 get_pass_no_min_el (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt)
 {
     gdouble        aos = 0.0;    /* time of AOS */
-    gdouble        tca = 0.0;    /* time of TCA */
     gdouble        los = 0.0;    /* time of LOS */
     gdouble        dt = 0.0;     /* time diff */
     gdouble        step = 0.0;   /* time step */
     gdouble        t0 = start;
-    gdouble        t;            /* current time counter */
     gdouble        tres = 0.0; /* required time resolution */
-    gdouble        max_el = 0.0; /* maximum elevation */
     pass_t        *pass = NULL;
-    pass_detail_t *detail = NULL;
     gboolean       done = FALSE;
     sat_t         *sat,sat_working;
+    predict_cfg_t  cfg;
 
     /* FIXME: watchdog */
 
     /*copy sat_in to a working structure*/
     sat = memcpy(&sat_working,sat_in,sizeof(sat_t));
 
+    predict_cfg_read (&cfg);
+
     /* get time resolution; sat-cfg stores it in seconds */
-    tres = sat_cfg_get_int (SAT_CFG_INT_PRED_RESOLUTION) / 86400.0;
+    tres = cfg.tres / 86400.0;
 
 
     aos = find_aos (sat, qth, t0, maxdt);
@@ -909,7 +1561,7 @@ get_pass_no_min_el (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt)
         dt = los - aos;
 
         /* get time step, which will give us the max number of entries */
-        step = dt / sat_cfg_get_int (SAT_CFG_INT_PRED_NUM_ENTRIES);
+        step = dt / cfg.entries;
 
         /* but if this is smaller than the required resolution
             we go with the resolution
@@ -931,85 +1583,15 @@ get_pass_no_min_el (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt)
         pass->vis[2] = '-';
         pass->vis[3] = 0;
         pass->satname = g_strdup (sat->nickname);
-        pass->details = NULL;
-
-        /* iterate over each time step */
-        for (t = pass->aos; t <= pass->los; t += step) {
-            
-            /* calculate satellite data */
-            predict_calc (sat, qth, t);
-
-            /* in the first iter we want to store
-                pass->aos_az
-            */
-            if (t == pass->aos) {
-                pass->aos_az = sat->az;
-                pass->orbit = sat->orbit;
-            }
-
-            /* append details to sat->details */
-            detail = g_new (pass_detail_t, 1);
-            detail->time = t;
-            detail->pos.x = sat->pos.x;
-            detail->pos.y = sat->pos.y;
-            detail->pos.z = sat->pos.z;
-            detail->pos.w = sat->pos.w;
-            detail->vel.x = sat->vel.x;
-            detail->vel.y = sat->vel.y;
-            detail->vel.z = sat->vel.z;
-            detail->vel.w = sat->vel.w;
-            detail->velo = sat->velo;
-            detail->az = sat->az;
-            detail->el = sat->el;
-            detail->range = sat->range;
-            detail->range_rate = sat->range_rate;
-            detail->lat = sat->ssplat;
-            detail->lon = sat->ssplon;
-            detail->alt = sat->alt;
-            detail->ma = sat->ma;
-            detail->phase = sat->phase;
-            detail->footprint = sat->footprint;
-            detail->orbit = sat->orbit;
-            detail->vis = get_sat_vis (sat, qth, t);
-
-            /* also store visibility "bit" */
-            switch (detail->vis) {
-            case SAT_VIS_VISIBLE:
-                pass->vis[0] = 'V';
-                break;
-            case SAT_VIS_DAYLIGHT:
-                pass->vis[1] = 'D';
-                break;
-            case SAT_VIS_ECLIPSED:
-                pass->vis[2] = 'E';
-                break;
-            default:
-                break;
-            }
-            
-            pass->details = g_slist_prepend (pass->details, detail);
-
-            /* store elevation if greater than the
-                previously stored one
-            */
-            if (sat->el > max_el) {
-                max_el = sat->el;
-                tca = t;
-                pass->maxel_az = sat->az;
-            }
-
-            /*     g_print ("TIME: %f\tAZ: %f\tEL: %f (MAX: %f)\n", */
-            /*           t, sat->az, sat->el, max_el); */
-        }
 
-        pass->details = g_slist_reverse (pass->details);
+        /* details, aos_az, max_el, tca and visibility */
+        sample_pass (sat, qth, pass, step, &cfg);
+        summarize_pass (sat, qth, pass);
 
         /* calculate satellite data */
         predict_calc (sat, qth, pass->los);
-        /* store los_az, max_el and tca */
+        /* store los_az */
         pass->los_az = sat->az;
-        pass->max_el = max_el;
-        pass->tca    = tca;
 
     }
 
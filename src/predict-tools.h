@@ -36,22 +36,6 @@
 
 
 
-/** \brief Brief satellite pass info. */
-typedef struct {
-    gchar      *satname;  /*!< satellite name */
-    gdouble     aos;      /*!< AOS time in "jul_utc" */
-    gdouble     tca;      /*!< TCA time in "jul_utc" */
-    gdouble     los;      /*!< LOS time in "jul_utc" */
-    gdouble     max_el;   /*!< Maximum elevation during pass */
-    gdouble     aos_az;   /*!< Azimuth at AOS */
-    gdouble     los_az;   /*!< Azimuth at LOS */
-    guint       orbit;    /*!< Orbit number */
-    gdouble     maxel_az; /*!< Azimuth at maximum elevation */
-    gchar       vis[4];   /*!< Visibility string, e.g. VSE, -S-, V-- */
-    GSList     *details;  /*!< List of pass_detail_t entries */
-} pass_t;
-
-
 /** \brief Pass detail entry.
  *
  * In order to ensure maximum flexibility at a minimal effort, only the
@@ -80,13 +64,51 @@ typedef struct {
 } pass_detail_t;
 
 
+/** \brief Brief satellite pass info. */
+typedef struct {
+    gchar      *satname;  /*!< satellite name */
+    gdouble     aos;      /*!< AOS time in "jul_utc" */
+    gdouble     tca;      /*!< TCA time in "jul_utc" */
+    gdouble     los;      /*!< LOS time in "jul_utc" */
+    gdouble     max_el;   /*!< Maximum elevation during pass */
+    gdouble     aos_az;   /*!< Azimuth at AOS */
+    gdouble     los_az;   /*!< Azimuth at LOS */
+    guint       orbit;    /*!< Orbit number */
+    gdouble     maxel_az; /*!< Azimuth at maximum elevation */
+    gchar       vis[4];   /*!< Visibility string, e.g. VSE, -S-, V-- */
+    pass_detail_t *detail;      /*!< Array of details sorted by time */
+    guint       num_details;    /*!< Number of entries in detail */
+    pass_detail_t *track;       /*!< Sky track samples sorted by time */
+    guint       num_track;      /*!< Number of entries in track */
+} pass_t;
+
+
+/** \brief Prediction settings.
+ *
+ * The configuration is not thread safe, so the pass prediction reads the
+ * settings once with predict_cfg_read() in the main thread and passes them
+ * on; this also lets worker threads predict passes.
+ */
+typedef struct {
+    gint  min_el;     /*!< SAT_CFG_INT_PRED_MIN_EL [deg] */
+    gint  tres;       /*!< SAT_CFG_INT_PRED_RESOLUTION [sec] */
+    gint  entries;    /*!< SAT_CFG_INT_PRED_NUM_ENTRIES */
+    gint  maxerr;     /*!< SAT_CFG_INT_PRED_MAX_ERROR [mdeg] */
+    gint  twilight;   /*!< SAT_CFG_INT_PRED_TWILIGHT_THLD [deg] */
+} predict_cfg_t;
+
+
 /* type casting macros */
 #define PASS(x) ((pass_t *) x)
 #define PASS_DETAIL(x) ((pass_detail_t *) x)
 
 
 /* SGP4/SDP4 driver */
-void predict_calc (sat_t *sat, qth_t *qth, gdouble t);
+void predict_calc       (sat_t *sat, qth_t *qth, gdouble t);
+void predict_calc_batch (sat_t **sats, guint n, qth_t *qth, gdouble t);
+void predict_calc_eci   (sat_t *sat, gdouble t);
+void predict_calc_state (sat_t *sat, qth_t *qth, gdouble t);
+void predict_cfg_read   (predict_cfg_t *cfg);
 
 /* AOS/LOS time calculators */
 gdouble find_aos           (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt);
@@ -100,6 +122,10 @@ GSList *get_next_passes    (sat_t *sat, qth_t *qth, gdouble maxdt, guint num);
 /* future events */
 pass_t *get_pass           (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt);
 GSList *get_passes         (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, guint num);
+pass_t *get_pass_cfg       (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt,
+                            const predict_cfg_t *cfg);
+GSList *get_passes_cfg     (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt,
+                            guint num, const predict_cfg_t *cfg);
 pass_t *get_current_pass   (sat_t *sat, qth_t *qth, gdouble start);
 pass_t *get_pass_no_min_el (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt);
 
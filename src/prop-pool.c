@@ -0,0 +1,255 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2010  Alexandru Csete, OZ9AEC.
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \brief Worker pool for propagating satellites in parallel.
+ *
+ * The pool is used by the modules to spread the propagation of their
+ * satellites over the available cores. The workers sleep on a condition
+ * between the runs, so an idle pool costs nothing; the items are handed
+ * out in chunks through an atomic counter, so a run takes the lock only
+ * when it starts and when a worker finishes.
+ */
+#include <glib.h>
+#include <glib/gi18n.h>
+#ifdef HAVE_CONFIG_H
+#  include <build-config.h>
+#endif
+#ifdef G_OS_WIN32
+#  include <windows.h>
+#else
+#  include <unistd.h>
+#endif
+#include "sat-log.h"
+#include "prop-pool.h"
+
+
+/** \brief Upper limit for the number of worker threads. */
+#define PROP_POOL_MAX_THREADS 64
+
+
+static gpointer worker  (gpointer data);
+static void     process (prop_pool_t *pool);
+
+
+/** \brief Create a new worker pool.
+ *  \param nthreads The number of worker threads.
+ *  \return A new prop_pool_t. Free it with prop_pool_free().
+ *
+ * A pool with no threads processes the items in the calling thread.
+ */
+prop_pool_t *
+prop_pool_new (guint nthreads)
+{
+    prop_pool_t *pool;
+    GError      *err = NULL;
+    guint        i;
+
+
+    pool = g_new0 (prop_pool_t, 1);
+
+    pool->lock = g_mutex_new ();
+    pool->start = g_cond_new ();
+    pool->done = g_cond_new ();
+    pool->threads = g_new0 (GThread *, nthreads);
+
+    for (i = 0; i < nthreads; i++) {
+        pool->threads[i] = g_thread_create (worker, pool, TRUE, &err);
+
+        if (pool->threads[i] == NULL) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Could not create worker thread (%s)"),
+                         __FUNCTION__, err->message);
+            g_clear_error (&err);
+            break;
+        }
+    }
+
+    pool->nthreads = i;
+
+    sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                 _("%s: Created pool with %d worker threads"),
+                 __FUNCTION__, pool->nthreads);
+
+    return pool;
+}
+
+
+/** \brief Stop the workers and free the pool.
+ *
+ * Must not be called while a run is in progress.
+ */
+void
+prop_pool_free (prop_pool_t *pool)
+{
+    guint i;
+
+
+    if (pool == NULL)
+        return;
+
+    g_mutex_lock (pool->lock);
+    pool->quit = TRUE;
+    g_cond_broadcast (pool->start);
+    g_mutex_unlock (pool->lock);
+
+    for (i = 0; i < pool->nthreads; i++)
+        g_thread_join (pool->threads[i]);
+
+    g_free (pool->threads);
+    g_cond_free (pool->start);
+    g_cond_free (pool->done);
+    g_mutex_free (pool->lock);
+    g_free (pool);
+}
+
+
+/** \brief Process all items of an array.
+ *  \param pool The worker pool.
+ *  \param items The items to process.
+ *  \param func The function to call for each chunk.
+ *  \param data User data passed to func.
+ *
+ * The function returns when func has been called for every item. Arrays
+ * that fit into a single chunk are processed in the calling thread, since
+ * waking up the workers would cost more than it saves.
+ */
+void
+prop_pool_run (prop_pool_t *pool, GPtrArray *items,
+               prop_pool_func_t func, gpointer data)
+{
+    if (items->len == 0)
+        return;
+
+    if ((pool->nthreads == 0) || (items->len <= PROP_POOL_CHUNK)) {
+        func (0, items->len, items->pdata, data);
+
+        return;
+    }
+
+    g_mutex_lock (pool->lock);
+
+    pool->items = items;
+    pool->func = func;
+    pool->data = data;
+    pool->next = 0;
+    pool->active = pool->nthreads;
+    pool->run++;
+    g_cond_broadcast (pool->start);
+
+    /* barrier: wait for all workers to finish */
+    while (pool->active > 0)
+        g_cond_wait (pool->done, pool->lock);
+
+    pool->items = NULL;
+
+    g_mutex_unlock (pool->lock);
+}
+
+
+/** \brief Get the number of worker threads for a setting.
+ *  \param setting The configured number of threads; 0 or less means one
+ *                 thread per processor.
+ *  \return The number of worker threads.
+ */
+guint
+prop_pool_num_threads (gint setting)
+{
+    gint num = setting;
+
+#ifdef G_OS_WIN32
+    SYSTEM_INFO info;
+#endif
+
+
+    if (num <= 0) {
+#ifdef G_OS_WIN32
+        GetSystemInfo (&info);
+        num = info.dwNumberOfProcessors;
+#elif defined (_SC_NPROCESSORS_ONLN)
+        num = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+    }
+
+    return CLAMP (num, 1, PROP_POOL_MAX_THREADS);
+}
+
+
+/** \brief Worker thread.
+ *
+ * Each worker takes part in every run exactly once, so that the caller
+ * can count the finished workers.
+ */
+static gpointer
+worker (gpointer data)
+{
+    prop_pool_t *pool = (prop_pool_t *) data;
+    guint        run = 0;
+
+
+    g_mutex_lock (pool->lock);
+
+    for (;;) {
+        while (!pool->quit && (pool->run == run))
+            g_cond_wait (pool->start, pool->lock);
+
+        if (pool->quit)
+            break;
+
+        run = pool->run;
+        g_mutex_unlock (pool->lock);
+
+        process (pool);
+
+        g_mutex_lock (pool->lock);
+        pool->active--;
+        if (pool->active == 0)
+            g_cond_signal (pool->done);
+    }
+
+    g_mutex_unlock (pool->lock);
+
+    return NULL;
+}
+
+
+/** \brief Process chunks of the current run until none are left. */
+static void
+process (prop_pool_t *pool)
+{
+    gint  first;
+    guint n;
+
+
+    for (;;) {
+        first = g_atomic_int_exchange_and_add (&pool->next, PROP_POOL_CHUNK);
+
+        if (first >= (gint) pool->items->len)
+            break;
+
+        n = MIN (PROP_POOL_CHUNK, pool->items->len - first);
+
+        pool->func (first, n, pool->items->pdata + first, pool->data);
+    }
+}
@@ -0,0 +1,80 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2010  Alexandru Csete, OZ9AEC.
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+#ifndef PROP_POOL_H
+#define PROP_POOL_H 1
+
+#include <glib.h>
+
+
+/** \brief Number of items a worker takes from the array at a time. */
+#define PROP_POOL_CHUNK 16
+
+
+/** \brief Function processing a chunk of the array.
+ *  \param first The index of the first item of the chunk in the array.
+ *  \param n The number of items in the chunk.
+ *  \param items The items of the chunk.
+ *  \param data User data passed to prop_pool_run().
+ *
+ * The function is called concurrently for different chunks and must only
+ * modify the items of its chunk and data belonging to their indices.
+ */
+typedef void (*prop_pool_func_t) (guint first, guint n, gpointer *items,
+                                  gpointer data);
+
+
+/** \brief Worker pool processing the items of an array in parallel.
+ *
+ * prop_pool_run() wakes up the workers, which take chunks of
+ * PROP_POOL_CHUNK items from the array until all items are processed, and
+ * waits until the last worker has finished. This is the barrier after
+ * which the caller may read the results.
+ */
+typedef struct {
+    guint         nthreads;  /*!< Number of worker threads. */
+    GThread     **threads;   /*!< The worker threads. */
+
+    GMutex       *lock;      /*!< Protects the fields below. */
+    GCond        *start;     /*!< Signals a new run or exit to the workers. */
+    GCond        *done;      /*!< Signals the end of a run to the caller. */
+    guint         run;       /*!< Number of the current run. */
+    guint         active;    /*!< Number of workers busy with the run. */
+    gboolean      quit;      /*!< Tells the workers to exit. */
+
+    GPtrArray    *items;     /*!< The items of the current run. */
+    prop_pool_func_t func;   /*!< The function of the current run. */
+    gpointer      data;      /*!< User data of the current run. */
+    volatile gint next;      /*!< Index of the next unprocessed chunk. */
+} prop_pool_t;
+
+
+prop_pool_t *prop_pool_new         (guint nthreads);
+void         prop_pool_free        (prop_pool_t *pool);
+void         prop_pool_run         (prop_pool_t *pool, GPtrArray *items,
+                                    prop_pool_func_t func, gpointer data);
+guint        prop_pool_num_threads (gint setting);
+
+#endif
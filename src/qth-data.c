@@ -202,6 +202,8 @@ qth_data_read (const gchar *filename, qth_t *qth)
     else {
     }
 
+    qth_data_update_obs (qth);
+
     /* Now, send debug message and return */
     sat_log_log (SAT_LOG_LEVEL_MSG,
                  _("%s: QTH data: %s, %.4f, %.4f, %d"),
@@ -399,3 +401,25 @@ qth_data_free (qth_t *qth)
     g_free (qth);
 }
 
+
+/** \brief Update the observer of a QTH.
+ *  \param qth Pointer to the qth_t data structure.
+ *
+ * This function must be called whenever the latitude, longitude or altitude
+ * of the QTH has been changed. It precomputes the observer terms used by
+ * the SGP4/SDP4 driver so that they are not recomputed for each satellite
+ * and time step.
+ */
+void
+qth_data_update_obs (qth_t *qth)
+{
+    geodetic_t geodetic;
+
+
+    geodetic.lat = qth->lat * de2ra;
+    geodetic.lon = qth->lon * de2ra;
+    geodetic.alt = qth->alt / 1000.0;
+    geodetic.theta = 0;
+
+    Init_Observer (&geodetic, &qth->obs);
+}
@@ -45,12 +45,15 @@ typedef struct {
      gchar    *wx;     /*!< Weather station code (4 chars). */
 
      GKeyFile *data;   /*!< Raw data from cfg file. */
+
+     observer_t obs;   /*!< Observer for SGP4/SDP4, see qth_data_update_obs(). */
 } qth_t;
 
 
 gint qth_data_read (const gchar *filename, qth_t *qth);
 gint qth_data_save (const gchar *filename, qth_t *qth);
 void qth_data_free (qth_t *qth);
+void qth_data_update_obs (qth_t *qth);
 
 
 #endif
@@ -524,6 +524,7 @@ static gboolean
     qth->lat = qthlat;
     qth->lon = qthlon;
     qth->alt = qthalt;
+    qth_data_update_obs (qth);
 
     /* store values */
     confdir = get_user_conf_dir ();
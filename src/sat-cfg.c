@@ -43,6 +43,7 @@
 #include "gtk-polar-view.h"
 #include "gtk-single-sat.h"
 #include "sat-pass-dialogs.h"
+#include "osc-sender.h"
 #include "compat.h"
 #include "sat-cfg.h"
 
@@ -136,7 +137,10 @@ sat_cfg_bool_t sat_cfg_bool[SAT_CFG_BOOL_NUM] = {
     { "TLE",     "ADD_NEW_SATS",       TRUE},
     { "LOG",     "KEEP_LOG_FILES",     FALSE},
     { "PREDICT", "USE_REAL_T0",        FALSE},
-    { "GLOBAL",  "SEND_OSC",	       TRUE}
+    { "GLOBAL",  "SEND_OSC",	       TRUE},
+    { "GLOBAL",  "OSC_BUNDLE",         FALSE},
+    { "GLOBAL",  "OSC_DOUBLE",         FALSE},
+    { "GLOBAL",  "OSC_BLOB",           FALSE}
 };
 
 
@@ -206,7 +210,16 @@ sat_cfg_int_t sat_cfg_int[SAT_CFG_INT_NUM] = {
     { "TLE",     "AUTO_UPDATE_ACTION", 1},
     { "TLE",     "LAST_UPDATE", 0},
     { "LOG",     "CLEAN_AGE", 0},  /* 0 = Never clean */
-    { "LOG",     "LEVEL", 4}
+    { "LOG",     "LEVEL", 4},
+    { "GLOBAL",  "OSC_QUEUE_POLICY", 0},
+    { "GLOBAL",  "OSC_FIELDS", OSC_FIELDS_DEFAULT},
+    { "GLOBAL",  "OSC_DB_ANGLE", 0},
+    { "GLOBAL",  "OSC_DB_ALT", 0},
+    { "GLOBAL",  "OSC_DB_RATE", 0},
+    { "GLOBAL",  "OSC_HEARTBEAT", 1000},
+    { "MODULES", "PROP_THREADS", 0},
+    { "PREDICT", "MAX_TRACK_ERROR", 100},
+    { "PREDICT", "EPHEM_STEP", 60}
 };
 
 
@@ -231,7 +244,9 @@ sat_cfg_str_t sat_cfg_str[SAT_CFG_STR_NUM] = {
     { "TLE",     "PROXY", NULL},
     { "TLE",     "FILE_DIR", NULL},
     { "TLE",     "EXTENSION", "*.*"},
-    { "PREDICT", "SAVE_DIR", NULL}
+    { "PREDICT", "SAVE_DIR", NULL},
+    { "GLOBAL",  "OSC_SINKS", "localhost:7770"},
+    { "GLOBAL",  "OSC_SERVER_PORT", ""}
 };
 
 
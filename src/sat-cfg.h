@@ -58,6 +58,9 @@ typedef enum {
     SAT_CFG_BOOL_KEEP_LOG_FILES,      /*!< Whether to keep old log files */
     SAT_CFG_BOOL_PRED_USE_REAL_T0,    /*!< Whether to use current time as T0 fro predictions */
     SAT_CFG_BOOL_SEND_OSC,	      /*!< Send OSC messages or not */
+    SAT_CFG_BOOL_OSC_BUNDLE,          /*!< Send OSC messages in one bundle per cycle */
+    SAT_CFG_BOOL_OSC_DOUBLE,          /*!< Send OSC fields in double precision */
+    SAT_CFG_BOOL_OSC_BLOB,            /*!< Pack OSC satellite data into blobs */
     SAT_CFG_BOOL_NUM                  /*!< Number of boolean parameters */
 } sat_cfg_bool_e;
 
@@ -129,6 +132,15 @@ typedef enum {
     SAT_CFG_INT_TLE_LAST_UPDATE,      /*!< Date and time of last update, Unix seconds. */
     SAT_CFG_INT_LOG_CLEAN_AGE,        /*!< Age of log file to delete (seconds) */
     SAT_CFG_INT_LOG_LEVEL,            /*!< Logging level */
+    SAT_CFG_INT_OSC_QUEUE_POLICY,     /*!< OSC queue policy, see osc_queue_policy_t */
+    SAT_CFG_INT_OSC_FIELDS,           /*!< OSC fields, see osc_flag_t */
+    SAT_CFG_INT_OSC_DB_ANGLE,         /*!< OSC az/el deadband [mdeg] */
+    SAT_CFG_INT_OSC_DB_ALT,           /*!< OSC altitude deadband [m] */
+    SAT_CFG_INT_OSC_DB_RATE,          /*!< OSC range rate deadband [m/s] */
+    SAT_CFG_INT_OSC_HEARTBEAT,        /*!< Max OSC silence per satellite [msec] */
+    SAT_CFG_INT_MODULE_THREADS,       /*!< Propagation threads per module (0 = one per CPU) */
+    SAT_CFG_INT_PRED_MAX_ERROR,       /*!< Max track error of pass details [mdeg] (0 = fixed step) */
+    SAT_CFG_INT_EPHEM_STEP,           /*!< Ephemeris cache node spacing [sec] (0 = no cache) */
     SAT_CFG_INT_NUM                   /*!< Number of integer parameters. */
 } sat_cfg_int_e;
 
@@ -149,6 +161,8 @@ typedef enum {
     SAT_CFG_STR_TLE_FILE_DIR,   /*!< Local directory from which tle were last updated. */
     SAT_CFG_STR_TLE_FILE_EXT,   /*!< File extensions. */
     SAT_CFG_STR_PRED_SAVE_DIR,  /*!< Last used save directory for pass predictions */
+    SAT_CFG_STR_OSC_SINKS,      /*!< ; separated list of OSC destinations. */
+    SAT_CFG_STR_OSC_SERVER_PORT,/*!< Port of the OSC control server (empty: off). */
     SAT_CFG_STR_NUM             /*!< Number of string parameters */
 } sat_cfg_str_e;
 
@@ -0,0 +1,1122 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2010  Alexandru Csete, OZ9AEC.
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \brief Satellite catalogue database.
+ *
+ * Each satellite has its own .sat key file in the satdata directory.
+ * Reading thousands of them takes several seconds, so their contents are
+ * also kept in a single binary file, USER_CONF_DIR/satdata.db, which is
+ * memory mapped and read without any parsing.
+ *
+ * The file consists of a header, the records sorted by catalogue number,
+ * an index of the records sorted by nickname, the groups read from the .cat
+ * files sorted by their names, the catalogue numbers of the group members
+ * and a table of the strings the rest refers to by offset. Each record
+ * holds the tle_t parsed from the two lines, so a satellite can be
+ * initialised straight from it, and listed without even that.
+ *
+ * The file is a cache of the .sat and .cat files, which remain the exchange
+ * format. It is imported again from them when it is missing, when it was
+ * written by another version or ABI, and when the modification time of the
+ * satdata directory differs from the one recorded in the header, i.e. when
+ * files have been added or removed. The header also records the newest
+ * modification time of the .sat and .cat files, so that files edited or
+ * replaced in place are picked up: the functions listing the catalogue
+ * check all files, the ones reading a single satellite check its .sat file.
+ * The TLE update writes the changed .sat files with sat_db_export_sat() and
+ * then the catalogue in one go.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#include <sys/stat.h>
+#ifdef HAVE_CONFIG_H
+#  include <build-config.h>
+#endif
+#include "sgpsdp/sgp4sdp4.h"
+#include "sat-log.h"
+#include "compat.h"
+#include "sat-db.h"
+
+
+#define SAT_DB_MAGIC    "GPSATDB"
+#define SAT_DB_VERSION  3
+#define SAT_DB_FILE     "satdata.db"
+
+
+/** \brief Header of the catalogue file. */
+typedef struct {
+    gchar    magic[8];   /*!< SAT_DB_MAGIC */
+    guint32  version;    /*!< SAT_DB_VERSION */
+    guint32  recsize;    /*!< sizeof (sat_db_rec_t) */
+    guint32  count;      /*!< Number of records. */
+    guint32  names;      /*!< Offset of the name index. */
+    guint32  strings;    /*!< Offset of the string table. */
+    guint32  size;       /*!< Size of the file. */
+    guint32  groups;     /*!< Offset of the groups. */
+    guint32  ngroups;    /*!< Number of groups. */
+    guint32  members;    /*!< Offset of the group members. */
+    guint32  nmembers;   /*!< Number of group members. */
+    gint64   dirtime;    /*!< Modification time of the satdata directory. */
+    gint64   filetime;   /*!< Newest modification time of the .sat and .cat files. */
+} sat_db_header_t;
+
+
+/** \brief A satellite record; strings are offsets into the string table. */
+typedef struct {
+    tle_t    tle;
+    guint32  name;
+    guint32  nickname;
+    guint32  website;    /*!< 0 if there is no website. */
+    guint32  line1;
+    guint32  line2;
+} sat_db_rec_t;
+
+
+/** \brief A group; its members are members[first] to members[first+count-1]. */
+typedef struct {
+    guint32  file;       /*!< Name of the .cat file. */
+    guint32  name;       /*!< Name of the group. */
+    guint32  first;      /*!< Index of the first member. */
+    guint32  count;      /*!< Number of members. */
+} sat_db_group_t;
+
+
+/** \brief A group read from a .cat file. */
+typedef struct {
+    gchar   *file;
+    gchar   *name;
+    GArray  *members;    /*!< Catalogue numbers (gint32) */
+} cat_file_t;
+
+
+static gboolean load_db      (gboolean scan);
+static gboolean check_sat    (gint catnum);
+static gboolean map_db       (void);
+static void     unmap_db     (void);
+static gboolean check_db     (const gchar *data, gsize len);
+static gboolean import_sats  (void);
+static gboolean write_db     (const sat_db_entry_t *entries, guint num,
+                              gint64 dirtime, gint64 filetime);
+static GArray  *read_cat_files (void);
+static void     free_cat_files (GArray *cats);
+static const sat_db_rec_t   *find_rec   (gint catnum);
+static const sat_db_group_t *find_group (const gchar *file);
+static void     rec_to_entry (const sat_db_rec_t *rec, sat_db_entry_t *entry);
+static guint32  add_string   (GString *strings, const gchar *str);
+static gint64   satdata_mtime (void);
+static gint64   satdata_filetime (void);
+static gint64   file_mtime   (const gchar *path);
+static gchar   *db_file_name (void);
+static gint     compare_catnum (gconstpointer a, gconstpointer b, gpointer data);
+static gint     compare_name (gconstpointer a, gconstpointer b, gpointer data);
+static gint     compare_cat  (gconstpointer a, gconstpointer b);
+
+
+G_LOCK_DEFINE_STATIC (db);
+
+/* the mapped catalogue */
+static GMappedFile           *db = NULL;
+static const sat_db_header_t *header = NULL;
+static const sat_db_rec_t    *recs = NULL;
+static const guint32         *names = NULL;
+static const sat_db_group_t  *groups = NULL;
+static const gint32          *members = NULL;
+static const gchar           *strings = NULL;
+
+
+/** \brief Read a satellite from the catalogue.
+ *  \param catnum The catalog number of the satellite.
+ *  \param sat Pointer to a valid sat_t structure.
+ *  \return TRUE if the satellite has been found.
+ *
+ * Only the elements, name, nickname and website are filled in; the caller
+ * initialises the rest. The strings are newly allocated. The catalogue is
+ * imported again first if .sat files have been added or removed, or if the
+ * .sat file of the satellite has changed.
+ */
+gboolean
+sat_db_read_sat (gint catnum, sat_t *sat)
+{
+    const sat_db_rec_t *rec = NULL;
+
+
+    G_LOCK (db);
+
+    if (load_db (FALSE) && check_sat (catnum))
+        rec = find_rec (catnum);
+
+    if (rec != NULL) {
+        sat->tle = rec->tle;
+        sat->name = g_strdup (strings + rec->name);
+        sat->nickname = g_strdup (strings + rec->nickname);
+        sat->website = rec->website ? g_strdup (strings + rec->website) : NULL;
+    }
+
+    G_UNLOCK (db);
+
+    return (rec != NULL);
+}
+
+
+/** \brief Call a function for each satellite in the catalogue.
+ *  \param func The function to call.
+ *  \param data User data passed to func.
+ *  \return The number of satellites.
+ *
+ * The satellites are passed in the order of their nicknames. The catalogue
+ * is imported again first if .sat or .cat files have been added, removed
+ * or changed. func must not call other sat_db functions.
+ */
+guint
+sat_db_foreach (sat_db_func_t func, gpointer data)
+{
+    sat_db_entry_t entry;
+    guint          i, num = 0;
+
+
+    G_LOCK (db);
+
+    if (load_db (TRUE)) {
+        num = header->count;
+
+        for (i = 0; i < num; i++) {
+            rec_to_entry (&recs[names[i]], &entry);
+            func (&entry, data);
+        }
+    }
+
+    G_UNLOCK (db);
+
+    return num;
+}
+
+
+/** \brief Look up a satellite in the catalogue.
+ *  \param catnum The catalogue number.
+ *  \param func The function to call with the satellite.
+ *  \param data User data passed to func.
+ *  \return TRUE if the satellite has been found.
+ *
+ * This is the light-weight alternative to gtk_sat_data_read_sat() for
+ * callers that only need the name or the elements. Like sat_db_read_sat(),
+ * it checks the .sat file of the satellite. func must not call other sat_db
+ * functions.
+ */
+gboolean
+sat_db_lookup (gint catnum, sat_db_func_t func, gpointer data)
+{
+    const sat_db_rec_t *rec = NULL;
+    sat_db_entry_t      entry;
+
+
+    G_LOCK (db);
+
+    if (load_db (FALSE) && check_sat (catnum))
+        rec = find_rec (catnum);
+
+    if (rec != NULL) {
+        rec_to_entry (rec, &entry);
+        func (&entry, data);
+    }
+
+    G_UNLOCK (db);
+
+    return (rec != NULL);
+}
+
+
+/** \brief Call a function for each group in the catalogue.
+ *  \param func The function to call.
+ *  \param data User data passed to func.
+ *  \return The number of groups.
+ *
+ * The groups are passed in the order of their names. func must not call
+ * other sat_db functions.
+ */
+guint
+sat_db_foreach_group (sat_db_group_func_t func, gpointer data)
+{
+    guint i, num = 0;
+
+
+    G_LOCK (db);
+
+    if (load_db (TRUE)) {
+        num = header->ngroups;
+
+        for (i = 0; i < num; i++)
+            func (strings + groups[i].file, strings + groups[i].name, data);
+    }
+
+    G_UNLOCK (db);
+
+    return num;
+}
+
+
+/** \brief Call a function for each satellite of a group.
+ *  \param file The name of the .cat file of the group.
+ *  \param func The function to call.
+ *  \param data User data passed to func.
+ *  \return The number of satellites passed to func.
+ *
+ * The satellites are passed in the order of the .cat file. Members that are
+ * not in the catalogue are skipped. func must not call other sat_db
+ * functions.
+ */
+guint
+sat_db_foreach_member (const gchar *file, sat_db_func_t func, gpointer data)
+{
+    const sat_db_group_t *group = NULL;
+    const sat_db_rec_t   *rec;
+    sat_db_entry_t        entry;
+    guint                 i, num = 0;
+
+
+    G_LOCK (db);
+
+    if (load_db (TRUE))
+        group = find_group (file);
+
+    if (group != NULL) {
+        for (i = 0; i < group->count; i++) {
+            rec = find_rec (members[group->first + i]);
+
+            if (rec == NULL) {
+                sat_log_log (SAT_LOG_LEVEL_ERROR,
+                             _("%s: Satellite %d of %s is not in the catalogue."),
+                             __FUNCTION__, members[group->first + i], file);
+                continue;
+            }
+
+            rec_to_entry (rec, &entry);
+            func (&entry, data);
+            num++;
+        }
+    }
+
+    G_UNLOCK (db);
+
+    return num;
+}
+
+
+/** \brief Replace the catalogue.
+ *  \param entries The satellites.
+ *  \param num The number of satellites.
+ *  \return TRUE if the catalogue has been written.
+ *
+ * If several entries have the same catalogue number, the first one is
+ * kept. The groups are read from the .cat files.
+ */
+gboolean
+sat_db_write (const sat_db_entry_t *entries, guint num)
+{
+    gboolean ok;
+
+
+    G_LOCK (db);
+    ok = write_db (entries, num, satdata_mtime (), satdata_filetime ());
+    G_UNLOCK (db);
+
+    return ok;
+}
+
+
+/** \brief Write the .sat file of a satellite.
+ *  \param entry The satellite.
+ *  \return TRUE if the file has been written.
+ *
+ * An existing file is updated, keeping its comments and other keys. The
+ * file is not synced to disk; the catalogue written by sat_db_write()
+ * holds the same data and is synced.
+ */
+gboolean
+sat_db_export_sat (const sat_db_entry_t *entry)
+{
+    GKeyFile *satdata;
+    FILE     *file;
+    gchar    *path;
+    gchar    *cfgstr;
+    gsize     length;
+    gboolean  ok;
+
+
+    path = sat_file_name_from_catnum (entry->tle.catnr);
+
+    satdata = g_key_file_new ();
+    if (!g_key_file_load_from_file (satdata, path, G_KEY_FILE_KEEP_COMMENTS, NULL)) {
+        g_key_file_set_string (satdata, "Satellite", "VERSION", "1.1");
+        g_key_file_set_string (satdata, "Satellite", "NAME", entry->name);
+        g_key_file_set_string (satdata, "Satellite", "NICKNAME", entry->nickname);
+        if ((entry->website != NULL) && (entry->website[0] != '\0'))
+            g_key_file_set_string (satdata, "Satellite", "WEBSITE", entry->website);
+    }
+    g_key_file_set_string (satdata, "Satellite", "TLE1", entry->line1);
+    g_key_file_set_string (satdata, "Satellite", "TLE2", entry->line2);
+
+    cfgstr = g_key_file_to_data (satdata, &length, NULL);
+
+    file = g_fopen (path, "wb");
+    ok = (file != NULL) && (fwrite (cfgstr, 1, length, file) == length);
+    if (file != NULL)
+        ok = (fclose (file) == 0) && ok;
+
+    if (!ok) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: Could not write %s"),
+                     __FUNCTION__, path);
+    }
+
+    g_free (cfgstr);
+    g_key_file_free (satdata);
+    g_free (path);
+
+    return ok;
+}
+
+
+/** \brief Import the catalogue from the .sat and .cat files. */
+gboolean
+sat_db_import (void)
+{
+    gboolean ok;
+
+
+    G_LOCK (db);
+    ok = import_sats ();
+    G_UNLOCK (db);
+
+    return ok;
+}
+
+
+/** \brief Unmap the catalogue. */
+void
+sat_db_close (void)
+{
+    G_LOCK (db);
+    unmap_db ();
+    G_UNLOCK (db);
+}
+
+
+/** \brief Make sure the catalogue is mapped and up to date.
+ *  \param scan TRUE to check the modification time of every .sat and .cat
+ *              file, not only of the satdata directory.
+ *
+ * Must be called with the lock held.
+ */
+static gboolean
+load_db (gboolean scan)
+{
+    if ((db == NULL) && !map_db ())
+        return import_sats ();
+
+    if (header->dirtime != satdata_mtime ())
+        return import_sats ();
+
+    if (scan && (satdata_filetime () > header->filetime))
+        return import_sats ();
+
+    return TRUE;
+}
+
+
+/** \brief Make sure the catalogue is not older than the .sat file of a
+ *         satellite.
+ *
+ * Must be called with the lock held and the catalogue mapped.
+ */
+static gboolean
+check_sat (gint catnum)
+{
+    gchar    *path;
+    gboolean  ok = TRUE;
+
+
+    path = sat_file_name_from_catnum (catnum);
+
+    if (file_mtime (path) > header->filetime)
+        ok = import_sats ();
+
+    g_free (path);
+
+    return ok;
+}
+
+
+/** \brief Map the catalogue file. Must be called with the lock held. */
+static gboolean
+map_db (void)
+{
+    GMappedFile *file;
+    GError      *error = NULL;
+    gchar       *path;
+    const gchar *data;
+    gsize        len;
+
+
+    unmap_db ();
+
+    path = db_file_name ();
+    file = g_mapped_file_new (path, FALSE, &error);
+
+    if (file == NULL) {
+        sat_log_log (SAT_LOG_LEVEL_MSG,
+                     _("%s: Could not open %s (%s)"),
+                     __FUNCTION__, path, error->message);
+        g_clear_error (&error);
+        g_free (path);
+
+        return FALSE;
+    }
+
+    data = g_mapped_file_get_contents (file);
+    len = g_mapped_file_get_length (file);
+
+    if (!check_db (data, len)) {
+        sat_log_log (SAT_LOG_LEVEL_WARN,
+                     _("%s: Ignoring invalid or outdated %s"),
+                     __FUNCTION__, path);
+        g_mapped_file_unref (file);
+        g_free (path);
+
+        return FALSE;
+    }
+
+    db = file;
+    header = (const sat_db_header_t *) data;
+    recs = (const sat_db_rec_t *) (data + sizeof (sat_db_header_t));
+    names = (const guint32 *) (data + header->names);
+    groups = (const sat_db_group_t *) (data + header->groups);
+    members = (const gint32 *) (data + header->members);
+    strings = data + header->strings;
+
+    g_free (path);
+
+    return TRUE;
+}
+
+
+/** \brief Unmap the catalogue file. Must be called with the lock held. */
+static void
+unmap_db (void)
+{
+    if (db != NULL) {
+        g_mapped_file_unref (db);
+        db = NULL;
+        header = NULL;
+        recs = NULL;
+        names = NULL;
+        groups = NULL;
+        members = NULL;
+        strings = NULL;
+    }
+}
+
+
+/** \brief Check that a catalogue file is complete and consistent. */
+static gboolean
+check_db (const gchar *data, gsize len)
+{
+    const sat_db_header_t *h = (const sat_db_header_t *) data;
+    const sat_db_rec_t    *r;
+    const guint32         *n;
+    const sat_db_group_t  *g;
+    gsize                  slen;
+    guint                  i;
+
+
+    if ((data == NULL) || (len < sizeof (sat_db_header_t)))
+        return FALSE;
+
+    if ((memcmp (h->magic, SAT_DB_MAGIC, sizeof (h->magic)) != 0) ||
+        (h->version != SAT_DB_VERSION) ||
+        (h->recsize != sizeof (sat_db_rec_t)) ||
+        (h->size != len))
+        return FALSE;
+
+    if ((h->names != sizeof (sat_db_header_t) + (gsize) h->count * sizeof (sat_db_rec_t)) ||
+        (h->groups != h->names + (gsize) h->count * sizeof (guint32)) ||
+        (h->members != h->groups + (gsize) h->ngroups * sizeof (sat_db_group_t)) ||
+        (h->strings != h->members + (gsize) h->nmembers * sizeof (gint32)) ||
+        (h->strings >= len) || (data[len-1] != '\0'))
+        return FALSE;
+
+    r = (const sat_db_rec_t *) (data + sizeof (sat_db_header_t));
+    n = (const guint32 *) (data + h->names);
+    g = (const sat_db_group_t *) (data + h->groups);
+    slen = len - h->strings;
+
+    for (i = 0; i < h->ngroups; i++) {
+        if ((g[i].file >= slen) || (g[i].name >= slen) ||
+            (g[i].first > h->nmembers) || (g[i].count > h->nmembers - g[i].first))
+            return FALSE;
+    }
+
+    for (i = 0; i < h->count; i++) {
+        if ((r[i].name >= slen) || (r[i].nickname >= slen) ||
+            (r[i].website >= slen) || (r[i].line1 >= slen) ||
+            (r[i].line2 >= slen) || (n[i] >= h->count))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/** \brief Import the .sat and .cat files into the catalogue.
+ *
+ * Files that can not be read or contain bad elements are left out; reading
+ * them with gtk_sat_data_read_sat() reports the error. Must be called with
+ * the lock held.
+ */
+static gboolean
+import_sats (void)
+{
+    GArray         *entries;
+    GPtrArray      *buffers;
+    GDir           *dir;
+    GKeyFile       *satdata;
+    GError         *error = NULL;
+    sat_db_entry_t  entry;
+    gchar          *dirname, *path;
+    gchar          *name, *nickname, *website, *tlestr1, *tlestr2, *rawtle;
+    const gchar    *fname;
+    gint64          dirtime, filetime;
+    gboolean        ok;
+
+
+    dirtime = satdata_mtime ();
+    filetime = satdata_filetime ();
+    dirname = get_satdata_dir ();
+    dir = g_dir_open (dirname, 0, &error);
+
+    if (dir == NULL) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: Failed to open satdata directory %s (%s)"),
+                     __FUNCTION__, dirname, error->message);
+        g_clear_error (&error);
+        g_free (dirname);
+
+        return FALSE;
+    }
+
+    entries = g_array_new (FALSE, FALSE, sizeof (sat_db_entry_t));
+    buffers = g_ptr_array_new_with_free_func (g_free);
+
+    while ((fname = g_dir_read_name (dir)) != NULL) {
+
+        if (!g_str_has_suffix (fname, ".sat"))
+            continue;
+
+        path = g_strconcat (dirname, G_DIR_SEPARATOR_S, fname, NULL);
+        satdata = g_key_file_new ();
+
+        if (!g_key_file_load_from_file (satdata, path, G_KEY_FILE_NONE, NULL)) {
+            g_key_file_free (satdata);
+            g_free (path);
+            continue;
+        }
+        g_free (path);
+
+        name = g_key_file_get_string (satdata, "Satellite", "NAME", NULL);
+        nickname = g_key_file_get_string (satdata, "Satellite", "NICKNAME", NULL);
+        website = g_key_file_get_string (satdata, "Satellite", "WEBSITE", NULL);
+        tlestr1 = g_key_file_get_string (satdata, "Satellite", "TLE1", NULL);
+        tlestr2 = g_key_file_get_string (satdata, "Satellite", "TLE2", NULL);
+        rawtle = g_strconcat (tlestr1, tlestr2, NULL);
+        g_key_file_free (satdata);
+
+        if ((name != NULL) && (tlestr1 != NULL) && (tlestr2 != NULL) &&
+            Good_Elements (rawtle)) {
+
+            Convert_Satellite_Data (rawtle, &entry.tle);
+            entry.name = name;
+            entry.nickname = nickname ? nickname : name;
+            entry.website = website;
+            entry.line1 = tlestr1;
+            entry.line2 = tlestr2;
+            g_array_append_val (entries, entry);
+
+            g_ptr_array_add (buffers, name);
+            g_ptr_array_add (buffers, nickname);
+            g_ptr_array_add (buffers, website);
+            g_ptr_array_add (buffers, tlestr1);
+            g_ptr_array_add (buffers, tlestr2);
+        }
+        else {
+            g_free (name);
+            g_free (nickname);
+            g_free (website);
+            g_free (tlestr1);
+            g_free (tlestr2);
+        }
+        g_free (rawtle);
+    }
+
+    g_dir_close (dir);
+
+    ok = write_db ((sat_db_entry_t *) entries->data, entries->len,
+                   dirtime, filetime);
+
+    if (ok) {
+        sat_log_log (SAT_LOG_LEVEL_MSG,
+                     _("%s: Imported %d satellites from %s"),
+                     __FUNCTION__, entries->len, dirname);
+    }
+
+    g_array_free (entries, TRUE);
+    g_ptr_array_free (buffers, TRUE);
+    g_free (dirname);
+
+    return ok;
+}
+
+
+/** \brief Write and map a new catalogue file.
+ *
+ * Must be called with the lock held.
+ */
+static gboolean
+write_db (const sat_db_entry_t *entries, guint num, gint64 dirtime,
+          gint64 filetime)
+{
+    sat_db_header_t  h;
+    sat_db_rec_t    *r;
+    guint32         *n;
+    sat_db_group_t  *g;
+    GArray          *m;
+    GArray          *cats;
+    cat_file_t      *cat;
+    guint           *order;
+    GString         *str;
+    GByteArray      *buf;
+    GError          *error = NULL;
+    gchar           *path;
+    guint            i, count = 0;
+    gboolean         ok;
+
+
+    /* records sorted by catalogue number, without duplicates */
+    order = g_new (guint, MAX (num, 1));
+    for (i = 0; i < num; i++)
+        order[i] = i;
+    g_qsort_with_data (order, num, sizeof (guint), compare_catnum, (gpointer) entries);
+
+    r = g_new0 (sat_db_rec_t, MAX (num, 1));
+    str = g_string_new_len ("", 1);
+
+    for (i = 0; i < num; i++) {
+        const sat_db_entry_t *e = &entries[order[i]];
+
+        if ((count > 0) && (r[count-1].tle.catnr == e->tle.catnr))
+            continue;
+
+        r[count].tle = e->tle;
+        r[count].name = add_string (str, e->name);
+        r[count].nickname = add_string (str, e->nickname);
+        r[count].website = add_string (str, e->website);
+        r[count].line1 = add_string (str, e->line1);
+        r[count].line2 = add_string (str, e->line2);
+        count++;
+    }
+
+    /* name index */
+    n = g_new (guint32, MAX (count, 1));
+    for (i = 0; i < count; i++)
+        n[i] = i;
+
+    {
+        gpointer ctx[2] = { r, str->str };
+
+        g_qsort_with_data (n, count, sizeof (guint32), compare_name, ctx);
+    }
+
+    /* groups and their members */
+    cats = read_cat_files ();
+    g = g_new0 (sat_db_group_t, MAX (cats->len, 1));
+    m = g_array_new (FALSE, FALSE, sizeof (gint32));
+
+    for (i = 0; i < cats->len; i++) {
+        cat = &g_array_index (cats, cat_file_t, i);
+
+        g[i].file = add_string (str, cat->file);
+        g[i].name = add_string (str, cat->name);
+        g[i].first = m->len;
+        g[i].count = cat->members->len;
+        g_array_append_vals (m, cat->members->data, cat->members->len);
+    }
+
+    memset (&h, 0, sizeof (h));
+    memcpy (h.magic, SAT_DB_MAGIC, sizeof (h.magic));
+    h.version = SAT_DB_VERSION;
+    h.recsize = sizeof (sat_db_rec_t);
+    h.count = count;
+    h.names = sizeof (sat_db_header_t) + count * sizeof (sat_db_rec_t);
+    h.groups = h.names + count * sizeof (guint32);
+    h.ngroups = cats->len;
+    h.members = h.groups + cats->len * sizeof (sat_db_group_t);
+    h.nmembers = m->len;
+    h.strings = h.members + m->len * sizeof (gint32);
+    h.size = h.strings + str->len;
+    h.dirtime = dirtime;
+    h.filetime = filetime;
+
+    buf = g_byte_array_sized_new (h.size);
+    g_byte_array_append (buf, (guint8 *) &h, sizeof (h));
+    g_byte_array_append (buf, (guint8 *) r, count * sizeof (sat_db_rec_t));
+    g_byte_array_append (buf, (guint8 *) n, count * sizeof (guint32));
+    g_byte_array_append (buf, (guint8 *) g, cats->len * sizeof (sat_db_group_t));
+    g_byte_array_append (buf, (guint8 *) m->data, m->len * sizeof (gint32));
+    g_byte_array_append (buf, (guint8 *) str->str, str->len);
+
+    /* the old file stays mapped until the new one is in place, except on
+       windows where a mapped file can not be replaced */
+#ifdef G_OS_WIN32
+    unmap_db ();
+#endif
+    path = db_file_name ();
+    ok = g_file_set_contents (path, (gchar *) buf->data, buf->len, &error);
+
+    if (!ok) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: Could not write %s (%s)"),
+                     __FUNCTION__, path, error->message);
+        g_clear_error (&error);
+    }
+    else {
+        ok = map_db ();
+    }
+
+    g_free (path);
+    g_byte_array_free (buf, TRUE);
+    g_string_free (str, TRUE);
+    g_array_free (m, TRUE);
+    g_free (g);
+    free_cat_files (cats);
+    g_free (n);
+    g_free (r);
+    g_free (order);
+
+    return ok;
+}
+
+
+/** \brief Read the groups from the .cat files.
+ *
+ * A .cat file contains the name of the group in the first line and the
+ * catalogue numbers of the members in the following lines. The groups are
+ * sorted by name.
+ */
+static GArray *
+read_cat_files (void)
+{
+    GArray       *cats;
+    GDir         *dir;
+    cat_file_t    cat;
+    gchar        *dirname, *path, *contents;
+    gchar       **lines;
+    const gchar  *fname;
+    gint32        catnr;
+    guint         i;
+
+
+    cats = g_array_new (FALSE, FALSE, sizeof (cat_file_t));
+
+    dirname = get_satdata_dir ();
+    dir = g_dir_open (dirname, 0, NULL);
+
+    while ((dir != NULL) && ((fname = g_dir_read_name (dir)) != NULL)) {
+
+        if (!g_str_has_suffix (fname, ".cat"))
+            continue;
+
+        path = g_strconcat (dirname, G_DIR_SEPARATOR_S, fname, NULL);
+
+        if (!g_file_get_contents (path, &contents, NULL, NULL)) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Failed to read %s"),
+                         __FUNCTION__, path);
+            g_free (path);
+            continue;
+        }
+        g_free (path);
+
+        lines = g_strsplit (contents, "\n", 0);
+        g_free (contents);
+
+        if (lines[0] != NULL) {
+            cat.file = g_strdup (fname);
+            cat.name = g_strstrip (g_strdup (lines[0]));
+            cat.members = g_array_new (FALSE, FALSE, sizeof (gint32));
+
+            for (i = 1; lines[i] != NULL; i++) {
+                g_strstrip (lines[i]);
+                if (lines[i][0] == '\0')
+                    continue;
+
+                catnr = (gint32) g_ascii_strtoll (lines[i], NULL, 0);
+                g_array_append_val (cat.members, catnr);
+            }
+
+            g_array_append_val (cats, cat);
+        }
+
+        g_strfreev (lines);
+    }
+
+    if (dir != NULL)
+        g_dir_close (dir);
+    g_free (dirname);
+
+    g_array_sort (cats, compare_cat);
+
+    return cats;
+}
+
+
+/** \brief Free the groups returned by read_cat_files(). */
+static void
+free_cat_files (GArray *cats)
+{
+    cat_file_t *cat;
+    guint       i;
+
+
+    for (i = 0; i < cats->len; i++) {
+        cat = &g_array_index (cats, cat_file_t, i);
+        g_free (cat->file);
+        g_free (cat->name);
+        g_array_free (cat->members, TRUE);
+    }
+
+    g_array_free (cats, TRUE);
+}
+
+
+/** \brief Find a group by its file name. Must be called with the lock held. */
+static const sat_db_group_t *
+find_group (const gchar *file)
+{
+    guint i;
+
+
+    for (i = 0; i < header->ngroups; i++) {
+        if (!strcmp (strings + groups[i].file, file))
+            return &groups[i];
+    }
+
+    return NULL;
+}
+
+
+/** \brief Find the record of a satellite. Must be called with the lock held. */
+static const sat_db_rec_t *
+find_rec (gint catnum)
+{
+    guint lo = 0;
+    guint hi = header->count;
+    guint mid;
+
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+
+        if (recs[mid].tle.catnr < catnum)
+            lo = mid + 1;
+        else if (recs[mid].tle.catnr > catnum)
+            hi = mid;
+        else
+            return &recs[mid];
+    }
+
+    return NULL;
+}
+
+
+/** \brief Fill a catalogue entry from a record. */
+static void
+rec_to_entry (const sat_db_rec_t *rec, sat_db_entry_t *entry)
+{
+    entry->tle = rec->tle;
+    entry->name = strings + rec->name;
+    entry->nickname = strings + rec->nickname;
+    entry->website = rec->website ? strings + rec->website : NULL;
+    entry->line1 = strings + rec->line1;
+    entry->line2 = strings + rec->line2;
+}
+
+
+/** \brief Add a string to the string table and return its offset.
+ *
+ * NULL is stored as offset 0, which is the empty string at the start of
+ * the table.
+ */
+static guint32
+add_string (GString *strings, const gchar *str)
+{
+    guint32 offset;
+
+
+    if (str == NULL)
+        return 0;
+
+    offset = strings->len;
+    g_string_append_len (strings, str, strlen (str) + 1);
+
+    return offset;
+}
+
+
+/** \brief Get the modification time of the satdata directory. */
+static gint64
+satdata_mtime (void)
+{
+    struct stat  sb;
+    gchar       *dirname;
+    gint64       mtime = -1;
+
+
+    dirname = get_satdata_dir ();
+    if (g_stat (dirname, &sb) == 0)
+        mtime = (gint64) sb.st_mtime;
+    g_free (dirname);
+
+    return mtime;
+}
+
+
+/** \brief Get the newest modification time of the .sat and .cat files. */
+static gint64
+satdata_filetime (void)
+{
+    GDir        *dir;
+    const gchar *fname;
+    gchar       *dirname, *path;
+    gint64       mtime = -1;
+
+
+    dirname = get_satdata_dir ();
+    dir = g_dir_open (dirname, 0, NULL);
+
+    while ((dir != NULL) && ((fname = g_dir_read_name (dir)) != NULL)) {
+
+        if (!g_str_has_suffix (fname, ".sat") && !g_str_has_suffix (fname, ".cat"))
+            continue;
+
+        path = g_strconcat (dirname, G_DIR_SEPARATOR_S, fname, NULL);
+        mtime = MAX (mtime, file_mtime (path));
+        g_free (path);
+    }
+
+    if (dir != NULL)
+        g_dir_close (dir);
+    g_free (dirname);
+
+    return mtime;
+}
+
+
+/** \brief Get the modification time of a file, or -1 if it does not exist. */
+static gint64
+file_mtime (const gchar *path)
+{
+    struct stat sb;
+
+
+    if (g_stat (path, &sb) != 0)
+        return -1;
+
+    return (gint64) sb.st_mtime;
+}
+
+
+/** \brief Get the full path of the catalogue file. */
+static gchar *
+db_file_name (void)
+{
+    gchar *confdir;
+    gchar *path;
+
+
+    confdir = get_user_conf_dir ();
+    path = g_strconcat (confdir, G_DIR_SEPARATOR_S, SAT_DB_FILE, NULL);
+    g_free (confdir);
+
+    return path;
+}
+
+
+/** \brief Order entry indices by catalogue number, then by position. */
+static gint
+compare_catnum (gconstpointer a, gconstpointer b, gpointer data)
+{
+    const sat_db_entry_t *entries = data;
+    guint                 ia = *(const guint *) a;
+    guint                 ib = *(const guint *) b;
+
+
+    if (entries[ia].tle.catnr != entries[ib].tle.catnr)
+        return (entries[ia].tle.catnr < entries[ib].tle.catnr) ? -1 : 1;
+
+    return (ia < ib) ? -1 : (ia > ib);
+}
+
+
+/** \brief Order record indices by nickname, then by catalogue number. */
+static gint
+compare_name (gconstpointer a, gconstpointer b, gpointer data)
+{
+    gpointer           *ctx = data;
+    const sat_db_rec_t *r = ctx[0];
+    const gchar        *s = ctx[1];
+    guint32             ia = *(const guint32 *) a;
+    guint32             ib = *(const guint32 *) b;
+    gint                ret;
+
+
+    ret = g_ascii_strcasecmp (s + r[ia].nickname, s + r[ib].nickname);
+    if (ret != 0)
+        return ret;
+
+    return (r[ia].tle.catnr < r[ib].tle.catnr) ? -1 : 1;
+}
+
+
+/** \brief Order groups by name. */
+static gint
+compare_cat (gconstpointer a, gconstpointer b)
+{
+    const cat_file_t *ca = a;
+    const cat_file_t *cb = b;
+
+
+    return g_ascii_strcasecmp (ca->name, cb->name);
+}
@@ -0,0 +1,69 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2010  Alexandru Csete, OZ9AEC.
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+#ifndef SAT_DB_H
+#define SAT_DB_H 1
+
+#include <glib.h>
+#include "sgpsdp/sgp4sdp4.h"
+
+
+/** \brief A satellite in the catalogue.
+ *
+ * The strings point into the catalogue and are only valid during the
+ * callback they are passed to.
+ */
+typedef struct {
+    tle_t        tle;        /*!< The parsed elements. */
+    const gchar *name;       /*!< Name. */
+    const gchar *nickname;   /*!< Nickname. */
+    const gchar *website;    /*!< Website, may be NULL. */
+    const gchar *line1;      /*!< First TLE line. */
+    const gchar *line2;      /*!< Second TLE line. */
+} sat_db_entry_t;
+
+
+/** \brief Callback of sat_db_foreach(), sat_db_foreach_member() and
+ *         sat_db_lookup().
+ */
+typedef void (*sat_db_func_t) (const sat_db_entry_t *entry, gpointer data);
+
+/** \brief Callback of sat_db_foreach_group(). */
+typedef void (*sat_db_group_func_t) (const gchar *file, const gchar *name,
+                                     gpointer data);
+
+
+gboolean sat_db_read_sat (gint catnum, sat_t *sat);
+guint    sat_db_foreach  (sat_db_func_t func, gpointer data);
+gboolean sat_db_lookup   (gint catnum, sat_db_func_t func, gpointer data);
+guint    sat_db_foreach_group  (sat_db_group_func_t func, gpointer data);
+guint    sat_db_foreach_member (const gchar *file, sat_db_func_t func,
+                                gpointer data);
+gboolean sat_db_write    (const sat_db_entry_t *entries, guint num);
+gboolean sat_db_export_sat (const sat_db_entry_t *entry);
+gboolean sat_db_import   (void);
+void     sat_db_close    (void);
+
+#endif
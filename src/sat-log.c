@@ -62,6 +62,10 @@ const gchar *SRC_TO_STR[] = {N_("NONE"), N_("HAMLIB"), N_("GPREDICT")};
 
 static gboolean initialised = FALSE;
 static GIOChannel *logfile = NULL;
+
+/* Messages are also logged from worker threads, e.g. the OSC sender; the
+   lock serialises the writes to the log file. */
+G_LOCK_DEFINE_STATIC (logfile);
 static sat_log_level_t loglevel = SAT_LOG_LEVEL_DEBUG;
 
 
@@ -149,10 +153,12 @@ sat_log_close       ()
      if (initialised) {
           sat_log_log (SAT_LOG_LEVEL_MSG,
                           _("%s: Session ended"), __FUNCTION__);
+          G_LOCK (logfile);
           g_io_channel_shutdown (logfile, TRUE, NULL);
           g_io_channel_unref (logfile);
           logfile = NULL;
           initialised = FALSE;
+          G_UNLOCK (logfile);
           if (sat_cfg_get_bool (SAT_CFG_BOOL_KEEP_LOG_FILES)) {
                log_rotate ();
           }
@@ -238,6 +244,8 @@ manage_debug_message (sat_log_src_t source,
      GError  *error = NULL;
 
 
+     G_LOCK (logfile);
+
      /* get the time */
      g_get_current_time (&tval);
      t = (time_t ) tval.tv_sec;
@@ -274,6 +282,8 @@ manage_debug_message (sat_log_src_t source,
 
      }
 
+     G_UNLOCK (logfile);
+
      g_free (msg);
 }
 
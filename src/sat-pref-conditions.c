@@ -41,6 +41,7 @@ static GtkWidget *numpass;
 static GtkWidget *lookahead;
 static GtkWidget *res;
 static GtkWidget *nument;
+static GtkWidget *maxerr;
 static GtkWidget *twspin;
 
 static gboolean dirty = FALSE;  /* used to check whether any changes have occurred */
@@ -68,7 +69,7 @@ GtkWidget *sat_pref_conditions_create ()
      dirty = FALSE;
      reset = FALSE;
 
-     table = gtk_table_new (14, 3, FALSE);
+     table = gtk_table_new (15, 3, FALSE);
      gtk_table_set_row_spacings (GTK_TABLE (table), 10);
      gtk_table_set_col_spacings (GTK_TABLE (table), 5);
 
@@ -263,10 +264,44 @@ GtkWidget *sat_pref_conditions_create ()
                            GTK_SHRINK,
                            0, 0);
 
+     /* max track error */
+     label = gtk_label_new (_("Max. track error"));
+     gtk_misc_set_alignment (GTK_MISC (label), 0.0, 0.5);
+     gtk_table_attach (GTK_TABLE (table), label,
+                           0, 1, 9, 10,
+                           GTK_FILL,
+                           GTK_SHRINK,
+                           0, 0);
+     maxerr = gtk_spin_button_new_with_range (0, 2, 0.05);
+     gtk_widget_set_tooltip_text (maxerr,
+                                  _("Gpredict leaves out pass details where the "\
+                                    "track drawn between the remaining ones deviates "\
+                                    "less than this from the real track.\n"\
+                                    "Use 0 to get the details at regular time steps."));
+     gtk_spin_button_set_digits (GTK_SPIN_BUTTON (maxerr), 2);
+     gtk_spin_button_set_numeric (GTK_SPIN_BUTTON (maxerr), TRUE);
+     gtk_spin_button_set_wrap (GTK_SPIN_BUTTON (maxerr), FALSE);
+     gtk_spin_button_set_value (GTK_SPIN_BUTTON (maxerr),
+                                      sat_cfg_get_int (SAT_CFG_INT_PRED_MAX_ERROR) / 1000.0);
+     g_signal_connect (G_OBJECT (maxerr), "value-changed",
+                           G_CALLBACK (spin_changed_cb), NULL);
+     gtk_table_attach (GTK_TABLE (table), maxerr,
+                           1, 2, 9, 10,
+                           GTK_FILL,
+                           GTK_SHRINK,
+                           0, 0);
+     label = gtk_label_new (_("[deg]"));
+     gtk_misc_set_alignment (GTK_MISC (label), 0.0, 0.5);
+     gtk_table_attach (GTK_TABLE (table), label,
+                           2, 3, 9, 10,
+                           GTK_FILL | GTK_EXPAND,
+                           GTK_SHRINK,
+                           0, 0);
+
     /* separator */
     gtk_table_attach (GTK_TABLE (table),
                       gtk_hseparator_new (),
-                      0, 3, 9, 10,
+                      0, 3, 10, 11,
                       GTK_FILL | GTK_EXPAND,
                       GTK_SHRINK,
                       0, 0);
@@ -276,7 +311,7 @@ GtkWidget *sat_pref_conditions_create ()
     gtk_label_set_markup (GTK_LABEL (label), _("<b>Satellite Visibility:</b>"));
     gtk_misc_set_alignment (GTK_MISC (label), 0.0, 0.5);
     gtk_table_attach (GTK_TABLE (table), label,
-                      0, 1, 10, 11,
+                      0, 1, 11, 12,
                       GTK_FILL,
                       GTK_SHRINK,
                       0, 0);
@@ -285,7 +320,7 @@ GtkWidget *sat_pref_conditions_create ()
     label = gtk_label_new (_("Twilight threshold"));
     gtk_misc_set_alignment (GTK_MISC (label), 0.0, 0.5);
     gtk_table_attach (GTK_TABLE (table), label,
-                      0, 1, 11, 12,
+                      0, 1, 12, 13,
                       GTK_FILL,
                       GTK_SHRINK,
                       0, 0);
@@ -304,14 +339,14 @@ GtkWidget *sat_pref_conditions_create ()
     g_signal_connect (G_OBJECT (twspin), "value-changed",
                       G_CALLBACK (spin_changed_cb), NULL);
     gtk_table_attach (GTK_TABLE (table), twspin,
-                      1, 2, 11, 12,
+                      1, 2, 12, 13,
                       GTK_FILL,
                       GTK_SHRINK,
                       0, 0);
     label = gtk_label_new (_("[deg]"));
     gtk_misc_set_alignment (GTK_MISC (label), 0.0, 0.5);
     gtk_table_attach (GTK_TABLE (table), label,
-                      2, 3, 11, 12,
+                      2, 3, 12, 13,
                       GTK_FILL | GTK_EXPAND,
                       GTK_SHRINK,
                       0, 0);
@@ -319,7 +354,7 @@ GtkWidget *sat_pref_conditions_create ()
     /* separator */
     gtk_table_attach (GTK_TABLE (table),
                       gtk_hseparator_new (),
-                      0, 3, 12, 13,
+                      0, 3, 13, 14,
                       GTK_FILL | GTK_EXPAND,
                       GTK_SHRINK,
                       0, 0);
@@ -338,7 +373,7 @@ GtkWidget *sat_pref_conditions_create ()
     g_signal_connect (G_OBJECT (tzero), "toggled",
                       G_CALLBACK (spin_changed_cb), NULL);
      
-    gtk_table_attach (GTK_TABLE (table), tzero, 0, 3, 13, 14,
+    gtk_table_attach (GTK_TABLE (table), tzero, 0, 3, 14, 15,
                       GTK_FILL | GTK_EXPAND, GTK_SHRINK,
                       0, 0);
     
@@ -381,6 +416,8 @@ sat_pref_conditions_ok     ()
                                gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (res)));
           sat_cfg_set_int (SAT_CFG_INT_PRED_NUM_ENTRIES,
                                gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (nument)));
+          sat_cfg_set_int (SAT_CFG_INT_PRED_MAX_ERROR,
+                               (gint) (gtk_spin_button_get_value (GTK_SPIN_BUTTON (maxerr)) * 1000.0 + 0.5));
         sat_cfg_set_int (SAT_CFG_INT_PRED_TWILIGHT_THLD,
                          gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (twspin)));
         sat_cfg_set_bool (SAT_CFG_BOOL_PRED_USE_REAL_T0,
@@ -394,6 +431,7 @@ sat_pref_conditions_ok     ()
           sat_cfg_reset_int (SAT_CFG_INT_PRED_LOOK_AHEAD);
           sat_cfg_reset_int (SAT_CFG_INT_PRED_RESOLUTION);
           sat_cfg_reset_int (SAT_CFG_INT_PRED_NUM_ENTRIES);
+          sat_cfg_reset_int (SAT_CFG_INT_PRED_MAX_ERROR);
         sat_cfg_reset_int (SAT_CFG_INT_PRED_TWILIGHT_THLD);
         sat_cfg_reset_bool (SAT_CFG_BOOL_PRED_USE_REAL_T0);
 
@@ -466,6 +504,8 @@ reset_cb               (GtkWidget *button, gpointer data)
                                       sat_cfg_get_int_def (SAT_CFG_INT_PRED_RESOLUTION));
      gtk_spin_button_set_value (GTK_SPIN_BUTTON (nument),
                                       sat_cfg_get_int_def (SAT_CFG_INT_PRED_NUM_ENTRIES));
+     gtk_spin_button_set_value (GTK_SPIN_BUTTON (maxerr),
+                                      sat_cfg_get_int_def (SAT_CFG_INT_PRED_MAX_ERROR) / 1000.0);
     gtk_spin_button_set_value (GTK_SPIN_BUTTON (twspin),
                                sat_cfg_get_int_def (SAT_CFG_INT_PRED_TWILIGHT_THLD));
     gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (tzero),
@@ -44,6 +44,9 @@
 static GtkWidget *level;
 static GtkWidget *age;
 static GtkWidget *osccheck;
+static GtkWidget *oscbundle;
+static GtkWidget *oscdouble;
+static GtkWidget *oscblob;
 
 static gboolean dirty = FALSE;
 static gboolean reset = FALSE;
@@ -145,6 +148,27 @@ GtkWidget *sat_pref_debug_create ()
      g_signal_connect (G_OBJECT (osccheck), "clicked", 
 				G_CALLBACK (state_change_cb), NULL);
 
+     oscbundle = gtk_check_button_new_with_label (_("Send OSC messages in one bundle per cycle"));
+     gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (oscbundle),
+                                   sat_cfg_get_bool (SAT_CFG_BOOL_OSC_BUNDLE));
+     gtk_box_pack_start (GTK_BOX (vbox), oscbundle, FALSE, FALSE, 0);
+     g_signal_connect (G_OBJECT (oscbundle), "clicked",
+                       G_CALLBACK (state_change_cb), NULL);
+
+     oscdouble = gtk_check_button_new_with_label (_("Send OSC data in double precision"));
+     gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (oscdouble),
+                                   sat_cfg_get_bool (SAT_CFG_BOOL_OSC_DOUBLE));
+     gtk_box_pack_start (GTK_BOX (vbox), oscdouble, FALSE, FALSE, 0);
+     g_signal_connect (G_OBJECT (oscdouble), "clicked",
+                       G_CALLBACK (state_change_cb), NULL);
+
+     oscblob = gtk_check_button_new_with_label (_("Pack OSC data of all satellites into binary blobs"));
+     gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (oscblob),
+                                   sat_cfg_get_bool (SAT_CFG_BOOL_OSC_BLOB));
+     gtk_box_pack_start (GTK_BOX (vbox), oscblob, FALSE, FALSE, 0);
+     g_signal_connect (G_OBJECT (oscblob), "clicked",
+                       G_CALLBACK (state_change_cb), NULL);
+
 
      /* reset button */
      rbut = gtk_button_new_with_label (_("Reset"));
@@ -211,6 +235,12 @@ sat_pref_debug_ok     ()
                                gtk_combo_box_get_active (GTK_COMBO_BOX (level)));
 
 	  sat_cfg_set_bool(SAT_CFG_BOOL_SEND_OSC, gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (osccheck)));
+          sat_cfg_set_bool (SAT_CFG_BOOL_OSC_BUNDLE,
+                            gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (oscbundle)));
+          sat_cfg_set_bool (SAT_CFG_BOOL_OSC_DOUBLE,
+                            gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (oscdouble)));
+          sat_cfg_set_bool (SAT_CFG_BOOL_OSC_BLOB,
+                            gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (oscblob)));
 
           switch (num) {
 
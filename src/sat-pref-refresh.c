@@ -41,6 +41,7 @@ static GtkWidget *listspin;   /* spin button for list view */
 static GtkWidget *mapspin;    /* spin button for map view */
 static GtkWidget *polarspin;  /* spin button for polar view */
 static GtkWidget *singlespin; /* spin button for single-sat view */
+static GtkWidget *threadspin; /* spin button for propagation threads (global only) */
 
 static gboolean dirty = FALSE;  /* used to check whether any changes have occurred */
 static gboolean reset = FALSE;
@@ -67,9 +68,10 @@ GtkWidget *sat_pref_refresh_create (GKeyFile *cfg)
 
      dirty = FALSE;
      reset = FALSE;
+     threadspin = NULL;
 
      /* create table */
-     table = gtk_table_new (6, 3, FALSE);
+     table = gtk_table_new (8, 3, FALSE);
      gtk_table_set_row_spacings (GTK_TABLE (table), 10);
      gtk_table_set_col_spacings (GTK_TABLE (table), 5);
 
@@ -271,6 +273,49 @@ GtkWidget *sat_pref_refresh_create (GKeyFile *cfg)
                  0, 0);
 
 
+     /* Propagation threads; this is a global setting shared by all modules */
+     if (cfg == NULL) {
+          gtk_table_attach (GTK_TABLE (table),
+                      gtk_hseparator_new (),
+                      0, 3, 6, 7,
+                      GTK_FILL | GTK_EXPAND,
+                      GTK_SHRINK,
+                      0, 0);
+
+          label = gtk_label_new (_("Propagation threads"));
+          gtk_misc_set_alignment (GTK_MISC (label), 0.0, 0.5);
+          gtk_table_attach (GTK_TABLE (table), label, 0, 1, 7, 8,
+                      GTK_FILL,
+                      GTK_SHRINK,
+                      0, 0);
+
+          threadspin = gtk_spin_button_new_with_range (0, 64, 1);
+          gtk_spin_button_set_increments (GTK_SPIN_BUTTON (threadspin), 1, 4);
+          gtk_spin_button_set_numeric (GTK_SPIN_BUTTON (threadspin), TRUE);
+          gtk_spin_button_set_update_policy (GTK_SPIN_BUTTON (threadspin),
+                                 GTK_UPDATE_IF_VALID);
+          gtk_widget_set_tooltip_text (threadspin,
+                                 _("Number of threads used for calculating "\
+                                   "the satellite positions in each module.\n"\
+                                   "0 means one thread per processor."));
+          val = sat_cfg_get_int (SAT_CFG_INT_MODULE_THREADS);
+          gtk_spin_button_set_value (GTK_SPIN_BUTTON (threadspin), val);
+          g_signal_connect (G_OBJECT (threadspin), "value-changed",
+                      G_CALLBACK (spin_changed_cb), NULL);
+          gtk_table_attach (GTK_TABLE (table), threadspin, 1, 2, 7, 8,
+                      GTK_FILL,
+                      GTK_SHRINK,
+                      0, 0);
+
+          label = gtk_label_new (_("[0 = auto]"));
+          gtk_misc_set_alignment (GTK_MISC (label), 0.0, 0.5);
+          gtk_table_attach (GTK_TABLE (table), label, 2, 3, 7, 8,
+                      GTK_FILL | GTK_EXPAND,
+                      GTK_SHRINK,
+                      0, 0);
+     }
+
+
      /* create vertical box */
      vbox = gtk_vbox_new (FALSE, 0);
      gtk_container_set_border_width (GTK_CONTAINER (vbox), 20);
@@ -348,6 +393,9 @@ sat_pref_refresh_ok     (GKeyFile *cfg)
                sat_cfg_set_int (SAT_CFG_INT_SINGLE_SAT_REFRESH,
                           gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (singlespin)));
 
+               sat_cfg_set_int (SAT_CFG_INT_MODULE_THREADS,
+                          gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (threadspin)));
+
           }
 
      }
@@ -360,6 +408,7 @@ sat_pref_refresh_ok     (GKeyFile *cfg)
                sat_cfg_reset_int (SAT_CFG_INT_MAP_REFRESH);
                sat_cfg_reset_int (SAT_CFG_INT_POLAR_REFRESH);
                sat_cfg_reset_int (SAT_CFG_INT_SINGLE_SAT_REFRESH);
+               sat_cfg_reset_int (SAT_CFG_INT_MODULE_THREADS);
           }
           else {
                /* remove keys */
@@ -469,6 +518,8 @@ reset_cb               (GtkWidget *button, gpointer cfg)
           gtk_spin_button_set_value (GTK_SPIN_BUTTON (polarspin), val);
           val = sat_cfg_get_int_def (SAT_CFG_INT_SINGLE_SAT_REFRESH);
           gtk_spin_button_set_value (GTK_SPIN_BUTTON (singlespin), val);
+          val = sat_cfg_get_int_def (SAT_CFG_INT_MODULE_THREADS);
+          gtk_spin_button_set_value (GTK_SPIN_BUTTON (threadspin), val);
      }
      else {
           /* local mode, get global value */
@@ -0,0 +1,135 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2010  Alexandru Csete, OZ9AEC.
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+#include <glib.h>
+#include "sat-state.h"
+
+
+/** \brief Number of double columns in sat_state_t. */
+#define SAT_STATE_DBL_COLUMNS 11
+
+
+static void free_columns (sat_state_t *state);
+
+
+/** \brief Create an empty state table. */
+sat_state_t *
+sat_state_new (void)
+{
+    return g_new0 (sat_state_t, 1);
+}
+
+
+/** \brief Free a state table. */
+void
+sat_state_free (sat_state_t *state)
+{
+    if (state == NULL)
+        return;
+
+    free_columns (state);
+    g_free (state);
+}
+
+
+/** \brief Set up the table for a set of satellites.
+ *  \param state The state table.
+ *  \param sats The satellites (sat_t) in dense index order.
+ *
+ * The columns are reallocated and the catalogue numbers are copied; the
+ * other values are initialised from the satellites.
+ */
+void
+sat_state_set_sats (sat_state_t *state, GPtrArray *sats)
+{
+    guint n = sats->len;
+    guint i;
+
+
+    free_columns (state);
+
+    state->nsats = n;
+    state->catnr = g_new0 (gint, MAX (n, 1));
+    state->orbit = g_new0 (gulong, MAX (n, 1));
+    state->block = g_new0 (gdouble, SAT_STATE_DBL_COLUMNS * MAX (n, 1));
+
+    state->az         = state->block;
+    state->el         = state->az + n;
+    state->range      = state->el + n;
+    state->range_rate = state->range + n;
+    state->ssplat     = state->range_rate + n;
+    state->ssplon     = state->ssplat + n;
+    state->alt        = state->ssplon + n;
+    state->velo       = state->alt + n;
+    state->footprint  = state->velo + n;
+    state->aos        = state->footprint + n;
+    state->los        = state->aos + n;
+
+    for (i = 0; i < n; i++) {
+        state->catnr[i] = SAT (g_ptr_array_index (sats, i))->tle.catnr;
+        sat_state_store (state, i, SAT (g_ptr_array_index (sats, i)));
+    }
+}
+
+
+/** \brief Copy the tracking data of a satellite into the table.
+ *  \param state The state table.
+ *  \param idx The dense index of the satellite.
+ *  \param sat The satellite.
+ *
+ * This is called by the propagation workers; different threads may store
+ * different satellites at the same time.
+ */
+void
+sat_state_store (sat_state_t *state, guint idx, sat_t *sat)
+{
+    state->az[idx]         = sat->az;
+    state->el[idx]         = sat->el;
+    state->range[idx]      = sat->range;
+    state->range_rate[idx] = sat->range_rate;
+    state->ssplat[idx]     = sat->ssplat;
+    state->ssplon[idx]     = sat->ssplon;
+    state->alt[idx]        = sat->alt;
+    state->velo[idx]       = sat->velo;
+    state->footprint[idx]  = sat->footprint;
+    state->aos[idx]        = sat->aos;
+    state->los[idx]        = sat->los;
+    state->orbit[idx]      = sat->orbit;
+}
+
+
+/** \brief Free the columns of a state table. */
+static void
+free_columns (sat_state_t *state)
+{
+    g_free (state->catnr);
+    g_free (state->orbit);
+    g_free (state->block);
+
+    state->catnr = NULL;
+    state->orbit = NULL;
+    state->block = NULL;
+    state->nsats = 0;
+}
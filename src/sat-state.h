@@ -0,0 +1,69 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2010  Alexandru Csete, OZ9AEC.
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+#ifndef SAT_STATE_H
+#define SAT_STATE_H 1
+
+#include <glib.h>
+#include "sgpsdp/sgp4sdp4.h"
+
+
+/** \brief Tracking data of the satellites in a module, column by column.
+ *
+ * sat_t holds the TLE, the propagator state and the tracking data of a
+ * satellite in one large structure, so scanning a single value of all
+ * satellites touches a lot of memory. This table keeps a copy of the
+ * tracking data in one array per value, indexed by the dense satellite
+ * index of the module (the position in GtkSatModule::satarray).
+ *
+ * The arrays are written by the propagation workers, each worker writing
+ * only the entries of its own satellites, and read after the cycle has
+ * completed. All double columns are allocated as one block.
+ */
+typedef struct {
+    guint     nsats;         /*!< Number of satellites. */
+    gint     *catnr;         /*!< Catalogue numbers. */
+    gdouble  *az;            /*!< Azimuth [deg] */
+    gdouble  *el;            /*!< Elevation [deg] */
+    gdouble  *range;         /*!< Range [km] */
+    gdouble  *range_rate;    /*!< Range rate [km/s] */
+    gdouble  *ssplat;        /*!< Latitude of the sub-satellite point [deg] */
+    gdouble  *ssplon;        /*!< Longitude of the sub-satellite point [deg] */
+    gdouble  *alt;           /*!< Altitude [km] */
+    gdouble  *velo;          /*!< Velocity [km/s] */
+    gdouble  *footprint;     /*!< Footprint diameter [km] */
+    gdouble  *aos;           /*!< Next AOS (daynum) or 0.0 */
+    gdouble  *los;           /*!< Next LOS (daynum) or 0.0 */
+    gulong   *orbit;         /*!< Orbit number */
+    gdouble  *block;         /*!< The memory of the double columns. */
+} sat_state_t;
+
+
+sat_state_t *sat_state_new      (void);
+void         sat_state_free     (sat_state_t *state);
+void         sat_state_set_sats (sat_state_t *state, GPtrArray *sats);
+void         sat_state_store    (sat_state_t *state, guint idx, sat_t *sat);
+
+#endif
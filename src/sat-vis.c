@@ -51,13 +51,30 @@ static gchar *VIS2STR[SAT_VIS_NUM] = {
  *  \param jul_utc The time at which the visibility should be calculated.
  *  \return The visiblity code.
  *
+ * The twilight threshold is SAT_CFG_INT_PRED_TWILIGHT_THLD.
  */
 sat_vis_t
 get_sat_vis (sat_t *sat, qth_t *qth, gdouble jul_utc)
+{
+    return get_sat_vis_thld (sat, qth, jul_utc,
+                             (gdouble) sat_cfg_get_int (SAT_CFG_INT_PRED_TWILIGHT_THLD));
+}
+
+
+/** \brief Calculate satellite visibility with a given twilight threshold.
+ *  \param sat The satellite structure.
+ *  \param qth The QTH
+ *  \param jul_utc The time at which the visibility should be calculated.
+ *  \param threshold Max elevation of the sun for the satellite to be visible.
+ *  \return The visiblity code.
+ *
+ * This does not read the configuration, so it can be used in worker threads.
+ */
+sat_vis_t
+get_sat_vis_thld (sat_t *sat, qth_t *qth, gdouble jul_utc, gdouble threshold)
 {
     gboolean sat_sun_status;
     gdouble  sun_el;
-    gdouble  threshold;
     gdouble  eclipse_depth;
     sat_vis_t vis = SAT_VIS_NONE;
     vector_t zero_vector = {0,0,0,0};
@@ -91,8 +108,6 @@ get_sat_vis (sat_t *sat, qth_t *qth, gdouble jul_utc)
 
     if (sat_sun_status) {
         sun_el = Degrees (solar_set.el);
-        threshold = (gdouble) sat_cfg_get_int (SAT_CFG_INT_PRED_TWILIGHT_THLD);
-        
         if (sun_el <= threshold && sat->el >= 0.0)
             vis = SAT_VIS_VISIBLE;
         else
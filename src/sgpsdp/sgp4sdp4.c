@@ -1036,34 +1036,3 @@ Deep (int ientry, sat_t *sat)
 } /* End of Deep() */
 
 /*------------------------------------------------------------------*/
-
-/* Functions for testing and setting/clearing flags */
-
-/* An int variable holding the single-bit flags */
-static int Flags = 0;
-
-int
-isFlagSet(int flag)
-{
-  return (Flags & flag);
-}
-
-int
-isFlagClear(int flag)
-{
-  return (~Flags & flag);
-}
-
-void
-SetFlag(int flag)
-{
-  Flags |= flag;
-}
-
-void
-ClearFlag(int flag)
-{
-  Flags &= ~flag;
-}
-
-/*------------------------------------------------------------------*/
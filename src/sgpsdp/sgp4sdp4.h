@@ -116,6 +116,23 @@ typedef struct {
 	double dec;  /*!< Declination [dec] */
 } obs_astro_t;
 
+/** \brief Observer position with the time independent terms precomputed.
+ *  \ingroup sgpsdpif
+ *
+ * Initialise with Init_Observer() whenever the position changes and use
+ * with Calculate_Obs_Observer() or Calculate_Obs_Array() instead of
+ * Calculate_Obs().
+ */
+typedef struct {
+	double lat;      /*!< Latitude [rad] */
+	double lon;      /*!< Longitude [rad] */
+	double alt;      /*!< Altitude [km] */
+	double sin_lat;  /*!< sin(lat) */
+	double cos_lat;  /*!< cos(lat) */
+	double rxy;      /*!< Distance from the rotation axis (ECEF) [km] */
+	double z;        /*!< ECEF z coordinate [km] */
+} observer_t;
+
 
 /* Common arguments between deep-space functions */
 typedef struct {
@@ -291,10 +308,6 @@ FIXME: Change to enu */
 void    SGP4 (sat_t *sat, double tsince);
 void    SDP4 (sat_t *sat, double tsince);
 void    Deep (int ientry, sat_t *sat);
-int     isFlagSet(int flag);
-int     isFlagClear(int flag);
-void    SetFlag(int flag);
-void    ClearFlag(int flag);
 
 /* sgp_in.c */
 int     Checksum_Good(char *tle_set);
@@ -332,8 +345,15 @@ void    Convert_Sat_State(vector_t *pos, vector_t *vel);
 void    Calculate_User_PosVel(double _time, geodetic_t *geodetic,
                               vector_t *obs_pos, vector_t *obs_vel);
 void    Calculate_LatLonAlt(double _time, vector_t *pos, geodetic_t *geodetic);
+void    Calculate_LatLonAlt_Array(double _time, vector_t *pos, int n,
+                                  geodetic_t *geodetic);
 void    Calculate_Obs(double _time, vector_t *pos, vector_t *vel,
                       geodetic_t *geodetic, obs_set_t *obs_set);
+void    Init_Observer(geodetic_t *geodetic, observer_t *obs);
+void    Calculate_Obs_Observer(double _time, vector_t *pos, vector_t *vel,
+                               observer_t *obs, obs_set_t *obs_set);
+void    Calculate_Obs_Array(double _time, vector_t *pos, vector_t *vel, int n,
+                            observer_t *obs, obs_set_t *obs_set);
 void    Calculate_RADec_and_Obs(double _time, vector_t *pos, vector_t *vel,
 				geodetic_t *geodetic, obs_astro_t *obs_set);
 
@@ -49,30 +49,49 @@ Calculate_User_PosVel(double _time,
 /* oblate spheroid as defined in WGS '72.                     */
 void
 Calculate_LatLonAlt(double _time, vector_t *pos,  geodetic_t *geodetic)
+{
+	Calculate_LatLonAlt_Array(_time, pos, 1, geodetic);
+} /*Procedure Calculate_LatLonAlt*/
+
+/*------------------------------------------------------------------*/
+
+/* Procedure Calculate_LatLonAlt_Array calculates the geodetic      */
+/* positions of {n} objects with the ECI positions {pos[]} at the   */
+/* same {time}. The Greenwich sidereal time is calculated only once */
+/* for all objects; the results are the same as those of calling    */
+/* Calculate_LatLonAlt for each object.                             */
+void
+Calculate_LatLonAlt_Array(double _time, vector_t *pos, int n,
+			  geodetic_t *geodetic)
 {
 	/* Reference:  The 1992 Astronomical Almanac, page K12. */
 
-	double r,e2,phi,c;
+	double r,e2,phi,c,thetag;
+	int i;
 
-	geodetic->theta = AcTan(pos->y,pos->x);/*radians*/
-	geodetic->lon = FMod2p(geodetic->theta - ThetaG_JD(_time));/*radians*/
-	r = sqrt(Sqr(pos->x) + Sqr(pos->y));
+	thetag = ThetaG_JD(_time);
 	e2 = __f*(2 - __f);
-	geodetic->lat = AcTan(pos->z,r);/*radians*/
 
-	do
+	for( i = 0; i < n; i++ )
 	{
-		phi = geodetic->lat;
-		c = 1/sqrt(1 - e2*Sqr(sin(phi)));
-		geodetic->lat = AcTan(pos->z + xkmper*c*e2*sin(phi),r);
-	}
-	while(fabs(geodetic->lat - phi) >= 1E-10);
+		geodetic[i].theta = AcTan(pos[i].y,pos[i].x);/*radians*/
+		geodetic[i].lon = FMod2p(geodetic[i].theta - thetag);/*radians*/
+		r = sqrt(Sqr(pos[i].x) + Sqr(pos[i].y));
+		geodetic[i].lat = AcTan(pos[i].z,r);/*radians*/
 
-	geodetic->alt = r/cos(geodetic->lat) - xkmper*c;/*kilometers*/
+		do
+		{
+			phi = geodetic[i].lat;
+			c = 1/sqrt(1 - e2*Sqr(sin(phi)));
+			geodetic[i].lat = AcTan(pos[i].z + xkmper*c*e2*sin(phi),r);
+		}
+		while(fabs(geodetic[i].lat - phi) >= 1E-10);
 
-	if( geodetic->lat > pio2 ) geodetic->lat -= twopi;
-  
-} /*Procedure Calculate_LatLonAlt*/
+		geodetic[i].alt = r/cos(geodetic[i].lat) - xkmper*c;/*kilometers*/
+
+		if( geodetic[i].lat > pio2 ) geodetic[i].lat -= twopi;
+	}
+} /*Procedure Calculate_LatLonAlt_Array*/
 
 /*------------------------------------------------------------------*/
 
@@ -150,17 +169,128 @@ Calculate_Obs(double _time,
 /* Correction is meaningless when apparent elevation is below horizon */
 //	obs_set->el = obs_set->el + Radians((1.02/tan(Radians(Degrees(el)+
 //							      10.3/(Degrees(el)+5.11))))/60);
-	if( obs_set->el >= 0 )
-		SetFlag(VISIBLE_FLAG);
-	else
-	{
+/* The visibility is given by the sign of the elevation; it is not  */
+/* stored in a global flag so that the function is reentrant.         */
+	if( obs_set->el < 0 )
 		obs_set->el = el;  /*Reset to true elevation*/
-		ClearFlag(VISIBLE_FLAG);
-	} /*else*/
 } /*Procedure Calculate_Obs*/
 
 /*------------------------------------------------------------------*/
 
+/* Procedure Init_Observer precomputes the time independent terms   */
+/* of Calculate_User_PosVel and Calculate_Obs for an observer at    */
+/* {geodetic}, i.e. the trigonometric functions of the latitude and */
+/* the position of the observer in the rotating (ECEF) frame.       */
+void
+Init_Observer(geodetic_t *geodetic, observer_t *obs)
+{
+	double c,sq;
+
+	obs->lat = geodetic->lat;
+	obs->lon = geodetic->lon;
+	obs->alt = geodetic->alt;
+	obs->sin_lat = sin(geodetic->lat);
+	obs->cos_lat = cos(geodetic->lat);
+
+	c = 1/sqrt(1 + __f*(__f - 2)*Sqr(obs->sin_lat));
+	sq = Sqr(1 - __f)*c;
+	obs->rxy = (xkmper*c + geodetic->alt)*obs->cos_lat;
+	obs->z = (xkmper*sq + geodetic->alt)*obs->sin_lat;
+} /*Procedure Init_Observer*/
+
+/*------------------------------------------------------------------*/
+
+/* Procedure Calculate_Obs_Observer is equivalent to Calculate_Obs  */
+/* but uses the precomputed observer {obs}, so that only the local  */
+/* sidereal time has to be calculated for each call.                */
+void
+Calculate_Obs_Observer(double _time,
+		       vector_t *pos,
+		       vector_t *vel,
+		       observer_t *obs,
+		       obs_set_t *obs_set)
+{
+	Calculate_Obs_Array(_time, pos, vel, 1, obs, obs_set);
+} /*Procedure Calculate_Obs_Observer*/
+
+/*------------------------------------------------------------------*/
+
+/* Procedure Calculate_Obs_Array calculates the topocentric         */
+/* coordinates of {n} objects with the ECI positions {pos[]} and    */
+/* velocities {vel[]} at the same {time}. The local sidereal time   */
+/* and the observer position and rotation are calculated only once, */
+/* the loop over the objects only does the transformation itself.   */
+/* The results are the same as those of Calculate_Obs_Observer.     */
+void
+Calculate_Obs_Array(double _time,
+		    vector_t *pos,
+		    vector_t *vel,
+		    int n,
+		    observer_t *obs,
+		    obs_set_t *obs_set)
+{
+	double
+		theta,sin_theta,cos_theta,
+		sx,sy,sz,ex,ey,zx,zy,zz,
+		el,azim,
+		top_s,top_e,top_z;
+
+	vector_t
+		obs_pos,range,rgvel;
+
+	int i;
+
+	theta = FMod2p(ThetaG_JD(_time) + obs->lon);/*LMST*/
+	sin_theta = sin(theta);
+	cos_theta = cos(theta);
+
+	obs_pos.x = obs->rxy*cos_theta;/*kilometers*/
+	obs_pos.y = obs->rxy*sin_theta;
+	obs_pos.z = obs->z;
+
+	/* rotation from ECI to south, east, zenith */
+	sx = obs->sin_lat * cos_theta;
+	sy = obs->sin_lat * sin_theta;
+	sz = obs->cos_lat;
+	ex = -sin_theta;
+	ey = cos_theta;
+	zx = obs->cos_lat * cos_theta;
+	zy = obs->cos_lat * sin_theta;
+	zz = obs->sin_lat;
+
+	for( i = 0; i < n; i++ )
+	{
+		range.x = pos[i].x - obs_pos.x;
+		range.y = pos[i].y - obs_pos.y;
+		range.z = pos[i].z - obs_pos.z;
+
+		/* observer velocity is mfactor * (-y, x, 0) */
+		rgvel.x = vel[i].x + mfactor*obs_pos.y;
+		rgvel.y = vel[i].y - mfactor*obs_pos.x;
+		rgvel.z = vel[i].z;
+
+		Magnitude(&range);
+
+		top_s = sx * range.x + sy * range.y - sz * range.z;
+		top_e = ex * range.x + ey * range.y;
+		top_z = zx * range.x + zy * range.y + zz * range.z;
+		azim = atan(-top_e/top_s); /*Azimuth*/
+		if( top_s > 0 )
+			azim = azim + pi;
+		if( azim < 0 )
+			azim = azim + twopi;
+		el = ArcSin(top_z/range.w);
+		obs_set[i].az = azim;      /* Azimuth (radians)  */
+		obs_set[i].el = el;        /* Elevation (radians)*/
+		obs_set[i].range = range.w; /* Range (kilometers) */
+
+		/* Range Rate (kilometers/second)*/
+		obs_set[i].range_rate = Dot(&range, &rgvel)/range.w;
+	}
+} /*Procedure Calculate_Obs_Array*/
+
+/*------------------------------------------------------------------*/
+
 void
 Calculate_RADec_and_Obs ( double _time,
 			  vector_t *pos,
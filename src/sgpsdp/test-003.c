@@ -0,0 +1,183 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2010  Alexandru Csete, OZ9AEC.
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \defgroup test003 Reentrancy test for SGP4 and SDP4
+ *  \ingroup tests
+ *
+ * Propagates the satellites of test-001 (SGP4) and test-002 (SDP4) in the
+ * main thread and then concurrently in several threads, each thread using
+ * its own copy of the satellites. The results of all threads must be bit
+ * identical to the results of the main thread.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include "sgp4sdp4.h"
+
+#define TEST_THREADS 8
+#define TEST_ROUNDS  20
+#define TEST_STEPS   145     /* 0 to 1440 min in 10 min steps */
+#define TEST_SATS    2
+
+
+/* result of one propagation step */
+typedef struct {
+    vector_t   pos;
+    vector_t   vel;
+    obs_set_t  obs;
+} result_t;
+
+
+static const char *tle_files[TEST_SATS] = { "test-001.tle", "test-002.tle" };
+
+static sat_t       sats[TEST_SATS];
+static observer_t  observer;
+static result_t    expected[TEST_SATS][TEST_STEPS];
+
+
+/* propagate a copy of each satellite over all steps */
+static void
+propagate (result_t res[TEST_SATS][TEST_STEPS])
+{
+    sat_t  sat;
+    double tsince;
+    int    i,j;
+
+    for (i = 0; i < TEST_SATS; i++) {
+
+        memcpy (&sat, &sats[i], sizeof (sat_t));
+
+        for (j = 0; j < TEST_STEPS; j++) {
+
+            tsince = 10.0 * j;
+
+            if (sat.flags & DEEP_SPACE_EPHEM_FLAG)
+                SDP4 (&sat, tsince);
+            else
+                SGP4 (&sat, tsince);
+
+            Convert_Sat_State (&sat.pos, &sat.vel);
+            Calculate_Obs_Observer (sat.jul_epoch + tsince / xmnpda,
+                                    &sat.pos, &sat.vel, &observer,
+                                    &res[i][j].obs);
+            res[i][j].pos = sat.pos;
+            res[i][j].vel = sat.vel;
+        }
+    }
+}
+
+
+/* thread function; returns the number of mismatches */
+static gpointer
+worker (gpointer data)
+{
+    result_t (*res)[TEST_STEPS];
+    int      errors = 0;
+    int      n;
+
+    res = g_malloc (sizeof (expected));
+
+    for (n = 0; n < TEST_ROUNDS; n++) {
+        propagate (res);
+        if (memcmp (res, expected, sizeof (expected)))
+            errors++;
+    }
+
+    g_free (res);
+
+    return GINT_TO_POINTER (errors);
+}
+
+
+int
+main (int argc, char **argv)
+{
+    GThread    *threads[TEST_THREADS];
+    geodetic_t  geodetic = { 55.6 * de2ra, 12.6 * de2ra, 0.01, 0.0 };
+    char        tle_str[3][80];
+    FILE       *fp;
+    int         errors = 0;
+    int         i;
+
+    g_thread_init (NULL);
+
+    for (i = 0; i < TEST_SATS; i++) {
+
+        fp = fopen (tle_files[i], "r");
+        if (fp == NULL) {
+            printf ("Could not open %s\n", tle_files[i]);
+            return 1;
+        }
+
+        if ((fgets (tle_str[0], 80, fp) == NULL) ||
+            (fgets (tle_str[1], 80, fp) == NULL) ||
+            (fgets (tle_str[2], 80, fp) == NULL)) {
+            printf ("Could not read %s\n", tle_files[i]);
+            fclose (fp);
+            return 1;
+        }
+        fclose (fp);
+
+        memset (&sats[i], 0, sizeof (sat_t));
+        if (Get_Next_Tle_Set (tle_str, &sats[i].tle) != 1) {
+            printf ("Could not read TLE data from %s\n", tle_files[i]);
+            return 1;
+        }
+
+        select_ephemeris (&sats[i]);
+        sats[i].jul_epoch = Julian_Date_of_Epoch (sats[i].tle.epoch);
+    }
+
+    Init_Observer (&geodetic, &observer);
+
+    /* reference results */
+    propagate (expected);
+
+    printf ("Propagating %d satellites in %d threads, %d rounds each\n",
+            TEST_SATS, TEST_THREADS, TEST_ROUNDS);
+
+    for (i = 0; i < TEST_THREADS; i++) {
+        threads[i] = g_thread_create (worker, NULL, TRUE, NULL);
+        if (threads[i] == NULL) {
+            printf ("Could not create thread %d\n", i);
+            return 1;
+        }
+    }
+
+    for (i = 0; i < TEST_THREADS; i++)
+        errors += GPOINTER_TO_INT (g_thread_join (threads[i]));
+
+    if (errors) {
+        printf ("FAILED: %d of %d rounds differ from the reference\n",
+                errors, TEST_THREADS * TEST_ROUNDS);
+        return 1;
+    }
+
+    printf ("PASSED: all results are identical\n");
+
+    return 0;
+}
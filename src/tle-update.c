@@ -26,6 +26,7 @@
     You should have received a copy of the GNU General Public License
     along with this program; if not, visit http://www.fsf.org/
 */
+#include <string.h>
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <glib/gi18n.h>
@@ -33,11 +34,16 @@
 #ifdef HAVE_CONFIG_H
 #  include <build-config.h>
 #endif
+#ifndef G_OS_WIN32
+#  include <sys/select.h>
+#endif
 #include <curl/curl.h>
 #include "sgpsdp/sgp4sdp4.h"
 #include "sat-log.h"
 #include "sat-cfg.h"
 #include "compat.h"
+#include "sat-db.h"
+#include "prop-pool.h"
 #include "tle-update.h"
 
 
@@ -52,39 +58,104 @@
 static GStaticMutex tle_in_progress = G_STATIC_MUTEX_INIT ;
 static GStaticMutex tle_file_in_progress = G_STATIC_MUTEX_INIT ;
 
+/** \brief Key file in the cache directory holding the validators of the files. */
+#define TLE_CACHE_INFO "cache.info"
+
 /* private function prototypes */
-static size_t  my_write_func (void *ptr, size_t size, size_t nmemb, FILE *stream);
-static gint    read_fresh_tle (const gchar *dir, const gchar *fnam, GHashTable *data);
 static gboolean is_tle_file (const gchar *dir, const gchar *fnam);
 
 
-static void    update_tle_in_file (const gchar *ldname,
-                                   const gchar *fname,
-                                   GHashTable  *data,
-                                   guint       *sat_upd,
-                                   guint       *sat_ski,
-                                   guint       *sat_nod,
-                                   guint       *sat_tot);
-
-static guint add_new_sats (GHashTable *data);
-
-
-
-/** \bief Free a new_tle_t structure. */
-static void free_new_tle (gpointer data)
-{
-    new_tle_t *tle;
-
-    tle = (new_tle_t *) data;
-
-    g_free (tle->satname);
-    g_free (tle->line1);
-    g_free (tle->line2);
-    g_free (tle->srcfile);
-    g_free (tle);
-}
-
-
+/** \brief Incremental parser of NASA three-line TLE data.
+ *
+ * The data may be fed in chunks of any size. Lines are assembled in fixed
+ * buffers, so parsing does not allocate memory except for growing the
+ * array of valid sets.
+ */
+typedef struct {
+    gchar    lines[3][80];  /*!< Lines of the current set. */
+    guint    nlines;        /*!< Number of complete lines of the current set. */
+    gsize    len;           /*!< Length of the line being assembled. */
+    GArray  *tles;          /*!< The valid sets (new_tle_t). */
+    guint    srcfile;       /*!< Index of the source file. */
+    guint    invalid;       /*!< Number of invalid sets. */
+} tle_parser_t;
+
+
+/** \brief A TLE file being ingested. */
+typedef struct {
+    gchar        *fname;    /*!< File name. */
+    gchar        *path;     /*!< Full path. */
+    gboolean      failed;   /*!< The file could not be read. */
+    tle_parser_t  parser;   /*!< Parser holding the sets read from the file. */
+} tle_file_t;
+
+
+/** \brief State of the pass updating the local satellites. */
+typedef struct {
+    GHashTable   *data;     /*!< Fresh sets (new_tle_t) by catalogue number. */
+    GArray       *entries;  /*!< The new catalogue (sat_db_entry_t). */
+    GArray       *changed;  /*!< Indices of the entries to export (guint). */
+    GStringChunk *strings;  /*!< Strings of the entries. */
+    guint         updated;  /*!< Number of satellites updated. */
+    guint         skipped;  /*!< Number of satellites with older data. */
+    guint         nodata;   /*!< Number of satellites without new data. */
+} tle_upd_t;
+
+
+/** \brief Outcome of fetching a TLE file. */
+typedef enum {
+    TLE_SOURCE_FAILED = 0,  /*!< The file could not be fetched. */
+    TLE_SOURCE_UNCHANGED,   /*!< The cached file is up to date. */
+    TLE_SOURCE_CHANGED      /*!< A new file has been fetched. */
+} tle_source_state_t;
+
+
+/** \brief A TLE file being fetched from the network. */
+typedef struct {
+    tle_file_t         *file;      /*!< The file, its path is in the cache. */
+    gchar              *url;       /*!< The URL. */
+    gchar              *tmppath;   /*!< File receiving the data. */
+    FILE               *out;       /*!< Handle of tmppath while receiving. */
+    CURL               *curl;      /*!< The transfer. */
+    struct curl_slist  *headers;   /*!< Extra request headers. */
+    gchar              *etag;      /*!< ETag of the cached file. */
+    gchar              *newetag;   /*!< ETag of the response. */
+    glong               filetime;  /*!< Modification time of the cached file. */
+    gboolean            fetched;   /*!< The file has been received and parsed. */
+} tle_source_t;
+
+
+static void        tle_parser_init     (tle_parser_t *parser, guint srcfile);
+static void        tle_parser_feed     (tle_parser_t *parser,
+                                        const gchar *data, gsize len);
+static void        tle_parser_finish   (tle_parser_t *parser);
+static void        tle_parser_end_line (tle_parser_t *parser);
+static void        tle_parser_add_set  (tle_parser_t *parser);
+
+static tle_file_t *tle_file_new        (const gchar *dir, const gchar *fnam,
+                                        guint index);
+static void        tle_file_free       (tle_file_t *file);
+static void        parse_tle_file      (gpointer data, gpointer user_data);
+static void        sync_cat_file       (tle_file_t *file);
+static guint       apply_tle_files     (GPtrArray *files, gboolean silent,
+                                        GtkWidget *progress,
+                                        GtkWidget *label1, GtkWidget *label2);
+static void        update_sat          (const sat_db_entry_t *entry,
+                                        gpointer data);
+
+static tle_source_t *tle_source_new    (const gchar *server, const gchar *cache,
+                                        const gchar *fname, guint index,
+                                        const gchar *proxy, GKeyFile *info);
+static void        tle_source_free     (tle_source_t *src);
+static size_t      tle_source_write    (void *ptr, size_t size, size_t nmemb,
+                                        void *data);
+static size_t      tle_source_header   (void *ptr, size_t size, size_t nmemb,
+                                        void *data);
+static tle_source_state_t tle_source_done (tle_source_t *src, CURLcode res);
+static void        tle_source_save_info (tle_source_t *src, GKeyFile *info,
+                                         GKeyFile *newinfo, gboolean applied);
+static void        wait_multi          (CURLM *multi);
+static void        prune_cache         (const gchar *cache, gchar **files);
 
 
 
@@ -100,29 +171,24 @@ static void free_new_tle (gpointer data)
  *
  * This function is used to update the TLE data from local files.
  *
- * Functional description: TBD
- *
+ * The TLE files in dir are memory mapped and parsed in parallel, one file
+ * per worker thread. The fresh data is then applied to the satellite
+ * catalogue in a single pass, see apply_tle_files().
  */
 void tle_update_from_files (const gchar *dir, const gchar *filter,
                             gboolean silent, GtkWidget *progress,
                             GtkWidget *label1, GtkWidget *label2)
 {
-    GHashTable  *data;        /* hash table with fresh TLE data */
+    GPtrArray   *files;       /* the TLE files (tle_file_t) */
+    GThreadPool *pool;        /* workers parsing the files */
     GDir        *cache_dir;   /* directory to scan fresh TLE */
-    GDir        *loc_dir;     /* directory for gpredict TLE files */
+    GTimer      *timer;
     GError      *err = NULL;
     gchar       *text;
-    gchar       *ldname;
-    gchar       *userconfdir;
     const gchar *fnam;
-    guint        num = 0;
-    guint        updated,updated_tmp;
-    guint        skipped,skipped_tmp;
-    guint        nodata,nodata_tmp;
-    guint        newsats = 0;
-    guint        total,total_tmp;
-    gdouble      fraction = 0.0;
-    gdouble      start = 0.0;
+    gdouble      secs;
+    guint        num;
+    guint        i;
 
     if (g_static_mutex_trylock(&tle_file_in_progress)==FALSE) {
         sat_log_log (SAT_LOG_LEVEL_ERROR,
@@ -132,10 +198,6 @@ void tle_update_from_files (const gchar *dir, const gchar *filter,
         return;
     }
 
-    /* create hash table */
-    data = g_hash_table_new_full (g_int_hash, g_int_equal, g_free, free_new_tle);
-
-
     /* open directory and read files one by one */
     cache_dir = g_dir_open (dir, 0, &err);
 
@@ -161,336 +223,561 @@ void tle_update_from_files (const gchar *dir, const gchar *filter,
     }
     else {
 
+        timer = g_timer_new ();
+
         /* scan directory for tle files */
+        files = g_ptr_array_new ();
         while ((fnam = g_dir_read_name (cache_dir)) != NULL) {
-
-            /* check that we got a TLE file */
-            if (is_tle_file(dir, fnam)) {
-                
-                /* status message */
-                if (!silent && (label1 != NULL)) {
-                    text = g_strdup_printf (_("Reading data from %s"), fnam);
-                    gtk_label_set_text (GTK_LABEL (label1), text);
-                    g_free (text);
-    
-    
-                    /* Force the drawing queue to be processed otherwise there will
-                        not be any visual feedback, ie. frozen GUI
-                        - see Gtk+ FAQ http://www.gtk.org/faq/#AEN602
-                    */
-                    while (g_main_context_iteration (NULL, FALSE));
-    
-                    /* give user a chance to follow progress */
-                    g_usleep (G_USEC_PER_SEC / 100);
-                }
-    
-                /* now, do read the fresh data */
-                num = read_fresh_tle (dir, fnam, data);
-            }
-            
-            if (num < 1) {
-                sat_log_log (SAT_LOG_LEVEL_ERROR,
-                             _("%s: No valid TLE data found in %s"),
-                             __FUNCTION__, fnam);
-            }
-            else {
-                sat_log_log (SAT_LOG_LEVEL_MSG,
-                             _("%s: Read %d sats from %s into memory"),
-                             __FUNCTION__, num, fnam);
-            }
+            if (is_tle_file (dir, fnam))
+                g_ptr_array_add (files, tle_file_new (dir, fnam, files->len));
         }
 
         /* close directory since we don't need it anymore */
         g_dir_close (cache_dir);
 
-        /* now we load each .sat file and update if we have new data */
-        userconfdir = get_user_conf_dir ();
-        ldname = g_strconcat (userconfdir, G_DIR_SEPARATOR_S, "satdata", NULL);
-        g_free (userconfdir);
+        /* status message */
+        if (!silent && (label1 != NULL)) {
+            text = g_strdup_printf (_("Reading data from %d files"), files->len);
+            gtk_label_set_text (GTK_LABEL (label1), text);
+            g_free (text);
 
-        /* open directory and read files one by one */
-        loc_dir = g_dir_open (ldname, 0, &err);
+            /* Force the drawing queue to be processed otherwise there will
+                not be any visual feedback, ie. frozen GUI
+                - see Gtk+ FAQ http://www.gtk.org/faq/#AEN602
+            */
+            while (g_main_context_iteration (NULL, FALSE));
+        }
 
-        if (err != NULL) {
+        /* parse the files in parallel; freeing the pool waits for the workers */
+        pool = g_thread_pool_new (parse_tle_file, NULL,
+                                  MIN (prop_pool_num_threads (0), MAX (files->len, 1)),
+                                  TRUE, NULL);
+        for (i = 0; i < files->len; i++)
+            g_thread_pool_push (pool, g_ptr_array_index (files, i), NULL);
+        g_thread_pool_free (pool, FALSE, TRUE);
+
+        num = apply_tle_files (files, silent, progress, label1, label2);
+
+        secs = g_timer_elapsed (timer, NULL);
+        sat_log_log (SAT_LOG_LEVEL_MSG,
+                     _("%s: Processed %d TLE sets from %d files in %.3f s (%.0f objects/s)"),
+                     __FUNCTION__, num, files->len, secs,
+                     (secs > 0.0) ? num / secs : 0.0);
+
+        g_timer_destroy (timer);
+        g_ptr_array_foreach (files, (GFunc) tle_file_free, NULL);
+        g_ptr_array_free (files, TRUE);
+
+        sat_log_log (SAT_LOG_LEVEL_MSG,
+                     _("%s: TLE elements updated."),
+                     __FUNCTION__);
+    }
+
+    g_static_mutex_unlock(&tle_file_in_progress);
+}
 
-            /* send an error message */
-            sat_log_log (SAT_LOG_LEVEL_ERROR,
-                         _("%s: Error opening directory %s (%s)"),
-                         __FUNCTION__, dir, err->message);
 
-            /* insert error message into the status string, too */
-            if (!silent && (label1 != NULL)) {
-                text = g_strdup_printf (_("<b>ERROR</b> opening directory %s\n%s"),
-                                        dir, err->message);
 
-                gtk_label_set_markup (GTK_LABEL (label1), text);
-                g_free (text);
+/** \brief Apply parsed TLE files to the satellite catalogue.
+ *  \param files The parsed files (tle_file_t).
+ *  \param silent TRUE if function should execute without graphical status indicator.
+ *  \param progress Pointer to progress indicator.
+ *  \param label1 Activity label (can be NULL)
+ *  \param label2 Statistics label (can be NULL)
+ *  \return The number of valid TLE sets in the files.
+ *
+ * The first set of a satellite found in the files wins. The .cat file with
+ * the same name as a TLE file is synced with the satellites in it. Every
+ * satellite in the catalogue gets the fresh elements if they are newer,
+ * and new satellites are added if SAT_CFG_BOOL_TLE_ADD_NEW is set.
+ *
+ * The .sat files of the changed satellites are written without syncing
+ * each of them; the catalogue database is then written and synced once.
+ */
+static guint apply_tle_files (GPtrArray *files, gboolean silent,
+                              GtkWidget *progress,
+                              GtkWidget *label1, GtkWidget *label2)
+{
+    tle_upd_t       upd;
+    tle_file_t     *file;
+    new_tle_t      *ntle;
+    sat_db_entry_t  entry;
+    gchar          *text;
+    gchar          *ldname;
+    guint           total = 0;
+    guint           newsats = 0;
+    guint           num, i, j, idx;
+    gdouble         start = 0.0;
+
+
+    upd.data = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    for (i = 0; i < files->len; i++) {
+        file = g_ptr_array_index (files, i);
+        num = 0;
+
+        for (j = 0; j < file->parser.tles->len; j++) {
+            ntle = &g_array_index (file->parser.tles, new_tle_t, j);
+
+            if (g_hash_table_lookup (upd.data, GINT_TO_POINTER (ntle->tle.catnr)) == NULL) {
+                g_hash_table_insert (upd.data, GINT_TO_POINTER (ntle->tle.catnr), ntle);
+                num++;
             }
+        }
+        total += file->parser.tles->len;
 
-            g_clear_error (&err);
-            err = NULL;
+        if (file->parser.invalid > 0) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Skipped %d invalid TLE sets in %s"),
+                         __FUNCTION__, file->parser.invalid, file->fname);
+        }
+
+        if (file->failed) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Failed to open %s"),
+                         __FUNCTION__, file->fname);
+        }
+        else if (num < 1) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: No valid TLE data found in %s"),
+                         __FUNCTION__, file->fname);
         }
         else {
-            /* clear statistics */
-            updated = 0;
-            skipped = 0;
-            nodata = 0;
-            total = 0;
-
-            /* get initial value of progress indicator */
-            if (progress != NULL)
-                start = gtk_progress_bar_get_fraction (GTK_PROGRESS_BAR (progress));
-
-            /* This is insane but I don't know how else to count the number of sats */
-            num = 0;
-            while ((fnam = g_dir_read_name (loc_dir)) != NULL) {
-                /* only consider .sat files */
-                if (g_str_has_suffix (fnam, ".sat")) {
-                    num++;
-                }
-            }
+            sat_log_log (SAT_LOG_LEVEL_MSG,
+                         _("%s: Read %d sats from %s into memory"),
+                         __FUNCTION__, num, file->fname);
+        }
 
-            g_dir_rewind (loc_dir);
-
-            /* update TLE files one by one */
-            while ((fnam = g_dir_read_name (loc_dir)) != NULL) {
-                /* only consider .sat files */
-                if (g_str_has_suffix (fnam, ".sat")) {
-
-                    /* clear stat bufs */
-                    updated_tmp = 0;
-                    skipped_tmp = 0;
-                    nodata_tmp = 0;
-                    total_tmp = 0;
-                    
-
-                    /* update TLE data in this file */
-                    update_tle_in_file (ldname, fnam, data, 
-                                        &updated_tmp,
-                                        &skipped_tmp,
-                                        &nodata_tmp,
-                                        &total_tmp);
-
-                    /* update statistics */
-                    updated += updated_tmp;
-                    skipped += skipped_tmp;
-                    nodata  += nodata_tmp;
-                    total   = updated+skipped+nodata;
-
-                    if (!silent) {
-
-                        if (label1 != NULL) {
-                            gtk_label_set_text (GTK_LABEL (label1),
-                                                _("Updating data..."));
-                        }
-
-                        if (label2 != NULL) {
-                            text = g_strdup_printf (_("Satellites updated:\t %d\n"\
-                                                      "Satellites skipped:\t %d\n"\
-                                                      "Missing Satellites:\t %d\n"),
-                                                    updated, skipped, nodata);
-                            gtk_label_set_text (GTK_LABEL (label2), text);
-                            g_free (text);
-                        }
-
-                        if (progress != NULL) {
-
-                            /* calculate and saturate fraction
-                                (number of sats in TLE files is greater
-                                than the number of sats in link table)
-                            */
-                            fraction = start + (1.0-start) * ((gdouble) total) / ((gdouble) num);
-                            if (fraction >= 0.95)
-                                fraction = 0.98;
-                            
-                            gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (progress),
-                                                           fraction);
-
-                        }
-
-                        /* Force the drawing queue to be processed otherwise there will
-                            not be any visual feedback, ie. frozen GUI
-                            - see Gtk+ FAQ http://www.gtk.org/faq/#AEN602
-                        */
-                        while (g_main_context_iteration (NULL, FALSE));
-
-                        /* give user a chance to follow progress */
-                        g_usleep (G_USEC_PER_SEC / 1000);
-                    }
-                }
-            }
+        if (!file->failed)
+            sync_cat_file (file);
+    }
 
-            /* close directory handle */
-            g_dir_close (loc_dir);
-            
-            /* see if we have any new sats that need to be added */
-            if (sat_cfg_get_bool (SAT_CFG_BOOL_TLE_ADD_NEW)) {
-                
-                newsats = add_new_sats (data);
-                
-                if (!silent && (label2 != NULL)) {
-                    text = g_strdup_printf (_("Satellites updated:\t %d\n"\
-                                              "Satellites skipped:\t %d\n"\
-                                              "Missing Satellites:\t %d\n"\
-                                              "New Satellites:\t\t %d"),
-                                            updated, skipped, nodata, newsats);
-                    gtk_label_set_text (GTK_LABEL (label2), text);
-                    g_free (text);
+    /* the local satellites are read from the catalogue */
+    ldname = get_satdata_dir ();
 
-                }
-                
-                sat_log_log (SAT_LOG_LEVEL_MSG,
-                             _("%s: Added %d new satellites to local database"),
-                             __FUNCTION__, newsats);
-            }
+    if (!g_file_test (ldname, G_FILE_TEST_IS_DIR)) {
 
-            /* store time of update if we have updated something */
-            if ((updated > 0) || (newsats > 0)) {
-                GTimeVal tval;
-                
-                g_get_current_time (&tval);
-                sat_cfg_set_int (SAT_CFG_INT_TLE_LAST_UPDATE, tval.tv_sec);
-            }
+        /* send an error message */
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: Error opening directory %s"),
+                     __FUNCTION__, ldname);
+
+        /* insert error message into the status string, too */
+        if (!silent && (label1 != NULL)) {
+            text = g_strdup_printf (_("<b>ERROR</b> opening directory %s"),
+                                    ldname);
 
+            gtk_label_set_markup (GTK_LABEL (label1), text);
+            g_free (text);
         }
 
         g_free (ldname);
+        g_hash_table_destroy (upd.data);
 
-        sat_log_log (SAT_LOG_LEVEL_MSG,
-                     _("%s: TLE elements updated."),
-                     __FUNCTION__);
+        return total;
     }
+    g_free (ldname);
 
-    /* destroy hash tables */
-    g_hash_table_destroy (data);
+    if (!silent) {
+        if (label1 != NULL) {
+            gtk_label_set_text (GTK_LABEL (label1),
+                                _("Updating data..."));
+        }
 
-    g_static_mutex_unlock(&tle_file_in_progress);
-}
+        /* get initial value of progress indicator */
+        if (progress != NULL)
+            start = gtk_progress_bar_get_fraction (GTK_PROGRESS_BAR (progress));
 
+        while (g_main_context_iteration (NULL, FALSE));
+    }
 
+    upd.entries = g_array_new (FALSE, FALSE, sizeof (sat_db_entry_t));
+    upd.changed = g_array_new (FALSE, FALSE, sizeof (guint));
+    upd.strings = g_string_chunk_new (65536);
+    upd.updated = 0;
+    upd.skipped = 0;
+    upd.nodata = 0;
 
-/** \brief Check if satellite is new, if so, add it to local database */
-static void check_and_add_sat (gpointer key, gpointer value, gpointer user_data)
-{
-    new_tle_t  *ntle = (new_tle_t *) value;
-    guint      *num = user_data;
-    GKeyFile   *satdata;
-    GIOChannel *satfile;
-    gchar      *cfgstr, *cfgfile;
-    gsize       length, written;
-    GError     *err = NULL;
-    
+    /* update the local satellites */
+    sat_db_foreach (update_sat, &upd);
 
-    /* check if sat is new */
-    if (ntle->isnew) {
+    /* see if we have any new sats that need to be added */
+    if (sat_cfg_get_bool (SAT_CFG_BOOL_TLE_ADD_NEW)) {
 
-        /* create config data */
-        satdata = g_key_file_new ();
+        for (i = 0; i < files->len; i++) {
+            file = g_ptr_array_index (files, i);
 
-        /* store data */
-        g_key_file_set_string (satdata, "Satellite", "VERSION", "1.1");
-        g_key_file_set_string (satdata, "Satellite", "NAME", ntle->satname);
-        g_key_file_set_string (satdata, "Satellite", "NICKNAME", ntle->satname);
-        g_key_file_set_string (satdata, "Satellite", "TLE1", ntle->line1);
-        g_key_file_set_string (satdata, "Satellite", "TLE2", ntle->line2);
+            for (j = 0; j < file->parser.tles->len; j++) {
+                ntle = &g_array_index (file->parser.tles, new_tle_t, j);
 
-        /* convert data to text */
-        cfgstr = g_key_file_to_data (satdata, &length, NULL);
+                /* only the set that made it into the hash table */
+                if (!ntle->isnew ||
+                    (g_hash_table_lookup (upd.data, GINT_TO_POINTER (ntle->tle.catnr)) != ntle))
+                    continue;
 
-        /* create an I/O channel and store data */
-        cfgfile = sat_file_name_from_catnum (ntle->catnum);
-        satfile = g_io_channel_new_file (cfgfile, "w", &err);
+                ntle->isnew = FALSE;
 
-        if (err != NULL) {
-            sat_log_log (SAT_LOG_LEVEL_ERROR,
-                         _("%s: Could not create satellite file (%s)."),
-                         __FUNCTION__, err->message);
-            g_clear_error (&err);
-        }
-        else {
-            g_io_channel_write_chars (satfile, cfgstr, length, &written, &err);
-            g_io_channel_shutdown (satfile, TRUE, NULL);
-            g_io_channel_unref (satfile);
-
-            if (err != NULL) {
-                sat_log_log (SAT_LOG_LEVEL_ERROR,
-                             _("%s: Error writing satellite data for %d (%s)."),
-                             __FUNCTION__, ntle->catnum, err->message);
-                g_clear_error (&err);
+                entry.tle = ntle->tle;
+                entry.name = ntle->satname;
+                entry.nickname = ntle->satname;
+                entry.website = NULL;
+                entry.line1 = ntle->line1;
+                entry.line2 = ntle->line2;
+
+                idx = upd.entries->len;
+                g_array_append_val (upd.entries, entry);
+                g_array_append_val (upd.changed, idx);
+                newsats++;
+
+                sat_log_log (SAT_LOG_LEVEL_MSG,
+                             _("%s: Data for new sat %d successfully added."),
+                             __FUNCTION__, ntle->tle.catnr);
             }
-            else if (length != written) {
-                sat_log_log (SAT_LOG_LEVEL_WARN,
-                             _("%s: Wrote only %d out of %d chars for satellite data %d."),
-                             __FUNCTION__, written, length, ntle->catnum);
+        }
+
+        sat_log_log (SAT_LOG_LEVEL_MSG,
+                     _("%s: Added %d new satellites to local database"),
+                     __FUNCTION__, newsats);
+    }
+
+    /* keep the .sat files in sync, then write the catalogue once; this
+       also picks up the groups from the synced .cat files */
+    for (i = 0; i < upd.changed->len; i++) {
+        idx = g_array_index (upd.changed, guint, i);
+        sat_db_export_sat (&g_array_index (upd.entries, sat_db_entry_t, idx));
+    }
+
+    sat_db_write ((sat_db_entry_t *) upd.entries->data, upd.entries->len);
+
+    if (!silent) {
+
+        if (label2 != NULL) {
+            if (sat_cfg_get_bool (SAT_CFG_BOOL_TLE_ADD_NEW)) {
+                text = g_strdup_printf (_("Satellites updated:\t %d\n"\
+                                          "Satellites skipped:\t %d\n"\
+                                          "Missing Satellites:\t %d\n"\
+                                          "New Satellites:\t\t %d"),
+                                        upd.updated, upd.skipped, upd.nodata, newsats);
             }
             else {
-                sat_log_log (SAT_LOG_LEVEL_MSG,
-                             _("%s: Data for new sat %d successfully added."),
-                             __FUNCTION__, ntle->catnum);
-                *num += 1;
+                text = g_strdup_printf (_("Satellites updated:\t %d\n"\
+                                          "Satellites skipped:\t %d\n"\
+                                          "Missing Satellites:\t %d\n"),
+                                        upd.updated, upd.skipped, upd.nodata);
             }
+            gtk_label_set_text (GTK_LABEL (label2), text);
+            g_free (text);
         }
 
-        /* clean up memory */
-        g_free (cfgstr);
-        g_free (cfgfile);
-        g_key_file_free (satdata);
+        if (progress != NULL) {
+            gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (progress),
+                                           MAX (start, 0.98));
+        }
 
+        /* Force the drawing queue to be processed otherwise there will
+            not be any visual feedback, ie. frozen GUI
+            - see Gtk+ FAQ http://www.gtk.org/faq/#AEN602
+        */
+        while (g_main_context_iteration (NULL, FALSE));
+    }
 
-        /**** FIXME: NEED TO CREATE COPY of cache */
-        /* finally, new satellite must be added to proper category */
-        gchar *catfile;
-        gchar **buff;
+    /* store time of update if we have updated something */
+    if ((upd.updated > 0) || (newsats > 0)) {
+        GTimeVal tval;
 
-        buff = g_strsplit (ntle->srcfile, ".", 0);
-        cfgfile = g_strconcat (buff[0], ".cat", NULL);
-        catfile = sat_file_name (cfgfile);
+        g_get_current_time (&tval);
+        sat_cfg_set_int (SAT_CFG_INT_TLE_LAST_UPDATE, tval.tv_sec);
+    }
 
-        /* g_io_channel */
-        satfile = g_io_channel_new_file (catfile, "a", &err);
+    g_array_free (upd.entries, TRUE);
+    g_array_free (upd.changed, TRUE);
+    g_string_chunk_free (upd.strings);
+    g_hash_table_destroy (upd.data);
 
-        if (err != NULL) {
-            sat_log_log (SAT_LOG_LEVEL_ERROR,
-                         _("%s: Could not open category file file %s (%s)."),
-                         __FUNCTION__, cfgfile, err->message);
-            g_clear_error (&err);
+    return total;
+}
+
+
+/** \brief Update a local satellite with the fresh data.
+ *  \param entry The satellite in the catalogue.
+ *  \param data The tle_upd_t.
+ *
+ * This is the sat_db_foreach() callback of apply_tle_files(). It copies the
+ * satellite into the new catalogue, with the fresh elements if they are
+ * newer than the ones it has.
+ */
+static void update_sat (const sat_db_entry_t *entry, gpointer data)
+{
+    tle_upd_t      *upd = data;
+    new_tle_t      *ntle;
+    sat_db_entry_t  copy;
+    guint           idx;
+
+
+    copy.tle = entry->tle;
+    copy.name = g_string_chunk_insert (upd->strings, entry->name);
+    copy.nickname = g_string_chunk_insert (upd->strings, entry->nickname);
+    copy.website = entry->website ? g_string_chunk_insert (upd->strings, entry->website) : NULL;
+    copy.line1 = g_string_chunk_insert (upd->strings, entry->line1);
+    copy.line2 = g_string_chunk_insert (upd->strings, entry->line2);
+
+    ntle = g_hash_table_lookup (upd->data, GINT_TO_POINTER (entry->tle.catnr));
+
+    if (ntle == NULL) {
+        /* no new data found for this sat => obsolete */
+        upd->nodata++;
+
+        /* check if obsolete sats should be deleted */
+        /**** FIXME: This is dangereous, so we omit it */
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: No new TLE data found for %d. Satellite might be obsolete."),
+                     __FUNCTION__, entry->tle.catnr);
+    }
+    else {
+        /* This satellite is not new */
+        ntle->isnew = FALSE;
+
+        if (entry->tle.epoch < ntle->tle.epoch) {
+            /* new data is newer than what we already have */
+            copy.tle = ntle->tle;
+            copy.line1 = ntle->line1;
+            copy.line2 = ntle->line2;
+
+            idx = upd->entries->len;
+            g_array_append_val (upd->changed, idx);
+            upd->updated++;
         }
         else {
-            cfgstr = g_strdup_printf ("%d\n", ntle->catnum);
-            g_io_channel_write_chars (satfile, cfgstr, -1, NULL, &err);
-            g_io_channel_shutdown (satfile, TRUE, NULL);
-            g_io_channel_unref (satfile);
-            g_free (cfgstr);
-
-            if (err != NULL) {
-                sat_log_log (SAT_LOG_LEVEL_ERROR,
-                             _("%s: Error adding %d to %s (%s)."),
-                             __FUNCTION__, ntle->catnum, cfgfile, err->message);
-                g_clear_error (&err);
-            }
-            else {
-                sat_log_log (SAT_LOG_LEVEL_MSG,
-                             _("%s: Added satellite %d to %s."),
-                             __FUNCTION__, ntle->catnum, cfgfile);
-            }
+            upd->skipped++;
         }
+    }
+
+    g_array_append_val (upd->entries, copy);
+}
+
+
+/** \brief Create a TLE file to be ingested.
+ *  \param dir The directory.
+ *  \param fnam The file name.
+ *  \param index The index of the file.
+ */
+static tle_file_t *tle_file_new (const gchar *dir, const gchar *fnam, guint index)
+{
+    tle_file_t *file;
+
+
+    file = g_new0 (tle_file_t, 1);
+    file->fname = g_strdup (fnam);
+    file->path = g_strconcat (dir, G_DIR_SEPARATOR_S, fnam, NULL);
+    tle_parser_init (&file->parser, index);
+
+    return file;
+}
+
+
+/** \brief Free a TLE file. */
+static void tle_file_free (tle_file_t *file)
+{
+    g_array_free (file->parser.tles, TRUE);
+    g_free (file->fname);
+    g_free (file->path);
+    g_free (file);
+}
+
+
+/** \brief Parse a TLE file.
+ *  \param data The tle_file_t.
+ *  \param user_data Not used.
+ *
+ * This runs in the worker threads of tle_update_from_files(), so it only
+ * touches its own file and leaves logging to the caller.
+ */
+static void parse_tle_file (gpointer data, gpointer user_data)
+{
+    tle_file_t  *file = data;
+    GMappedFile *map;
+
+
+    map = g_mapped_file_new (file->path, FALSE, NULL);
+
+    if (map == NULL) {
+        file->failed = TRUE;
+        return;
+    }
+
+    tle_parser_feed (&file->parser, g_mapped_file_get_contents (map),
+                     g_mapped_file_get_length (map));
+    tle_parser_finish (&file->parser);
+
+    g_mapped_file_unref (map);
+}
+
+
+/** \brief Sync the .cat file with the same name as a TLE file.
+ *
+ * The category name in the first line is kept, the rest of the .cat file
+ * is replaced by the catalogue numbers of the valid sets in the TLE file.
+ */
+static void sync_cat_file (tle_file_t *file)
+{
+    new_tle_t  *ntle;
+    GString    *str;
+    FILE       *catfile;
+    gchar     **buffv;
+    gchar      *catname, *catpath, *contents, *eol;
+    guint       i;
+
+
+    buffv = g_strsplit (file->fname, ".", 0);
+    catname = g_strconcat (buffv[0], ".cat", NULL);
+    g_strfreev (buffv);
+    catpath = sat_file_name (catname);
+    g_free (catname);
+
+    /* read category name for catfile */
+    if (!g_file_get_contents (catpath, &contents, NULL, NULL)) {
+        /* There is no category with this name (could be update from custom file) */
+        sat_log_log (SAT_LOG_LEVEL_MSG,
+                     _("%s:%s: There is no category called %s"),
+                     __FILE__, __FUNCTION__, file->fname);
+        g_free (catpath);
+        return;
+    }
 
-        g_free (catfile);
-        g_free (cfgfile);
-        g_strfreev (buff);
+    eol = strchr (contents, '\n');
+    if (eol != NULL)
+        *eol = '\0';
+
+    str = g_string_new (contents);
+    g_string_append_c (str, '\n');
+    g_free (contents);
+
+    for (i = 0; i < file->parser.tles->len; i++) {
+        ntle = &g_array_index (file->parser.tles, new_tle_t, i);
+        g_string_append_printf (str, "%d\n", ntle->tle.catnr);
     }
 
+    catfile = g_fopen (catpath, "w");
+
+    if ((catfile == NULL) ||
+        (fwrite (str->str, 1, str->len, catfile) != str->len)) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s:%s: Could not rewrite .cat file while reading TLE from %s"),
+                     __FILE__, __FUNCTION__, file->fname);
+    }
+
+    if (catfile != NULL)
+        fclose (catfile);
+
+    g_string_free (str, TRUE);
+    g_free (catpath);
 }
 
 
-/** \brief Add new satellites to local database */
-static guint add_new_sats (GHashTable *data)
+/** \brief Initialise a TLE parser.
+ *  \param parser The parser.
+ *  \param srcfile The index of the source file, stored in the sets.
+ */
+static void tle_parser_init (tle_parser_t *parser, guint srcfile)
+{
+    memset (parser, 0, sizeof (tle_parser_t));
+    parser->tles = g_array_new (FALSE, FALSE, sizeof (new_tle_t));
+    parser->srcfile = srcfile;
+}
+
+
+/** \brief Feed TLE data to a parser.
+ *  \param parser The parser.
+ *  \param data The data.
+ *  \param len The number of bytes in data.
+ *
+ * Lines longer than 79 characters are truncated.
+ */
+static void tle_parser_feed (tle_parser_t *parser, const gchar *data, gsize len)
 {
-    guint num = 0;
+    const gchar *end = data + len;
+    const gchar *eol;
+    gsize        n;
 
-    g_hash_table_foreach (data, check_and_add_sat, &num);
 
-    return num;
+    while (data < end) {
+        eol = memchr (data, '\n', end - data);
+        n = ((eol != NULL) ? eol : end) - data;
+
+        /* append to the line being assembled */
+        n = MIN (n, 79 - parser->len);
+        memcpy (parser->lines[parser->nlines] + parser->len, data, n);
+        parser->len += n;
+
+        /* the line continues in the next chunk */
+        if (eol == NULL)
+            break;
+
+        tle_parser_end_line (parser);
+        data = eol + 1;
+    }
+}
+
+
+/** \brief Parse the last line if it has no line break. */
+static void tle_parser_finish (tle_parser_t *parser)
+{
+    if (parser->len > 0)
+        tle_parser_end_line (parser);
+
+    /* incomplete set at the end */
+    if (parser->nlines > 0) {
+        parser->invalid++;
+        parser->nlines = 0;
+    }
+}
+
+
+/** \brief Complete the line being assembled. */
+static void tle_parser_end_line (tle_parser_t *parser)
+{
+    gchar *line = parser->lines[parser->nlines];
+
+
+    line[parser->len] = '\0';
+    parser->len = 0;
+
+    /* removes trailing CR and blanks */
+    g_strchomp (line);
+
+    /* skip empty lines between sets */
+    if ((parser->nlines == 0) && (line[0] == '\0'))
+        return;
+
+    if (++parser->nlines == 3) {
+        tle_parser_add_set (parser);
+        parser->nlines = 0;
+    }
+}
+
+
+/** \brief Check the current set and add it to the array if it is valid. */
+static void tle_parser_add_set (tle_parser_t *parser)
+{
+    new_tle_t ntle;
+
+
+    parser->lines[1][69] = '\0';
+    parser->lines[2][69] = '\0';
+
+    if (Get_Next_Tle_Set (parser->lines, &ntle.tle) != 1) {
+        /* TLE data not good */
+        parser->invalid++;
+        return;
+    }
+
+    g_strlcpy (ntle.satname, parser->lines[0], sizeof (ntle.satname));
+    g_strlcpy (ntle.line1, parser->lines[1], sizeof (ntle.line1));
+    g_strlcpy (ntle.line2, parser->lines[2], sizeof (ntle.line2));
+    ntle.srcfile = parser->srcfile;
+    ntle.isnew = TRUE; /* flag will be reset when using data */
+
+    g_array_append_val (parser->tles, ntle);
 }
 
 
@@ -500,31 +787,51 @@ static guint add_new_sats (GHashTable *data)
  *  \param progress Pointer to a GtkProgressBar progress indicator (can be NULL)
  *  \param label1 GtkLabel for activity string.
  *  \param label2 GtkLabel for statistics string.
+ *
+ * All files are fetched concurrently using a curl multi handle. Each
+ * response is parsed while it is received and stored in the cache
+ * directory, USER_CONF_DIR/satdata/cache, which is kept between updates
+ * together with the ETag and modification time of each file. A file that
+ * is already in the cache is only fetched if it has changed, so an update
+ * where nothing has changed costs one "304 Not Modified" per file.
+ * Files that have not changed or could not be fetched are read from the
+ * cache.
+ *
+ * The server is SAT_CFG_STR_TLE_SERVER, so the update can be tried offline
+ * by pointing it to a local web server serving a copy of the files.
  */
 void tle_update_from_network (gboolean   silent,
                               GtkWidget *progress,
                               GtkWidget *label1,
                               GtkWidget *label2)
 {
-    gchar       *server;
-    gchar       *proxy = NULL;
-    gchar       *files_tmp;
-    gchar      **files;
-    guint        numfiles,i;
-    gchar       *curfile;
-    gchar       *locfile;
-    gchar       *userconfdir;
-    CURL        *curl;
-    CURLcode     res;
-    gboolean     error = FALSE;
-    gdouble      fraction,start=0;
-    FILE        *outfile;
-    GDir        *dir;
-    gchar       *cache;
-    const gchar *fname;
-    gchar       *text;
-    GError      *err = NULL;
-    guint        success = 0; /* no. of successfull downloads */ 
+    gchar         *server;
+    gchar         *proxy = NULL;
+    gchar         *files_tmp;
+    gchar        **files;
+    guint          numfiles,i;
+    gchar         *cache;
+    gchar         *infofile;
+    GKeyFile      *info;
+    GKeyFile      *newinfo;
+    GPtrArray     *sources;
+    GPtrArray     *tlefiles;
+    tle_source_t  *src;
+    GThreadPool   *pool;
+    CURLM         *multi;
+    CURLMsg       *msg;
+    GTimer        *timer;
+    gint           running, left;
+    gdouble        fraction,start=0;
+    gchar         *text;
+    gchar         *data;
+    gsize          length;
+    guint          success = 0; /* no. of successfull downloads */
+    guint          changed = 0; /* no. of files that have changed */
+    guint          done = 0;
+    guint          num;
+    gdouble        secs;
+    gboolean       applied = FALSE; /* fetched files have been applied */
 
     /* bail out if we are already in an update process */
     /*if (tle_in_progress)*/
@@ -563,516 +870,551 @@ void tle_update_from_network (gboolean   silent,
         if (!silent && (progress != NULL))
             start = gtk_progress_bar_get_fraction (GTK_PROGRESS_BAR (progress));
 
-        /* initialise curl */
-        curl = curl_easy_init();
-        if (proxy != NULL)
-            curl_easy_setopt (curl, CURLOPT_PROXY, proxy);
+        /* set activity message */
+        if (!silent && (label1 != NULL)) {
 
-        curl_easy_setopt (curl, CURLOPT_USERAGENT, "gpredict/curl");
-        curl_easy_setopt (curl, CURLOPT_CONNECTTIMEOUT, 10);
+            text = g_strdup_printf (_("Fetching %d files"), numfiles);
+            gtk_label_set_text (GTK_LABEL (label1), text);
+            g_free (text);
 
-        /* get files */
-        for (i = 0; i < numfiles; i++) {
+            /* Force the drawing queue to be processed otherwise there will
+                not be any visual feedback, ie. frozen GUI
+                - see Gtk+ FAQ http://www.gtk.org/faq/#AEN602
+            */
+            while (g_main_context_iteration (NULL, FALSE));
+        }
 
-            /* set URL */
-            curfile = g_strconcat (server, files[i], NULL);
-            curl_easy_setopt (curl, CURLOPT_URL, curfile);
+        timer = g_timer_new ();
 
-            /* set activity message */
-            if (!silent && (label1 != NULL)) {
+        /* validators of the cached files */
+        cache = sat_file_name ("cache");
+        infofile = g_strconcat (cache, G_DIR_SEPARATOR_S, TLE_CACHE_INFO, NULL);
+        info = g_key_file_new ();
+        g_key_file_load_from_file (info, infofile, G_KEY_FILE_NONE, NULL);
+        newinfo = g_key_file_new ();
 
-                text = g_strdup_printf (_("Fetching %s"), files[i]);
-                gtk_label_set_text (GTK_LABEL (label1), text);
-                g_free (text);
+        /* start all transfers */
+        multi = curl_multi_init ();
+        sources = g_ptr_array_new ();
+        tlefiles = g_ptr_array_new ();
 
-                /* Force the drawing queue to be processed otherwise there will
-                    not be any visual feedback, ie. frozen GUI
-                    - see Gtk+ FAQ http://www.gtk.org/faq/#AEN602
-                */
-                while (g_main_context_iteration (NULL, FALSE));
-            }
+        for (i = 0; i < numfiles; i++) {
+            src = tle_source_new (server, cache, files[i], i, proxy, info);
+            g_ptr_array_add (sources, src);
+            g_ptr_array_add (tlefiles, src->file);
+            curl_multi_add_handle (multi, src->curl);
+        }
 
-            /* create local cache file */
-            userconfdir = get_user_conf_dir ();
-            locfile = g_strconcat (userconfdir, G_DIR_SEPARATOR_S,
-                                   "satdata", G_DIR_SEPARATOR_S,
-                                   "cache", G_DIR_SEPARATOR_S,
-                                   files[i], NULL);
-            outfile = g_fopen (locfile, "wb");
-            curl_easy_setopt (curl, CURLOPT_WRITEDATA, outfile);
-            curl_easy_setopt (curl, CURLOPT_WRITEFUNCTION, my_write_func);
-
-            /* get file */
-            res = curl_easy_perform (curl);
-
-            if (res != CURLE_OK) {
-                sat_log_log (SAT_LOG_LEVEL_ERROR,
-                             _("%s: Error fetching %s (%s)"),
-                             __FUNCTION__, curfile, curl_easy_strerror (res));
-                error = TRUE;
-            }
-            else {
-                sat_log_log (SAT_LOG_LEVEL_MSG,
-                             _("%s: Successfully fetched %s"),
-                             __FUNCTION__, curfile);
-                success++;
-            }
+        /* run the transfers until all of them are done */
+        do {
+            while (curl_multi_perform (multi, &running) == CURLM_CALL_MULTI_PERFORM);
+
+            while ((msg = curl_multi_info_read (multi, &left)) != NULL) {
+                if (msg->msg != CURLMSG_DONE)
+                    continue;
+
+                curl_easy_getinfo (msg->easy_handle, CURLINFO_PRIVATE, (char **) &src);
+                curl_multi_remove_handle (multi, src->curl);
+
+                switch (tle_source_done (src, msg->data.result)) {
+                case TLE_SOURCE_CHANGED:
+                    changed++;
+                    /* fall through */
+                case TLE_SOURCE_UNCHANGED:
+                    success++;
+                    break;
+                default:
+                    break;
+                }
+                done++;
+
+                /* update progress indicator */
+                if (!silent && (progress != NULL)) {
 
-            /* update progress indicator */
-            if (!silent && (progress != NULL)) {
+                    /* complete download corresponds to 50% */
+                    fraction = start + (0.5-start) * done / numfiles;
+                    gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (progress), fraction);
+                }
+            }
 
-                /* complete download corresponds to 50% */
-                fraction = start + (0.5-start) * i / (2.0 * numfiles);
-                gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (progress), fraction);
+            if (running > 0)
+                wait_multi (multi);
 
-                /* Force the drawing queue to be processed otherwise there will
-                    not be any visual feedback, ie. frozen GUI
-                    - see Gtk+ FAQ http://www.gtk.org/faq/#AEN602
-                */
+            /* Force the drawing queue to be processed otherwise there will
+                not be any visual feedback, ie. frozen GUI
+                - see Gtk+ FAQ http://www.gtk.org/faq/#AEN602
+            */
+            if (!silent)
                 while (g_main_context_iteration (NULL, FALSE));
 
-            }
+        } while (running > 0);
 
-            g_free (userconfdir);
-            g_free (curfile);
-            g_free (locfile);
-            fclose (outfile);
-        }
+        curl_multi_cleanup (multi);
 
-        curl_easy_cleanup (curl);
+        prune_cache (cache, files);
 
         /* continue update if we have fetched at least one file */
-        if (success > 0) {
+        if (success == 0) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Could not fetch any new TLE files from network; aborting..."),
+                         __FUNCTION__);
+        }
+        else if ((changed == 0) && (success < numfiles)) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Could not fetch %d of %d TLE files; TLE data not updated."),
+                         __FUNCTION__, numfiles - success, numfiles);
+
+            if (!silent && (label1 != NULL)) {
+                gtk_label_set_text (GTK_LABEL (label1),
+                                    _("Could not fetch all TLE files"));
+            }
+        }
+        else if (changed == 0) {
+            GTimeVal tval;
+
             sat_log_log (SAT_LOG_LEVEL_MSG,
-                         _("%s: Fetched %d files from network; updating..."),
-                         __FUNCTION__, success);
-            /* call update_from_files */
-            cache = sat_file_name ("cache");
-            tle_update_from_files (cache, NULL, silent, progress, label1, label2);
-            g_free (cache);
+                         _("%s: TLE files on the network have not changed."),
+                         __FUNCTION__);
+
+            if (!silent && (label1 != NULL)) {
+                gtk_label_set_text (GTK_LABEL (label1),
+                                    _("TLE data is up to date"));
+            }
 
+            /* the local data is as fresh as it gets */
+            g_get_current_time (&tval);
+            sat_cfg_set_int (SAT_CFG_INT_TLE_LAST_UPDATE, tval.tv_sec);
         }
-        else {
+        else if (g_static_mutex_trylock (&tle_file_in_progress) == FALSE) {
             sat_log_log (SAT_LOG_LEVEL_ERROR,
-                         _("%s: Could not fetch any new TLE files from network; aborting..."),
+                         _("%s: A TLE update process is already running. Aborting."),
                          __FUNCTION__);
         }
+        else {
+            sat_log_log (SAT_LOG_LEVEL_MSG,
+                         _("%s: Fetched %d files from network (%d changed); updating..."),
+                         __FUNCTION__, success, changed);
+
+            /* the files that were not fetched are read from the cache */
+            pool = g_thread_pool_new (parse_tle_file, NULL,
+                                      MIN (prop_pool_num_threads (0), numfiles),
+                                      TRUE, NULL);
+            for (i = 0; i < sources->len; i++) {
+                src = g_ptr_array_index (sources, i);
+                if (!src->fetched)
+                    g_thread_pool_push (pool, src->file, NULL);
+            }
+            g_thread_pool_free (pool, FALSE, TRUE);
+
+            num = apply_tle_files (tlefiles, silent, progress, label1, label2);
+            applied = TRUE;
+
+            secs = g_timer_elapsed (timer, NULL);
+            sat_log_log (SAT_LOG_LEVEL_MSG,
+                         _("%s: Processed %d TLE sets from %d files in %.3f s (%.0f objects/s)"),
+                         __FUNCTION__, num, numfiles, secs,
+                         (secs > 0.0) ? num / secs : 0.0);
+
+            g_static_mutex_unlock (&tle_file_in_progress);
+        }
 
+        /* store the validators of the files we have in the cache */
+        for (i = 0; i < sources->len; i++)
+            tle_source_save_info (g_ptr_array_index (sources, i),
+                                  info, newinfo, applied);
+
+        data = g_key_file_to_data (newinfo, &length, NULL);
+        g_file_set_contents (infofile, data, length, NULL);
+        g_free (data);
+
+        g_ptr_array_foreach (sources, (GFunc) tle_source_free, NULL);
+        g_ptr_array_free (sources, TRUE);
+        g_ptr_array_free (tlefiles, TRUE);
+        g_key_file_free (newinfo);
+        g_key_file_free (info);
+        g_free (infofile);
+        g_free (cache);
+        g_timer_destroy (timer);
     }
 
-    /* clear cache and memory */
+    /* clear memory */
     g_free (server);
     g_strfreev (files);
     g_free (files_tmp);
     if (proxy != NULL)
         g_free (proxy);
 
-    /* open cache */
-    cache = sat_file_name ("cache");
-    dir = g_dir_open (cache, 0, &err);
+    /* clear busy flag */
+    /* tle_in_progress = FALSE; */
+    g_static_mutex_unlock(&tle_in_progress);
 
-    if (err != NULL) {
-        /* send an error message */
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s: Error opening %s (%s)"),
-                     __FUNCTION__, dir, err->message);
-        g_clear_error (&err);
-    }
-    else {
-        /* delete files in cache one by one */
-        while ((fname = g_dir_read_name (dir)) != NULL) {
+}
 
-            locfile = g_strconcat (cache, G_DIR_SEPARATOR_S,
-                                   fname, NULL);
 
-            g_remove (locfile);
-            g_free (locfile);
+/** \brief Create a TLE source and its transfer.
+ *  \param server The server URL.
+ *  \param cache The cache directory.
+ *  \param fname The file name.
+ *  \param index The index of the file.
+ *  \param proxy The proxy or NULL.
+ *  \param info The validators of the cached files.
+ *
+ * If the file is in the cache, the transfer is made conditional on the
+ * ETag and modification time recorded for it.
+ */
+static tle_source_t *tle_source_new (const gchar *server, const gchar *cache,
+                                     const gchar *fname, guint index,
+                                     const gchar *proxy, GKeyFile *info)
+{
+    tle_source_t *src;
+    gchar        *etag;
+    gchar        *header;
+
+
+    src = g_new0 (tle_source_t, 1);
+    src->file = tle_file_new (cache, fname, index);
+    src->url = g_strconcat (server, fname, NULL);
+    src->tmppath = g_strconcat (src->file->path, ".part", NULL);
+
+    src->curl = curl_easy_init ();
+    curl_easy_setopt (src->curl, CURLOPT_URL, src->url);
+    if (proxy != NULL)
+        curl_easy_setopt (src->curl, CURLOPT_PROXY, proxy);
+
+    curl_easy_setopt (src->curl, CURLOPT_USERAGENT, "gpredict/curl");
+    curl_easy_setopt (src->curl, CURLOPT_CONNECTTIMEOUT, 10);
+    curl_easy_setopt (src->curl, CURLOPT_PRIVATE, src);
+    curl_easy_setopt (src->curl, CURLOPT_WRITEFUNCTION, tle_source_write);
+    curl_easy_setopt (src->curl, CURLOPT_WRITEDATA, src);
+    curl_easy_setopt (src->curl, CURLOPT_HEADERFUNCTION, tle_source_header);
+    curl_easy_setopt (src->curl, CURLOPT_HEADERDATA, src);
+    curl_easy_setopt (src->curl, CURLOPT_FILETIME, 1L);
+
+    /* conditional request if we have the file */
+    if (g_file_test (src->file->path, G_FILE_TEST_IS_REGULAR)) {
+
+        etag = g_key_file_get_string (info, fname, "ETAG", NULL);
+        if (etag != NULL) {
+            header = g_strconcat ("If-None-Match: ", etag, NULL);
+            src->headers = curl_slist_append (NULL, header);
+            curl_easy_setopt (src->curl, CURLOPT_HTTPHEADER, src->headers);
+            g_free (header);
+            src->etag = etag;
+        }
+
+        src->filetime = g_key_file_get_integer (info, fname, "MTIME", NULL);
+        if (src->filetime > 0) {
+            curl_easy_setopt (src->curl, CURLOPT_TIMECONDITION, CURL_TIMECOND_IFMODSINCE);
+            curl_easy_setopt (src->curl, CURLOPT_TIMEVALUE, (long) src->filetime);
         }
-        /* close cache */
-        g_dir_close (dir);
     }
 
-    g_free (cache);
+    return src;
+}
 
-    /* clear busy flag */
-    /* tle_in_progress = FALSE; */
-    g_static_mutex_unlock(&tle_in_progress);
 
+/** \brief Free a TLE source. */
+static void tle_source_free (tle_source_t *src)
+{
+    if (src->out != NULL) {
+        fclose (src->out);
+        g_remove (src->tmppath);
+    }
+
+    curl_easy_cleanup (src->curl);
+    curl_slist_free_all (src->headers);
+    tle_file_free (src->file);
+    g_free (src->url);
+    g_free (src->tmppath);
+    g_free (src->etag);
+    g_free (src->newetag);
+    g_free (src);
 }
 
 
-/** \brief Write TLE data block to file.
- *  \param ptr Pointer to the data block to be written.
+/** \brief Receive a block of TLE data.
+ *  \param ptr Pointer to the data block.
  *  \param size Size of data block.
- *  \param nmemb Size multiplier?
- *  \param stream Pointer to the file handle.
- *  \return The number of bytes actually written.
+ *  \param nmemb Size multiplier.
+ *  \param data Pointer to the tle_source_t.
+ *  \return The number of bytes handled.
  *
- * This function writes the received data to the file pointed to by stream.
- * It is used as write callback by to curl exec function.
+ * The data is parsed and written to a temporary file in the cache. The body
+ * of an error response is ignored.
  */
-static size_t my_write_func (void *ptr, size_t size, size_t nmemb, FILE *stream)
+static size_t tle_source_write (void *ptr, size_t size, size_t nmemb, void *data)
 {
-    /*** FIXME: TBC whether this works in wintendo */
-    return fwrite (ptr, size, nmemb, stream);
-}
+    tle_source_t *src = data;
+    long          code = 0;
+    size_t        len = size * nmemb;
 
 
-/** \brief Check whether file is TLE file.
- *  \param dir The directory.
- *  \param fnam The file name.
- * 
- * This function checks whether the file with path dir/fnam is a potential
- * TLE file. Checks performed:
- *   - It is a real file
- *   - suffix is .txt or .tle
- */
-static gboolean is_tle_file (const gchar *dir, const gchar *fnam)
-{
-    gchar    *path;
-    gchar    *fname_lower;
-    gboolean  fileIsOk = FALSE;
-    
-    path = g_strconcat (dir, G_DIR_SEPARATOR_S, fnam, NULL);
-    fname_lower=g_ascii_strdown(fnam,-1);
-    
-    if (g_file_test (path, G_FILE_TEST_IS_REGULAR) && 
-        (g_str_has_suffix(fname_lower, ".tle") || g_str_has_suffix(fname_lower, ".txt")))
-    {
-        fileIsOk = TRUE;      
+    curl_easy_getinfo (src->curl, CURLINFO_RESPONSE_CODE, &code);
+    if ((code != 0) && ((code < 200) || (code > 299)))
+        return len;
+
+    if (src->out == NULL) {
+        src->out = g_fopen (src->tmppath, "wb");
+        if (src->out == NULL)
+            return 0;
     }
-    g_free (fname_lower);
-    g_free (path);
-    
-    return fileIsOk;
+
+    if (fwrite (ptr, 1, len, src->out) != len)
+        return 0;
+
+    tle_parser_feed (&src->file->parser, ptr, len);
+
+    return len;
 }
 
 
-/** \brief Read fresh TLE data into hash table.
- *  \param dir The directory to read from.
- *  \param fnam The name of the file to read from.
- *  \param fresh_data Hash table where the data should be stored.
- *  \return The number of satellites successfully read.
- * 
- * This function will read fresh TLE data from local files into memory.
- * If there is a saetllite category (.cat file) with the same name as the
- * input file it will also update the satellites in that category.
+/** \brief Pick the ETag from the response headers.
+ *
+ * The ETag of an earlier response in a redirect chain is dropped when the
+ * next status line arrives.
  */
-static gint read_fresh_tle (const gchar *dir, const gchar *fnam, GHashTable *data)
+static size_t tle_source_header (void *ptr, size_t size, size_t nmemb, void *data)
 {
-    new_tle_t *ntle;
-    tle_t      tle;
-    gchar     *path;
-    gchar      tle_str[3][80];
-    gchar      catstr[6];
-    gchar     *b;
-    FILE      *fp;
-    gint       retcode = 0;
-    guint      catnr,i;
-    guint     *key = NULL;
+    tle_source_t *src = data;
+    size_t        len = size * nmemb;
+    gchar        *line = ptr;
 
-    /* category sync related */
-    gchar     *catname, *catpath, *buff, **buffv;
-    FILE      *catfile;
-    gchar      category[80];
-    gboolean   catsync = FALSE; /* whether .cat file should be synced */
 
+    if ((len > 5) && (g_ascii_strncasecmp (line, "HTTP/", 5) == 0)) {
+        g_free (src->newetag);
+        src->newetag = NULL;
+    }
+    else if ((len > 5) && (g_ascii_strncasecmp (line, "ETag:", 5) == 0)) {
+        g_free (src->newetag);
+        src->newetag = g_strstrip (g_strndup (line + 5, len - 5));
+    }
 
+    return len;
+}
 
-    path = g_strconcat (dir, G_DIR_SEPARATOR_S, fnam, NULL);
 
-    fp = g_fopen (path, "r");
+/** \brief Complete the transfer of a TLE source.
+ *  \param src The source.
+ *  \param res The result of the transfer.
+ *
+ * A received file replaces the cached one. Otherwise the cached file, if
+ * any, will be read instead.
+ */
+static tle_source_state_t tle_source_done (tle_source_t *src, CURLcode res)
+{
+    tle_source_state_t  state;
+    long                code = 0;
+    long                filetime = -1;
+
 
-    if (fp != NULL) {
+    curl_easy_getinfo (src->curl, CURLINFO_RESPONSE_CODE, &code);
 
-        /* Prepare .cat file for sync while we read data */
-        buffv = g_strsplit (fnam, ".", 0);
-        catname = g_strconcat (buffv[0], ".cat", NULL);
-        g_strfreev (buffv);
-        catpath = sat_file_name (catname);
-        g_free (catname);
+    if (src->out != NULL) {
+        if (fclose (src->out) != 0)
+            res = CURLE_WRITE_ERROR;
+        src->out = NULL;
+    }
 
-        /* read category name for catfile */
-        catfile = g_fopen (catpath, "r");
-        if (catfile!=NULL) {
-            b = fgets (category, 80, catfile);
-            fclose (catfile);
-            catsync = TRUE;
+    if ((res != CURLE_OK) || (code >= 400)) {
+        if (res != CURLE_OK) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Error fetching %s (%s)"),
+                         __FUNCTION__, src->url, curl_easy_strerror (res));
         }
         else {
-            /* There is no category with this name (could be update from custom file) */
-            sat_log_log (SAT_LOG_LEVEL_MSG,
-                         _("%s:%s: There is no category called %s"),
-                         __FILE__, __FUNCTION__, fnam);
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Error fetching %s (HTTP %ld)"),
+                         __FUNCTION__, src->url, code);
         }
+        state = TLE_SOURCE_FAILED;
+    }
+    else if (g_file_test (src->tmppath, G_FILE_TEST_EXISTS)) {
+        tle_parser_finish (&src->file->parser);
 
-        /* reopen a new catfile and write category name */
-        if (catsync) {
-            catfile = g_fopen (catpath, "w");
-            if (catfile != NULL) {
-                fputs (category, catfile);
-            }
-            else {
-                catsync = FALSE;
-                sat_log_log (SAT_LOG_LEVEL_ERROR,
-                             _("%s:%s: Could not reopen .cat file while reading TLE from %s"),
-                             __FILE__, __FUNCTION__, fnam);
-            }
-            
-            /* .cat file now contains the category name;
-               satellite catnums will be added during update in the while loop */
+#ifdef G_OS_WIN32
+        g_remove (src->file->path);
+#endif
+        if (g_rename (src->tmppath, src->file->path) == 0) {
+            sat_log_log (SAT_LOG_LEVEL_MSG,
+                         _("%s: Successfully fetched %s"),
+                         __FUNCTION__, src->url);
+
+            src->fetched = TRUE;
+            g_free (src->etag);
+            src->etag = src->newetag;
+            src->newetag = NULL;
+            curl_easy_getinfo (src->curl, CURLINFO_FILETIME, &filetime);
+            src->filetime = (filetime > 0) ? filetime : 0;
+            state = TLE_SOURCE_CHANGED;
+        }
+        else {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Could not write %s"),
+                         __FUNCTION__, src->file->path);
+            state = TLE_SOURCE_FAILED;
         }
-        
+    }
+    else {
+        /* 304 Not Modified or condition not met */
+        sat_log_log (SAT_LOG_LEVEL_MSG,
+                     _("%s: %s has not changed"),
+                     __FUNCTION__, src->url);
+        state = TLE_SOURCE_UNCHANGED;
+    }
 
-        /* read 3 lines at a time */
-        while (fgets (tle_str[0], 80, fp)) {
-            /* read second and third lines */
-            b = fgets (tle_str[1], 80, fp);
-            b = fgets (tle_str[2], 80, fp);
+    if (!src->fetched) {
+        g_remove (src->tmppath);
 
-            tle_str[1][69] = '\0';
-            tle_str[2][69] = '\0';
+        /* drop what we may have parsed from a broken transfer */
+        g_array_set_size (src->file->parser.tles, 0);
+        src->file->parser.invalid = 0;
+        src->file->parser.nlines = 0;
+        src->file->parser.len = 0;
+    }
 
-            /* copy catnum and convert to integer */
-            for (i = 2; i < 7; i++) {
-                catstr[i-2] = tle_str[1][i];
-            }
-            catstr[5] = '\0';
-            catnr = (guint) g_ascii_strtod (catstr, NULL);
+    return state;
+}
 
 
-            if (Get_Next_Tle_Set (tle_str, &tle) != 1) {
-                /* TLE data not good */
-                sat_log_log (SAT_LOG_LEVEL_ERROR,
-                             _("%s:%s: Invalid data for %d"),
-                             __FILE__, __FUNCTION__, catnr);
-            }
-            else {
+/** \brief Record the validators of a cached TLE file.
+ *  \param src The source.
+ *  \param info The validators recorded by the previous update.
+ *  \param newinfo Key file receiving the validators of the cached file.
+ *  \param applied Whether the fetched files have been applied to the
+ *                 local satellites.
+ *
+ * The validators of a fetched file are only recorded once its data has been
+ * applied. Otherwise the old ones are kept, so that the next update fetches
+ * the file again instead of getting "304 Not Modified" for data that has
+ * never been used.
+ */
+static void tle_source_save_info (tle_source_t *src, GKeyFile *info,
+                                  GKeyFile *newinfo, gboolean applied)
+{
+    const gchar *fname = src->file->fname;
+    gchar       *etag;
+    gint         mtime;
 
-                if (catsync) {
-                    /* store catalog number in catfile */
-                    buff = g_strdup_printf ("%d\n", catnr);
-                    fputs (buff, catfile);
-                    g_free (buff);
-                }
 
-                /* add data to hash table */
-                key = g_try_new0 (guint, 1);
-                *key = catnr;
+    if (!g_file_test (src->file->path, G_FILE_TEST_IS_REGULAR))
+        return;
 
-                /* check if satellite already in hash table */
-                if (g_hash_table_lookup (data, key) == NULL) {
+    if (src->fetched && !applied) {
+        etag = g_key_file_get_string (info, fname, "ETAG", NULL);
+        mtime = g_key_file_get_integer (info, fname, "MTIME", NULL);
+    }
+    else {
+        etag = g_strdup (src->etag);
+        mtime = (gint) src->filetime;
+    }
 
-                    /* create new_tle structure */
-                    ntle = g_try_new (new_tle_t, 1);
-                    ntle->catnum = catnr;
-                    ntle->epoch = tle.epoch;
-                    ntle->satname = g_strdup (g_strchomp(tle_str[0]));
-                    ntle->line1   = g_strdup (tle_str[1]);
-                    ntle->line2   = g_strdup (tle_str[2]);
-                    ntle->srcfile = g_strdup (fnam);
-                    ntle->isnew   = TRUE; /* flag will be reset when using data */
+    if (etag != NULL)
+        g_key_file_set_string (newinfo, fname, "ETAG", etag);
+    if (mtime > 0)
+        g_key_file_set_integer (newinfo, fname, "MTIME", mtime);
 
+    g_free (etag);
+}
 
-                    g_hash_table_insert (data, key, ntle);
-                    retcode++;
-                }
-                else {
-                    g_free (key);
-                }
-            }
 
-        }
+/** \brief Wait until one of the transfers can make progress.
+ *
+ * The wait is limited to 100 ms so that the GUI is kept alive.
+ */
+static void wait_multi (CURLM *multi)
+{
+    fd_set          fdread, fdwrite, fdexcep;
+    struct timeval  tv;
+    long            timeout = -1;
+    int             maxfd = -1;
 
-        if (catsync) {
-            /* close category file */
-            fclose (catfile);
-        }
 
-        g_free (catpath);
+    curl_multi_timeout (multi, &timeout);
+    if ((timeout < 0) || (timeout > 100))
+        timeout = 100;
 
-        /* close input TLE file */
-        fclose (fp);
+    if (timeout == 0)
+        return;
 
-    }
+    FD_ZERO (&fdread);
+    FD_ZERO (&fdwrite);
+    FD_ZERO (&fdexcep);
+    curl_multi_fdset (multi, &fdread, &fdwrite, &fdexcep, &maxfd);
 
-    else {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s:%s: Failed to open %s"),
-                     __FILE__, __FUNCTION__, path);
+    if (maxfd < 0) {
+        /* curl has nothing to wait for yet, e.g. name resolution */
+        g_usleep (timeout * 1000);
+        return;
     }
 
-    g_free (path);
-
-
-    return retcode;
+    tv.tv_sec = 0;
+    tv.tv_usec = timeout * 1000;
+    select (maxfd + 1, &fdread, &fdwrite, &fdexcep, &tv);
 }
 
 
-
-/** \brief Update TLE data in a file.
- *  \param ldname Directory name for gpredict tle files.
- *  \param fname The name of the TLE file.
- *  \param data The hash table containing the fresh data.
- *  \param sat_upd OUT: number of sats updated.
- *  \param sat_ski OUT: number of sats skipped.
- *  \param sat_nod OUT: number of sats for which no data found
- *  \param sat_tot OUT: total number of sats
- *
- * For each satellite in the TLE file ldname/fnam, this function
- * checks whether there is any newer data available in the hash table.
- * If yes, the function writes the fresh data to temp_file, if no, the
- * old data is copied to temp_file.
- * When all sats have been copied ldname/fnam is deleted and temp_file
- * is renamed to ldname/fnam.
+/** \brief Remove files from the cache that are no longer fetched.
+ *  \param cache The cache directory.
+ *  \param files The files that are fetched.
  */
-static void update_tle_in_file (const gchar *ldname,
-                                const gchar *fname,
-                                GHashTable  *data,
-                                guint       *sat_upd,
-                                guint       *sat_ski,
-                                guint       *sat_nod,
-                                guint       *sat_tot)
+static void prune_cache (const gchar *cache, gchar **files)
 {
-    gchar     *path;
-    guint      updated = 0;  /* number of updated sats */
-    guint      nodata  = 0;  /* no sats for which no fresh data available */
-    guint      skipped = 0;  /* no. sats where fresh data is older */
-    guint      total   = 0;  /* total no. of sats in gpredict tle file */
-    gchar    **catstr;
-    guint      catnr;
-    guint     *key = NULL;
-    tle_t      tle;
-    new_tle_t *ntle;
-    GError    *error = NULL;
-    GKeyFile  *satdata;
-    gchar     *tlestr1, *tlestr2, *rawtle;
-    gchar     *cfgstr;
-    GIOChannel *cfgfile;
-    gsize      length, written;
-
-
-    /* open input file (file containing old tle) */
-    path = g_strconcat (ldname, G_DIR_SEPARATOR_S, fname, NULL);
-    satdata = g_key_file_new ();
-    if (!g_key_file_load_from_file (satdata, path, G_KEY_FILE_KEEP_COMMENTS, &error)) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s: Error loading %s (%s)"),
-                     __FUNCTION__, path, error->message);
-        g_clear_error (&error);
-
-        skipped++;
-
-    }
+    GDir        *dir;
+    const gchar *fname;
+    gchar       *locfile;
+    guint        i;
+    gboolean     keep;
 
-    else {
 
-        /* get catalog number for this satellite */
-        catstr = g_strsplit (fname, ".sat", 0);
-        catnr = (guint) g_ascii_strtod (catstr[0], NULL);
+    dir = g_dir_open (cache, 0, NULL);
+    if (dir == NULL)
+        return;
 
-        /* see if we have new data for this satellite */
-        key = g_try_new0 (guint, 1);
-        *key = catnr;
-        ntle = (new_tle_t *) g_hash_table_lookup (data, key);
-        g_free (key);
+    while ((fname = g_dir_read_name (dir)) != NULL) {
 
-        if (ntle == NULL) {
-            /* no new data found for this sat => obsolete */
-            nodata++;
+        keep = !strcmp (fname, TLE_CACHE_INFO);
+        for (i = 0; !keep && (files[i] != NULL); i++)
+            keep = !strcmp (fname, files[i]);
 
-            /* check if obsolete sats should be deleted */
-            /**** FIXME: This is dangereous, so we omit it */
-            sat_log_log (SAT_LOG_LEVEL_ERROR,
-                         _("%s: No new TLE data found for %d. Satellite might be obsolete."),
-                         __FUNCTION__, catnr);
-        }
-        else {
-            /* This satellite is not new */
-            ntle->isnew = FALSE;
-
-            /* get TLE data */
-            tlestr1 = g_key_file_get_string (satdata, "Satellite", "TLE1", NULL);
-            tlestr2 = g_key_file_get_string (satdata, "Satellite", "TLE2", NULL);
-            rawtle = g_strconcat (tlestr1, tlestr2, NULL);
-
-            if (!Good_Elements (rawtle)) {
-                sat_log_log (SAT_LOG_LEVEL_WARN,
-                             _("%s: Current TLE data for %d appears to be bad"),
-                             __FUNCTION__, catnr);
-            }
-            Convert_Satellite_Data (rawtle, &tle);
-
-            g_free (tlestr1);
-            g_free (tlestr2);
-            g_free (rawtle);
-
-            if (tle.epoch < ntle->epoch) {
-                /* new data is newer than what we already have */
-                /* store new data */
-                g_key_file_set_string (satdata, "Satellite", "TLE1", ntle->line1);
-                g_key_file_set_string (satdata, "Satellite", "TLE2", ntle->line2);
-
-                /* convert configuration data struct to charachter string */
-                cfgstr = g_key_file_to_data (satdata, &length, NULL); /* this function never reports error */
-
-                /* create and open a file for writing */
-                cfgfile = g_io_channel_new_file (path, "w", &error);
-
-                if (error != NULL) {
-                    sat_log_log (SAT_LOG_LEVEL_ERROR,
-                                 _("%s: Could not create satellite data file (%s)."),
-                                 __FUNCTION__, error->message);
-                    g_clear_error (&error);
-                    skipped++;
-                }
-                else {
-                    g_io_channel_write_chars (cfgfile, cfgstr, length, &written, &error);
-
-                    g_io_channel_shutdown (cfgfile, TRUE, NULL);
-                    g_io_channel_unref (cfgfile);
-
-                    if (error != NULL) {
-                        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                                     _("%s: Error writing satellite data (%s)."),
-                                     __FUNCTION__, error->message);
-                        g_clear_error (&error);
-                        skipped++;
-                    }
-                    else if (length != written) {
-                        sat_log_log (SAT_LOG_LEVEL_WARN,
-                                     _("%s: Wrote only %d out of %d chars for satellite data."),
-                                     __FUNCTION__, written, length);
-                        skipped++;
-                    }
-                    else {
-                        sat_log_log (SAT_LOG_LEVEL_MSG,
-                                     _("%s: Satellite data written for %d."),
-                                     __FUNCTION__, catnr);
-                        updated++;
-                    }
-                }
-                g_free (cfgstr);
-            }
-            else {
-                skipped++;
-            }
+        if (!keep) {
+            locfile = g_strconcat (cache, G_DIR_SEPARATOR_S, fname, NULL);
+            g_remove (locfile);
+            g_free (locfile);
         }
-        g_strfreev (catstr);
     }
-    g_key_file_free (satdata);
-    g_free (path);
-
-    /* update out parameters */
-    *sat_upd = updated;
-    *sat_ski = skipped;
-    *sat_nod = nodata;
-    *sat_tot = total;
 
+    g_dir_close (dir);
 }
 
 
-
+/** \brief Check whether file is TLE file.
+ *  \param dir The directory.
+ *  \param fnam The file name.
+ * 
+ * This function checks whether the file with path dir/fnam is a potential
+ * TLE file. Checks performed:
+ *   - It is a real file
+ *   - suffix is .txt or .tle
+ */
+static gboolean is_tle_file (const gchar *dir, const gchar *fnam)
+{
+    gchar    *path;
+    gchar    *fname_lower;
+    gboolean  fileIsOk = FALSE;
+    
+    path = g_strconcat (dir, G_DIR_SEPARATOR_S, fnam, NULL);
+    fname_lower=g_ascii_strdown(fnam,-1);
+    
+    if (g_file_test (path, G_FILE_TEST_IS_REGULAR) && 
+        (g_str_has_suffix(fname_lower, ".tle") || g_str_has_suffix(fname_lower, ".txt")))
+    {
+        fileIsOk = TRUE;      
+    }
+    g_free (fname_lower);
+    g_free (path);
+    
+    return fileIsOk;
+}
 
 
 const gchar *freq_to_str[TLE_AUTO_UPDATE_NUM] = {
@@ -56,15 +56,18 @@ typedef enum {
 } tle_auto_upd_action_t;
 
 
-/** \brief Data structure to hold a TLE set. */
+/** \brief Data structure to hold a TLE set.
+ *
+ * The strings are stored inline so that the sets read from a file can be
+ * kept in one array.
+ */
 typedef struct {
-    guint    catnum;  /*!< Catalog number. */
-    gdouble  epoch;   /*!< Epoch. */
-    gchar   *satname; /*!< Satellite name. */
-    gchar   *line1;   /*!< Line 1. */
-    gchar   *line2;   /*!< Line 2. */
-    gchar   *srcfile; /*!< The file where TLE comes from (needed for cat) */
-    gboolean isnew;   /*!< Flag indicating whether sat is new. */
+    tle_t    tle;          /*!< The parsed elements. */
+    gchar    satname[80];  /*!< Satellite name. */
+    gchar    line1[70];    /*!< Line 1. */
+    gchar    line2[70];    /*!< Line 2. */
+    guint    srcfile;      /*!< Index of the file where TLE comes from. */
+    gboolean isnew;        /*!< Flag indicating whether sat is new. */
 } new_tle_t;
 
 